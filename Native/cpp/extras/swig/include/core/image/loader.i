@@ -1,4 +1,7 @@
 %rename(data_impl) bve::core::image::Loader::data() const noexcept;
+%ignore bve::core::image::PixelPipeline::Operation;
+%ignore bve::core::image::PixelPipeline::operations;
+%rename(data_rgba8_impl) bve::core::image::Loader::dataRGBA8() const noexcept;
 
 %include <core/image/loader.hpp>
 
@@ -17,5 +20,18 @@
       }
       return array;
     }
+    public unsafe global::UnityEngine.Color32[] dataRGBA8() {
+      var dim = dimensions();
+      var raw_ptr = global::Native.raw.bytep.get_raw(data_rgba8_impl());
+      var len = dim.x * dim.y;
+      var array = new global::UnityEngine.Color32[len];
+      for (int i = 0; i < len; ++i) {
+        array[i] = new global::UnityEngine.Color32(raw_ptr[4 * i + 0],
+                                                   raw_ptr[4 * i + 1],
+                                                   raw_ptr[4 * i + 2],
+                                                   raw_ptr[4 * i + 3]);
+      }
+      return array;
+    }
   %}
 }
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "core/image/loader.hpp"
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <vector>
+
+namespace bve::core::image {
+	enum class BlockFormat : std::uint8_t {
+		// 8 bytes per 4x4 block, opaque RGB
+		bc1,
+		// 16 bytes per 4x4 block, BC1 color plus interpolated 8 bit alpha
+		bc3,
+	};
+
+	struct CompressedLevel {
+		glm::ivec2 dimensions;
+		// ceil(width / 4) * ceil(height / 4) blocks, row by row
+		std::vector<std::uint8_t> blocks;
+	};
+
+	struct CompressedTexture {
+		BlockFormat format = BlockFormat::bc1;
+		// Largest first, each level half the size of the previous one down to 1x1
+		std::vector<CompressedLevel> levels;
+	};
+
+	// defined in image/block_compression.cpp
+	// Bytes of blocks a level of the given size takes up, what CompressedLevel::blocks must hold
+	std::size_t compressed_level_size(BlockFormat format, glm::ivec2 dimensions);
+
+	// BC1 if every pixel is opaque, BC3 otherwise. Screendoored pixels have zero alpha, so decal transparent textures end up as BC3.
+	BlockFormat choose_block_format(const std::uint8_t* rgba, std::size_t pixel_count);
+
+	/**
+	 * Compress an 8 bit RGBA image, optionally along with a mip chain generated from it with generate_mips. BC3 mips are alpha
+	 * weighted.
+	 *
+	 * Endpoints are fit along the principal axis of each block's colors then refined with a least squares pass, which is close to
+	 * what offline compressors produce for the kind of content routes use, at a fraction of their cost.
+	 *
+	 * \param rgba        width * height pixels, top row first.
+	 * \param dimensions  Size of the image. Doesn't need to be a multiple of 4.
+	 * \param format      Block format to produce.
+	 * \param generate_mips If a full mip chain should be produced, or only the base level.
+	 */
+	CompressedTexture compress_texture(const std::uint8_t* rgba, glm::ivec2 dimensions, BlockFormat format, bool generate_mips = true);
+
+	// Image must be loaded as PixelFormat::rgba8. Picks the format with choose_block_format.
+	CompressedTexture compress_texture(const Loader& image, bool generate_mips = true);
+
+	// Decode a level back to 8 bit RGBA, for platforms without BC support and for testing
+	std::vector<std::uint8_t> decompress_level(BlockFormat format, const CompressedLevel& level);
+} // namespace bve::core::image
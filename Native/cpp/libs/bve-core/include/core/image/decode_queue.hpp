@@ -0,0 +1,117 @@
+#pragma once
+
+#include "core/image/loader.hpp"
+#include "util/thread_pool.hpp"
+#include <cstdint>
+#include <future>
+#include <glm/vec3.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+
+namespace bve::core::image {
+	/**
+	 * A texture to decode. Mirrors parsers::dependencies::Texture so route and object dependencies map onto it directly.
+	 */
+	struct DecodeRequest {
+		std::string file;
+		// applied with Loader::applyScreendoor once decoded
+		glm::u8vec3 decal_transparent_color = {0, 0, 0};
+		bool has_transparent_color = false;
+		PixelFormat format = PixelFormat::rgba32f;
+
+		friend bool operator<(const DecodeRequest& lhs, const DecodeRequest& rhs) {
+			auto const tie = [](const DecodeRequest& request) {
+				return std::tie(request.file, request.decal_transparent_color.x, request.decal_transparent_color.y,
+				                request.decal_transparent_color.z, request.has_transparent_color, request.format);
+			};
+			return tie(lhs) < tie(rhs);
+		}
+	};
+
+	/**
+	 * Decodes textures on a fixed amount of worker threads, most urgent first.
+	 *
+	 * Requests for the same texture share one decode: asking again while it's queued or running returns the same future, and asking
+	 * after it finished returns the same Loader for as long as someone still holds on to it.
+	 *
+	 * Priorities are picked when a worker becomes free, not when the request is made, so a texture requested late with a low priority
+	 * value still overtakes everything waiting.
+	 */
+	class DecodeQueue {
+	  public:
+		// Check Loader::valid, a file that couldn't be decoded still produces a Loader
+		using Result = std::shared_ptr<Loader const>;
+
+		/**
+		 * \param thread_count Amount of decoding threads. 0 uses one per hardware thread.
+		 */
+		explicit DecodeQueue(std::size_t thread_count = 0);
+
+		/**
+		 * Waits for the decodes already running. Requests that haven't started are dropped and their futures report
+		 * std::future_errc::broken_promise.
+		 */
+		~DecodeQueue();
+
+		DecodeQueue(DecodeQueue const&) = delete;
+		DecodeQueue(DecodeQueue&&) = delete;
+		DecodeQueue& operator=(DecodeQueue const&) = delete;
+		DecodeQueue& operator=(DecodeQueue&&) = delete;
+
+		/**
+		 * Queue a texture for decoding.
+		 *
+		 * \param texture  Texture to decode.
+		 * \param priority Lower values are decoded first, for example distance from the start position. Requesting a queued texture
+		 *                 again with a lower value moves it forward.
+		 * \return Future holding the decoded texture. Exceptions thrown while decoding end up in the future.
+		 */
+		std::shared_future<Result> request(DecodeRequest const& texture, float priority = 0);
+
+		/**
+		 * Block until every request made so far is done.
+		 */
+		void wait();
+
+		// Requests not picked up by a worker yet
+		std::size_t queued() const;
+
+		// Textures being tracked: queued, decoding, or finished and still held by someone. Finished textures nobody holds anymore
+		// are dropped from time to time as new ones are requested.
+		std::size_t tracked() const;
+
+	  private:
+		struct Job {
+			DecodeRequest texture;
+			std::promise<Result> promise;
+			// position in queue_
+			std::pair<float, std::uint64_t> order;
+		};
+
+		struct Entry {
+			// set while the decode is queued or running
+			std::shared_ptr<Job> job;
+			std::shared_future<Result> future;
+			// set once it's done
+			std::weak_ptr<Loader const> result;
+		};
+
+		void decodeNext();
+		// Drop entries that are done and no longer held. Requires mutex_.
+		void pruneExpired();
+
+		mutable std::mutex mutex_;
+		std::map<DecodeRequest, Entry> entries_;
+		std::map<std::pair<float, std::uint64_t>, std::shared_ptr<Job>> queue_;
+		std::uint64_t next_sequence_ = 0;
+		// entries_ is pruned when it reaches this size, then it's set to twice what's left so pruning stays amortized O(1)
+		std::size_t prune_threshold_;
+		bool stopping_ = false;
+
+		// last so it's joined before anything its tasks use goes away
+		util::ThreadPool pool_;
+	};
+} // namespace bve::core::image
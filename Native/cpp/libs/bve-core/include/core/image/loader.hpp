@@ -1,18 +1,100 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <glm/vec2.hpp>
 #include <string>
+#include <vector>
+
+namespace bve::util {
+	class Allocator;
+} // namespace bve::util
 
 namespace bve::core::image {
+	/**
+	 * How the loader keeps the decoded pixels. Both are four interleaved RGBA channels.
+	 */
+	enum class PixelFormat {
+		// Linear float per channel, converted from LDR sources with stb's gamma curve. 16 bytes per pixel.
+		rgba32f,
+		// The source's 8 bit channels untouched. 4 bytes per pixel and no per channel pow on load.
+		rgba8,
+	};
+
+	constexpr std::size_t bytes_per_pixel(PixelFormat const format) noexcept {
+		return format == PixelFormat::rgba32f ? 4 * sizeof(float) : 4;
+	}
+
+	/**
+	 * Sequence of per pixel operations for Loader to apply in a single pass, instead of walking the whole image once per operation.
+	 * Each operation does the same as the Loader method of the same name.
+	 */
+	class PixelPipeline {
+	  public:
+		struct Operation {
+			enum class Type : std::uint8_t { screendoor, multiply };
+
+			Type type;
+			std::array<std::uint8_t, 4> color;
+		};
+
+		PixelPipeline& screendoor(std::uint8_t r, std::uint8_t g, std::uint8_t b) {
+			operations_.emplace_back(Operation{Operation::Type::screendoor, {r, g, b, 0}});
+			return *this;
+		}
+
+		PixelPipeline& multiply(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a) {
+			operations_.emplace_back(Operation{Operation::Type::multiply, {r, g, b, a}});
+			return *this;
+		}
+
+		const std::vector<Operation>& operations() const noexcept {
+			return operations_;
+		}
+
+	  private:
+		std::vector<Operation> operations_;
+	};
+
+	/**
+	 * Caller owned memory to decode into, such as a staging buffer or a slice of a pool.
+	 */
+	struct DecodeTarget {
+		// First byte of the top row
+		void* pixels = nullptr;
+		// Bytes from the start of one row to the start of the next, at least dimensions.x * bytes_per_pixel(format)
+		std::size_t row_pitch = 0;
+		// Size the memory was made for, usually found with probe_image. Images of any other size are rejected.
+		glm::ivec2 dimensions{};
+		PixelFormat format = PixelFormat::rgba8;
+	};
+
 	class Loader {
 	  public:
-		explicit Loader(std::string filename);
+		explicit Loader(std::string filename, PixelFormat format = PixelFormat::rgba32f);
+		/**
+		 * Decode as 8 bit and run the pipeline while converting to the requested format, a few hundred pixels at a time so they stay in
+		 * cache between operations. The result is identical to loading then calling each operation in turn, without the pow per channel
+		 * stb's float loading does and without a pass over the whole image per operation.
+		 */
+		Loader(std::string filename, const PixelPipeline& pipeline, PixelFormat format = PixelFormat::rgba32f);
+		Loader(Loader const&) = delete;
+		Loader& operator=(Loader const&) = delete;
 		glm::ivec2 dimensions() const noexcept;
+		PixelFormat pixelFormat() const noexcept;
+		// nullptr unless loaded as rgba32f
 		const float* data() const noexcept;
+		// nullptr unless loaded as rgba8
+		const std::uint8_t* dataRGBA8() const noexcept;
 		void applyScreendoor(std::uint8_t r, std::uint8_t g, std::uint8_t b);
+		// rgba32f only
 		void applyScreendoor(float r, float g, float b);
 		void multiply(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a);
+		// rgba32f only
 		void multiply(float r, float g, float b, float a);
+		// Apply every operation of the pipeline in a single pass
+		void apply(const PixelPipeline& pipeline);
 		bool valid() const noexcept;
 		~Loader();
 
@@ -20,6 +102,29 @@ namespace bve::core::image {
 
 	  private:
 		glm::ivec2 dimensions_;
-		float* data_;
+		PixelFormat format_;
+		float* data_ = nullptr;
+		std::uint8_t* data_rgba8_ = nullptr;
 	};
+
+	// defined in image/loader.cpp
+	/**
+	 * Decode an image straight into caller owned memory, running the pipeline on the way, with no Loader in between. Pixels are the
+	 * same as Loader(filename, pipeline, target.format) produces.
+	 *
+	 * stb still decodes into a buffer of its own first. With scratch set, that and every other allocation stb makes during the decode
+	 * come from it instead of malloc, so a batch of decodes can run out of a linear allocator that is reset afterwards. It must be able
+	 * to hand out the whole decoded image in one allocation.
+	 *
+	 * \param filename Image to decode.
+	 * \param target   Where the pixels go. Throws std::invalid_argument if it has no memory or its rows are too short.
+	 * \param pipeline Operations applied while converting.
+	 * \param scratch  Allocator for stb's temporary memory, nullptr for malloc.
+	 * \return         If the image was decoded. False if it can't be read or isn't the size of the target, in which case the target
+	 *                 is left untouched.
+	 */
+	bool decode_into(const std::string& filename,
+	                 const DecodeTarget& target,
+	                 const PixelPipeline& pipeline = {},
+	                 util::Allocator* scratch = nullptr);
 } // namespace bve::core::image
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "util/thread_pool.hpp"
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <vector>
+
+namespace bve::core::image {
+	template <class T>
+	struct MipLevel {
+		glm::ivec2 dimensions;
+		// dimensions.x * dimensions.y RGBA pixels, top row first
+		std::vector<T> pixels;
+	};
+
+	struct MipOptions {
+		// Weigh each pixel's color by its alpha, so fully transparent pixels don't contribute their color. Needed for screendoored
+		// textures, where the transparent color would otherwise bleed into the edges of the visible parts as the texture shrinks.
+		bool alpha_weighted = false;
+		// When set, rows of each level are filtered on this pool
+		util::ThreadPool* pool = nullptr;
+	};
+
+	// defined in image/mipmaps.cpp
+	/**
+	 * Build the mip chain below a float RGBA image, as produced by Loader with PixelFormat::rgba32f. Those values are already linear,
+	 * so the 2x2 box filter averages them as they are.
+	 *
+	 * \return Every level after the base, each half the size of the previous one rounded down, down to 1x1. An odd dimension drops its
+	 *         last row/column, a dimension of 1 uses its only row/column twice.
+	 */
+	std::vector<MipLevel<float>> generate_mips(const float* rgba, glm::ivec2 dimensions, const MipOptions& options = {});
+
+	/**
+	 * Build the mip chain below an 8 bit RGBA image. Color is converted to linear with the same curve Loader uses for rgba32f before
+	 * filtering and back afterwards, so the levels don't darken the way averaging the gamma encoded bytes does. Alpha is linear.
+	 */
+	std::vector<MipLevel<std::uint8_t>> generate_mips(const std::uint8_t* rgba, glm::ivec2 dimensions, const MipOptions& options = {});
+} // namespace bve::core::image
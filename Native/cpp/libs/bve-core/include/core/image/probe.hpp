@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <string>
+
+namespace bve::core::image {
+	enum class FileFormat : std::uint8_t {
+		// Couldn't be opened or isn't an image stb can decode
+		unknown,
+		bmp,
+		png,
+		// Anything else stb recognizes, such as JPEG, TGA or GIF
+		other,
+	};
+
+	struct ImageInfo {
+		FileFormat format = FileFormat::unknown;
+		glm::ivec2 dimensions{};
+		// Channels stored in the file, including alpha from a PNG transparency chunk. Loader always produces four.
+		int channels = 0;
+		// Bits per channel stb decodes to: 8, 16 for 16 bit PNGs and 32 for HDR files
+		int bit_depth = 0;
+
+		bool valid() const noexcept {
+			return format != FileFormat::unknown;
+		}
+	};
+
+	// defined in image/probe.cpp
+	/**
+	 * Read the size and layout of an image without decoding it. BMP and PNG, which make up nearly all route textures, are read
+	 * straight from their headers, everything else goes through stbi_info. Only a few hundred bytes of the file are touched, so this
+	 * is cheap enough to run over every texture of a route up front for scheduling, atlas packing and memory budgets.
+	 *
+	 * \return Invalid ImageInfo if the file can't be read or isn't an image.
+	 */
+	ImageInfo probe_image(const std::string& filename);
+} // namespace bve::core::image
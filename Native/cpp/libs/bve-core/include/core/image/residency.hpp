@@ -0,0 +1,136 @@
+#pragma once
+
+#include "core/image/block_compression.hpp"
+#include "core/image/loader.hpp"
+#include "util/string_interner.hpp"
+#include <array>
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <vector>
+
+namespace bve::core::image {
+	// defined in image/residency.cpp
+	/**
+	 * Bytes taken by each level of a texture, largest first, following the same halving as generate_mips.
+	 *
+	 * \param dimensions Size of the base level.
+	 * \param format     Format the pixels are kept in.
+	 * \param mips       If the whole chain is counted, or only the base level.
+	 */
+	std::vector<std::size_t> mip_level_sizes(glm::ivec2 dimensions, PixelFormat format, bool mips = true);
+	// Block compressed levels round up to whole 4x4 blocks
+	std::vector<std::size_t> mip_level_sizes(glm::ivec2 dimensions, BlockFormat format, bool mips = true);
+
+	enum class Memory : std::uint8_t { cpu, gpu };
+
+	enum class EvictionPolicy : std::uint8_t {
+		least_recently_used,
+		// Distance from the camera to the position the texture was registered with
+		farthest_from_camera,
+	};
+
+	struct ResidencyBudget {
+		std::size_t cpu_bytes = std::size_t(512) << 20u;
+		std::size_t gpu_bytes = std::size_t(1024) << 20u;
+	};
+
+	struct ResidencyStats {
+		// touch calls on resident textures
+		std::uint64_t hits = 0;
+		// touch calls on textures that weren't
+		std::uint64_t misses = 0;
+		std::uint64_t evictions = 0;
+		std::size_t resident_bytes = 0;
+		std::size_t resident_textures = 0;
+	};
+
+	/**
+	 * Decides which textures stay loaded, in CPU memory and on the GPU separately, so texture memory stays within a budget however long
+	 * the route. It does no loading itself: the caller asks if a texture is resident with touch, loads it on a miss, reports it with
+	 * makeResident, and frees whatever comes back as evicted.
+	 *
+	 * Textures are keyed by their interned file name, so state is kept in a plain array indexed by ID.
+	 *
+	 * Textures used during the current frame are never evicted, so when a single frame needs more than the budget it is exceeded
+	 * rather than thrashing. Not thread safe.
+	 */
+	class ResidencyManager {
+	  public:
+		using TextureID = util::StringInterner::ID;
+
+		explicit ResidencyManager(ResidencyBudget budget = {}, EvictionPolicy policy = EvictionPolicy::least_recently_used);
+
+		/**
+		 * Describe a texture before it's made resident. Registering again replaces the sizes and position but keeps its residency.
+		 *
+		 * \param id          Interned file name.
+		 * \param level_sizes Bytes of each mip level, largest first, as from mip_level_sizes.
+		 * \param position    Where the texture is used, for EvictionPolicy::farthest_from_camera.
+		 */
+		void registerTexture(TextureID id, std::vector<std::size_t> level_sizes, glm::vec3 position = {});
+
+		/**
+		 * Note a use of the texture this frame.
+		 *
+		 * \return If it's resident. Counted as a hit or a miss.
+		 */
+		bool touch(TextureID id, Memory memory);
+
+		/**
+		 * Record that the texture has been loaded, from first_level down to the smallest level, then evict other textures until the
+		 * memory is back within budget.
+		 *
+		 * \param first_level Largest level loaded, for textures streamed without their top levels.
+		 * \return            Textures that were evicted, which the caller must now free. Throws std::out_of_range if the texture
+		 *                    wasn't registered.
+		 */
+		std::vector<TextureID> makeResident(TextureID id, Memory memory, std::size_t first_level = 0);
+
+		// The caller freed the texture on its own. Doesn't count as an eviction.
+		void release(TextureID id, Memory memory);
+
+		bool resident(TextureID id, Memory memory) const noexcept;
+
+		// Start a new frame, making everything used so far evictable
+		void beginFrame() noexcept;
+
+		void setCameraPosition(glm::vec3 position) noexcept;
+
+		// Evicts straight away if the new budget is smaller than what's resident
+		std::vector<TextureID> setBudget(Memory memory, std::size_t bytes);
+
+		ResidencyStats const& stats(Memory memory) const noexcept;
+
+		// Resets hits, misses and evictions, leaving the resident amounts
+		void resetCounters() noexcept;
+
+	  private:
+		struct Residence {
+			bool resident = false;
+			std::size_t bytes = 0;
+			// value of use_counter_ on the last touch
+			std::uint64_t last_use = 0;
+			std::uint64_t last_frame = 0;
+		};
+
+		struct Texture {
+			bool registered = false;
+			std::vector<std::size_t> level_sizes;
+			glm::vec3 position{};
+			std::array<Residence, 2> residence;
+		};
+
+		std::vector<TextureID> evict(Memory memory, TextureID keep);
+		void use(Residence& residence) noexcept;
+
+		std::vector<Texture> textures_;
+		std::array<std::size_t, 2> budget_;
+		std::array<ResidencyStats, 2> stats_;
+		EvictionPolicy policy_;
+		glm::vec3 camera_position_{};
+		std::uint64_t use_counter_ = 0;
+		// starts at 1 so textures that have never been used aren't part of the current frame
+		std::uint64_t frame_ = 1;
+	};
+} // namespace bve::core::image
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "core/image/block_compression.hpp"
+#include "core/image/decode_queue.hpp"
+#include <cstdint>
+#include <string>
+
+namespace bve::core::image {
+	// defined in image/texture_cache.cpp
+	// Cache entries are keyed by a hash of the source file's bytes, the screendoor color and the encoder settings, so the same texture
+	// shared by several routes is only ever compressed once and an encoder change never picks up stale data.
+	std::uint64_t texture_cache_key(const char* file_contents, std::size_t size, const DecodeRequest& texture, bool generate_mips);
+	std::string texture_cache_filename(const std::string& cache_directory, std::uint64_t key);
+
+	bool save_texture_cache(const std::string& cache_filename, std::uint64_t key, const CompressedTexture& texture);
+	// Leaves texture untouched and returns false on a miss or a corrupted entry. A texture it returns always has block data that
+	// matches its format and dimensions.
+	bool load_texture_cache(const std::string& cache_filename, std::uint64_t key, CompressedTexture& texture);
+
+	// Load the compressed texture from cache_directory if present, otherwise decode, screendoor and compress it and add it to the cache.
+	// cache_directory must exist. Throws std::runtime_error when the texture can't be read or decoded. DecodeRequest::format is ignored,
+	// compression always works from 8 bit pixels.
+	CompressedTexture compress_cached(const std::string& cache_directory, const DecodeRequest& texture, bool generate_mips = true);
+} // namespace bve::core::image
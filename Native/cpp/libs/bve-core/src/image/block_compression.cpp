@@ -0,0 +1,419 @@
+#include "core/image/block_compression.hpp"
+#include "core/image/mipmaps.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/geometric.hpp>
+#include <glm/vec3.hpp>
+#include <stdexcept>
+
+namespace bve::core::image {
+	namespace {
+		using BlockPixels = std::array<std::uint8_t, 16 * 4>;
+
+		glm::ivec2 block_count(glm::ivec2 const dimensions) {
+			return (dimensions + 3) / 4;
+		}
+
+		std::size_t block_size(BlockFormat const format) {
+			return format == BlockFormat::bc1 ? 8 : 16;
+		}
+
+		// Pixels past the edge of the image repeat the last row/column, so they don't pull the endpoints anywhere new
+		BlockPixels fetch_block(const std::uint8_t* const rgba, glm::ivec2 const dimensions, int const block_x, int const block_y) {
+			BlockPixels block{};
+			for (int y = 0; y < 4; ++y) {
+				int const source_y = std::min(block_y * 4 + y, dimensions.y - 1);
+				for (int x = 0; x < 4; ++x) {
+					int const source_x = std::min(block_x * 4 + x, dimensions.x - 1);
+					auto const* source = &rgba[4 * (std::size_t(source_y) * std::size_t(dimensions.x) + std::size_t(source_x))];
+					std::copy(source, source + 4, &block[4 * std::size_t(y * 4 + x)]);
+				}
+			}
+			return block;
+		}
+
+		///////////
+		// Color //
+		///////////
+
+		std::uint16_t to_565(glm::vec3 const& color) {
+			auto const quantize = [](float const value, float const max) {
+				return static_cast<std::uint16_t>(std::lround(std::clamp(value, 0.0F, 255.0F) * max / 255.0F));
+			};
+			return static_cast<std::uint16_t>(quantize(color.x, 31) << 11u | quantize(color.y, 63) << 5u | quantize(color.z, 31));
+		}
+
+		glm::ivec3 from_565(std::uint16_t const color) {
+			int const r = (color >> 11u) & 0x1F;
+			int const g = (color >> 5u) & 0x3F;
+			int const b = color & 0x1F;
+			return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+		}
+
+		std::array<glm::ivec3, 4> four_color_palette(std::uint16_t const color0, std::uint16_t const color1) {
+			auto const c0 = from_565(color0);
+			auto const c1 = from_565(color1);
+			return {c0, c1, (2 * c0 + c1) / 3, (c0 + 2 * c1) / 3};
+		}
+
+		std::array<glm::ivec3, 4> color_palette(std::uint16_t const color0, std::uint16_t const color1) {
+			if (color0 > color1) {
+				return four_color_palette(color0, color1);
+			}
+			auto const c0 = from_565(color0);
+			auto const c1 = from_565(color1);
+			// three color mode, the last entry is transparent black
+			return {c0, c1, (c0 + c1) / 2, glm::ivec3(0)};
+		}
+
+		int distance_squared(glm::ivec3 const& lhs, glm::ivec3 const& rhs) {
+			auto const difference = lhs - rhs;
+			return difference.x * difference.x + difference.y * difference.y + difference.z * difference.z;
+		}
+
+		std::uint32_t color_indices(BlockPixels const& block, std::array<glm::ivec3, 4> const& palette) {
+			std::uint32_t indices = 0;
+			for (std::size_t i = 0; i < 16; ++i) {
+				glm::ivec3 const pixel(block[4 * i + 0], block[4 * i + 1], block[4 * i + 2]);
+				std::uint32_t best = 0;
+				int best_distance = distance_squared(pixel, palette[0]);
+				for (std::uint32_t j = 1; j < 4; ++j) {
+					int const distance = distance_squared(pixel, palette[j]);
+					if (distance < best_distance) {
+						best = j;
+						best_distance = distance;
+					}
+				}
+				indices |= best << (2 * i);
+			}
+			return indices;
+		}
+
+		glm::vec3 principal_axis(BlockPixels const& block, glm::vec3 const& mean) {
+			std::array<float, 6> covariance{};
+			glm::vec3 minimum(255.0F);
+			glm::vec3 maximum(0.0F);
+			for (std::size_t i = 0; i < 16; ++i) {
+				glm::vec3 const pixel(block[4 * i + 0], block[4 * i + 1], block[4 * i + 2]);
+				auto const d = pixel - mean;
+				covariance[0] += d.x * d.x;
+				covariance[1] += d.x * d.y;
+				covariance[2] += d.x * d.z;
+				covariance[3] += d.y * d.y;
+				covariance[4] += d.y * d.z;
+				covariance[5] += d.z * d.z;
+				minimum = glm::min(minimum, pixel);
+				maximum = glm::max(maximum, pixel);
+			}
+
+			// power iteration, starting from the bounding box diagonal as that's usually close already
+			glm::vec3 axis = maximum - minimum;
+			for (int iteration = 0; iteration < 8; ++iteration) {
+				glm::vec3 const next(axis.x * covariance[0] + axis.y * covariance[1] + axis.z * covariance[2],
+				                     axis.x * covariance[1] + axis.y * covariance[3] + axis.z * covariance[4],
+				                     axis.x * covariance[2] + axis.y * covariance[4] + axis.z * covariance[5]);
+				float const length = glm::length(next);
+				if (length < 1e-6F) {
+					break;
+				}
+				axis = next / length;
+			}
+			return axis;
+		}
+
+		// Least squares endpoints for the given assignment, false if the assignment doesn't constrain both of them
+		bool refine_endpoints(BlockPixels const& block, std::uint32_t const indices, glm::vec3& endpoint0, glm::vec3& endpoint1) {
+			// weight of endpoint 0 for each palette entry
+			constexpr std::array<float, 4> weights = {1.0F, 0.0F, 2.0F / 3.0F, 1.0F / 3.0F};
+
+			float aa = 0;
+			float ab = 0;
+			float bb = 0;
+			glm::vec3 ax(0);
+			glm::vec3 bx(0);
+			for (std::size_t i = 0; i < 16; ++i) {
+				float const a = weights[(indices >> (2 * i)) & 3u];
+				float const b = 1.0F - a;
+				glm::vec3 const pixel(block[4 * i + 0], block[4 * i + 1], block[4 * i + 2]);
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				ax += a * pixel;
+				bx += b * pixel;
+			}
+
+			float const determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6F) {
+				return false;
+			}
+			endpoint0 = (ax * bb - bx * ab) / determinant;
+			endpoint1 = (bx * aa - ax * ab) / determinant;
+			return true;
+		}
+
+		std::uint32_t color_error(BlockPixels const& block, std::array<glm::ivec3, 4> const& palette, std::uint32_t const indices) {
+			std::uint32_t error = 0;
+			for (std::size_t i = 0; i < 16; ++i) {
+				glm::ivec3 const pixel(block[4 * i + 0], block[4 * i + 1], block[4 * i + 2]);
+				error += static_cast<std::uint32_t>(distance_squared(pixel, palette[(indices >> (2 * i)) & 3u]));
+			}
+			return error;
+		}
+
+		void write_color_block(std::uint8_t* const output, std::uint16_t color0, std::uint16_t color1, std::uint32_t indices) {
+			if (color0 < color1) {
+				// four color mode needs color0 > color1, swapping the endpoints swaps index 0 with 1 and 2 with 3
+				std::swap(color0, color1);
+				indices ^= 0x55555555u;
+			}
+			else if (color0 == color1) {
+				indices = 0;
+			}
+
+			output[0] = static_cast<std::uint8_t>(color0);
+			output[1] = static_cast<std::uint8_t>(color0 >> 8u);
+			output[2] = static_cast<std::uint8_t>(color1);
+			output[3] = static_cast<std::uint8_t>(color1 >> 8u);
+			for (std::size_t i = 0; i < 4; ++i) {
+				output[4 + i] = static_cast<std::uint8_t>(indices >> (8 * i));
+			}
+		}
+
+		void encode_color_block(BlockPixels const& block, std::uint8_t* const output) {
+			glm::vec3 mean(0);
+			for (std::size_t i = 0; i < 16; ++i) {
+				mean += glm::vec3(block[4 * i + 0], block[4 * i + 1], block[4 * i + 2]);
+			}
+			mean /= 16.0F;
+
+			auto const axis = principal_axis(block, mean);
+			float minimum = 0;
+			float maximum = 0;
+			for (std::size_t i = 0; i < 16; ++i) {
+				float const t = glm::dot(glm::vec3(block[4 * i + 0], block[4 * i + 1], block[4 * i + 2]) - mean, axis);
+				minimum = std::min(minimum, t);
+				maximum = std::max(maximum, t);
+			}
+
+			// indices are picked as if the endpoints are in four color order, write_color_block fixes up the order afterwards
+			auto const fit = [&](glm::vec3 const& endpoint0, glm::vec3 const& endpoint1, std::uint16_t& color0, std::uint16_t& color1) {
+				color0 = to_565(endpoint0);
+				color1 = to_565(endpoint1);
+				auto const palette = four_color_palette(color0, color1);
+				auto const indices = color_indices(block, palette);
+				return std::make_pair(indices, color_error(block, palette, indices));
+			};
+
+			std::uint16_t color0;
+			std::uint16_t color1;
+			auto best = fit(mean + axis * maximum, mean + axis * minimum, color0, color1);
+
+			glm::vec3 refined0;
+			glm::vec3 refined1;
+			if (best.second != 0 && refine_endpoints(block, best.first, refined0, refined1)) {
+				std::uint16_t refined_color0;
+				std::uint16_t refined_color1;
+				auto const refined = fit(refined0, refined1, refined_color0, refined_color1);
+				if (refined.second < best.second) {
+					best = refined;
+					color0 = refined_color0;
+					color1 = refined_color1;
+				}
+			}
+
+			write_color_block(output, color0, color1, best.first);
+		}
+
+		///////////
+		// Alpha //
+		///////////
+
+		std::array<int, 8> alpha_palette(int const alpha0, int const alpha1) {
+			if (alpha0 > alpha1) {
+				return {alpha0,
+				        alpha1,
+				        (6 * alpha0 + 1 * alpha1) / 7,
+				        (5 * alpha0 + 2 * alpha1) / 7,
+				        (4 * alpha0 + 3 * alpha1) / 7,
+				        (3 * alpha0 + 4 * alpha1) / 7,
+				        (2 * alpha0 + 5 * alpha1) / 7,
+				        (1 * alpha0 + 6 * alpha1) / 7};
+			}
+			return {alpha0,
+			        alpha1,
+			        (4 * alpha0 + 1 * alpha1) / 5,
+			        (3 * alpha0 + 2 * alpha1) / 5,
+			        (2 * alpha0 + 3 * alpha1) / 5,
+			        (1 * alpha0 + 4 * alpha1) / 5,
+			        0,
+			        255};
+		}
+
+		void encode_alpha_block(BlockPixels const& block, std::uint8_t* const output) {
+			int maximum = 0;
+			int minimum = 255;
+			for (std::size_t i = 0; i < 16; ++i) {
+				maximum = std::max<int>(maximum, block[4 * i + 3]);
+				minimum = std::min<int>(minimum, block[4 * i + 3]);
+			}
+
+			output[0] = static_cast<std::uint8_t>(maximum);
+			output[1] = static_cast<std::uint8_t>(minimum);
+
+			std::uint64_t indices = 0;
+			if (maximum != minimum) {
+				auto const palette = alpha_palette(maximum, minimum);
+				for (std::size_t i = 0; i < 16; ++i) {
+					int const alpha = block[4 * i + 3];
+					std::uint64_t best = 0;
+					int best_distance = std::abs(alpha - palette[0]);
+					for (std::uint64_t j = 1; j < 8; ++j) {
+						int const distance = std::abs(alpha - palette[j]);
+						if (distance < best_distance) {
+							best = j;
+							best_distance = distance;
+						}
+					}
+					indices |= best << (3 * i);
+				}
+			}
+
+			for (std::size_t i = 0; i < 6; ++i) {
+				output[2 + i] = static_cast<std::uint8_t>(indices >> (8 * i));
+			}
+		}
+
+		CompressedLevel compress_level(const std::uint8_t* const rgba, glm::ivec2 const dimensions, BlockFormat const format) {
+			auto const blocks = block_count(dimensions);
+
+			CompressedLevel level;
+			level.dimensions = dimensions;
+			level.blocks.resize(compressed_level_size(format, dimensions));
+
+			auto* output = level.blocks.data();
+			for (int y = 0; y < blocks.y; ++y) {
+				for (int x = 0; x < blocks.x; ++x) {
+					auto const block = fetch_block(rgba, dimensions, x, y);
+					if (format == BlockFormat::bc3) {
+						encode_alpha_block(block, output);
+						output += 8;
+					}
+					encode_color_block(block, output);
+					output += 8;
+				}
+			}
+
+			return level;
+		}
+	} // namespace
+
+	std::size_t compressed_level_size(BlockFormat const format, glm::ivec2 const dimensions) {
+		// in size_t, so the rounding up can't overflow for huge dimensions
+		auto const blocks_x = (std::size_t(dimensions.x) + 3) / 4;
+		auto const blocks_y = (std::size_t(dimensions.y) + 3) / 4;
+		return blocks_x * blocks_y * block_size(format);
+	}
+
+	BlockFormat choose_block_format(const std::uint8_t* const rgba, std::size_t const pixel_count) {
+		for (std::size_t i = 0; i < pixel_count; ++i) {
+			if (rgba[4 * i + 3] != 255) {
+				return BlockFormat::bc3;
+			}
+		}
+		return BlockFormat::bc1;
+	}
+
+	CompressedTexture compress_texture(const std::uint8_t* const rgba,
+	                                   glm::ivec2 const dimensions,
+	                                   BlockFormat const format,
+	                                   bool const generate_mips) {
+		if (dimensions.x <= 0 || dimensions.y <= 0) {
+			throw std::invalid_argument("Can't compress an empty image");
+		}
+
+		CompressedTexture texture;
+		texture.format = format;
+		texture.levels.emplace_back(compress_level(rgba, dimensions, format));
+
+		if (!generate_mips) {
+			return texture;
+		}
+
+		// weighing by alpha keeps screendoored pixels from bleeding their color into the visible ones
+		MipOptions options;
+		options.alpha_weighted = format == BlockFormat::bc3;
+		for (auto const& level : image::generate_mips(rgba, dimensions, options)) {
+			texture.levels.emplace_back(compress_level(level.pixels.data(), level.dimensions, format));
+		}
+
+		return texture;
+	}
+
+	CompressedTexture compress_texture(const Loader& image, bool const generate_mips) {
+		if (!image.valid() || image.pixelFormat() != PixelFormat::rgba8) {
+			throw std::invalid_argument("Block compression needs a valid rgba8 image");
+		}
+
+		auto const dimensions = image.dimensions();
+		auto const format = choose_block_format(image.dataRGBA8(), std::size_t(dimensions.x) * std::size_t(dimensions.y));
+		return compress_texture(image.dataRGBA8(), dimensions, format, generate_mips);
+	}
+
+	std::vector<std::uint8_t> decompress_level(BlockFormat const format, const CompressedLevel& level) {
+		auto const& dimensions = level.dimensions;
+		auto const blocks = block_count(dimensions);
+		if (level.blocks.size() != compressed_level_size(format, dimensions)) {
+			throw std::invalid_argument("Level has the wrong amount of blocks for its size");
+		}
+
+		std::vector<std::uint8_t> rgba(std::size_t(dimensions.x) * std::size_t(dimensions.y) * 4);
+
+		auto const* input = level.blocks.data();
+		for (int block_y = 0; block_y < blocks.y; ++block_y) {
+			for (int block_x = 0; block_x < blocks.x; ++block_x) {
+				std::array<int, 16> alphas;
+				alphas.fill(255);
+				if (format == BlockFormat::bc3) {
+					auto const palette = alpha_palette(input[0], input[1]);
+					std::uint64_t indices = 0;
+					for (std::size_t i = 0; i < 6; ++i) {
+						indices |= std::uint64_t(input[2 + i]) << (8 * i);
+					}
+					for (std::size_t i = 0; i < 16; ++i) {
+						alphas[i] = palette[(indices >> (3 * i)) & 7u];
+					}
+					input += 8;
+				}
+
+				auto const color0 = static_cast<std::uint16_t>(input[0] | input[1] << 8u);
+				auto const color1 = static_cast<std::uint16_t>(input[2] | input[3] << 8u);
+				// BC3 always uses four colors
+				auto const palette = format == BlockFormat::bc3 ? four_color_palette(color0, color1) : color_palette(color0, color1);
+				auto const indices = std::uint32_t(input[4]) | std::uint32_t(input[5]) << 8u | std::uint32_t(input[6]) << 16u
+				                     | std::uint32_t(input[7]) << 24u;
+				input += 8;
+
+				for (int y = 0; y < 4; ++y) {
+					for (int x = 0; x < 4; ++x) {
+						int const pixel_x = block_x * 4 + x;
+						int const pixel_y = block_y * 4 + y;
+						if (pixel_x >= dimensions.x || pixel_y >= dimensions.y) {
+							continue;
+						}
+						auto const i = std::size_t(y * 4 + x);
+						auto const index = (indices >> (2 * i)) & 3u;
+						auto* output = &rgba[4 * (std::size_t(pixel_y) * std::size_t(dimensions.x) + std::size_t(pixel_x))];
+						output[0] = static_cast<std::uint8_t>(palette[index].x);
+						output[1] = static_cast<std::uint8_t>(palette[index].y);
+						output[2] = static_cast<std::uint8_t>(palette[index].z);
+						bool const transparent_black = format == BlockFormat::bc1 && color0 <= color1 && index == 3;
+						output[3] = static_cast<std::uint8_t>(transparent_black ? 0 : alphas[i]);
+					}
+				}
+			}
+		}
+
+		return rgba;
+	}
+} // namespace bve::core::image
@@ -0,0 +1,122 @@
+#include "core/image/decode_queue.hpp"
+#include <algorithm>
+
+namespace bve::core::image {
+	namespace {
+		constexpr std::size_t min_prune_threshold = 64;
+	} // namespace
+
+	DecodeQueue::DecodeQueue(std::size_t const thread_count) : prune_threshold_(min_prune_threshold), pool_(thread_count) {}
+
+	DecodeQueue::~DecodeQueue() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopping_ = true;
+		// Dropping the jobs breaks their promises. The pool's tasks find nothing left to do and its destructor only waits for the
+		// decodes that are already running.
+		queue_.clear();
+		entries_.clear();
+	}
+
+	std::shared_future<DecodeQueue::Result> DecodeQueue::request(DecodeRequest const& texture, float const priority) {
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		if (entries_.size() >= prune_threshold_) {
+			pruneExpired();
+		}
+
+		auto& entry = entries_[texture];
+
+		if (entry.job) {
+			// still queued, move it forward if this is more urgent
+			auto const queued = queue_.find(entry.job->order);
+			if (queued != queue_.end() && priority < entry.job->order.first) {
+				queue_.erase(queued);
+				entry.job->order = {priority, next_sequence_++};
+				queue_.emplace(entry.job->order, entry.job);
+			}
+			return entry.future;
+		}
+
+		if (auto result = entry.result.lock()) {
+			std::promise<Result> done;
+			done.set_value(std::move(result));
+			return done.get_future().share();
+		}
+
+		auto job = std::make_shared<Job>();
+		job->texture = texture;
+		job->order = {priority, next_sequence_++};
+
+		entry.job = job;
+		entry.future = job->promise.get_future().share();
+		queue_.emplace(job->order, job);
+
+		// One task per request, each decoding whatever is most urgent when it runs
+		pool_.submit([this] { decodeNext(); });
+
+		return entry.future;
+	}
+
+	void DecodeQueue::wait() {
+		pool_.wait();
+	}
+
+	std::size_t DecodeQueue::queued() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return queue_.size();
+	}
+
+	std::size_t DecodeQueue::tracked() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return entries_.size();
+	}
+
+	void DecodeQueue::pruneExpired() {
+		for (auto entry = entries_.begin(); entry != entries_.end();) {
+			if (!entry->second.job && entry->second.result.expired()) {
+				entry = entries_.erase(entry);
+			}
+			else {
+				++entry;
+			}
+		}
+		prune_threshold_ = std::max(min_prune_threshold, 2 * entries_.size());
+	}
+
+	void DecodeQueue::decodeNext() {
+		std::shared_ptr<Job> job;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (stopping_ || queue_.empty()) {
+				return;
+			}
+			auto const first = queue_.begin();
+			job = std::move(first->second);
+			queue_.erase(first);
+		}
+
+		Result result;
+		try {
+			auto loader = std::make_shared<Loader>(job->texture.file, job->texture.format);
+			if (loader->valid() && job->texture.has_transparent_color) {
+				auto const& color = job->texture.decal_transparent_color;
+				loader->applyScreendoor(color.x, color.y, color.z);
+			}
+			result = std::move(loader);
+		}
+		catch (...) {
+			job->promise.set_exception(std::current_exception());
+		}
+		if (result) {
+			job->promise.set_value(result);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		auto const entry = entries_.find(job->texture);
+		if (entry != entries_.end() && entry->second.job == job) {
+			entry->second.job.reset();
+			entry->second.future = {};
+			entry->second.result = result;
+		}
+	}
+} // namespace bve::core::image
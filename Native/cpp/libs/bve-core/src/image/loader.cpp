@@ -1,65 +1,449 @@
+#include <cstddef>
+
+namespace bve::core::image::detail {
+	// stb's allocation hooks, see ScopedStbAllocator
+	void* stb_malloc(std::size_t size);
+	void* stb_realloc(void* pointer, std::size_t size);
+	void stb_free(void* pointer);
+} // namespace bve::core::image::detail
+
+#define STBI_MALLOC(size) ::bve::core::image::detail::stb_malloc(size)
+#define STBI_REALLOC(pointer, size) ::bve::core::image::detail::stb_realloc(pointer, size)
+#define STBI_FREE(pointer) ::bve::core::image::detail::stb_free(pointer)
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
 #include <nmmintrin.h>
 
 #include "core/image/loader.hpp"
+#include <EASTL/allocator_fwd.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <stdexcept>
 
 namespace bve::core::image {
-	Loader::Loader(std::string filename) : dimensions_{} {
-		data_ = stbi_loadf(filename.c_str(), &dimensions_.x, &dimensions_.y, nullptr, 4);
+	namespace {
+		// Allocator stb allocates from on this thread, malloc when null
+		thread_local util::Allocator* stb_allocator = nullptr;
+
+		// In front of every block stb gets, so it can be freed after the allocator stops being current, from any thread. 16 bytes so
+		// the memory after it keeps the alignment of the allocation.
+		struct alignas(16) StbAllocationHeader {
+			util::Allocator* allocator;
+			std::size_t size;
+		};
+
+		class ScopedStbAllocator {
+		  public:
+			explicit ScopedStbAllocator(util::Allocator* const allocator) : previous_(stb_allocator) {
+				stb_allocator = allocator;
+			}
+			ScopedStbAllocator(ScopedStbAllocator const&) = delete;
+			ScopedStbAllocator& operator=(ScopedStbAllocator const&) = delete;
+			~ScopedStbAllocator() {
+				stb_allocator = previous_;
+			}
+
+		  private:
+			util::Allocator* previous_;
+		};
+
+		struct StbFree {
+			void operator()(void* const pointer) const noexcept {
+				stbi_image_free(pointer);
+			}
+		};
+
+		// Pixels are stored r, g, b, a in memory, so as little endian 32 bit ints alpha is the top byte
+		constexpr std::uint32_t rgb_bits = 0x00FFFFFFu;
+		constexpr std::uint32_t alpha_bits = 0xFF000000u;
+
+		std::uint32_t pack_rgba8(std::uint8_t const r, std::uint8_t const g, std::uint8_t const b, std::uint8_t const a) {
+			return std::uint32_t(r) | std::uint32_t(g) << 8u | std::uint32_t(b) << 16u | std::uint32_t(a) << 24u;
+		}
+
+		void screendoor_rgba8(std::uint8_t* const data, std::size_t const pixel_count, std::uint32_t const key) {
+			__m128i const filter = _mm_set1_epi32(static_cast<int>(key));
+			__m128i const rgb_mask = _mm_set1_epi32(static_cast<int>(rgb_bits));
+			__m128i const alpha_mask = _mm_set1_epi32(static_cast<int>(alpha_bits));
+
+			// four pixels at a time
+			std::size_t i = 0;
+			for (; i + 4 <= pixel_count; i += 4) {
+				auto* const address = reinterpret_cast<__m128i*>(&data[4 * i]);
+				__m128i const pixels = _mm_loadu_si128(address);
+				__m128i const equality = _mm_cmpeq_epi32(_mm_and_si128(pixels, rgb_mask), filter);
+				__m128i const doored = _mm_andnot_si128(_mm_and_si128(equality, alpha_mask), pixels);
+				_mm_storeu_si128(address, doored);
+			}
+
+			for (; i < pixel_count; ++i) {
+				std::uint8_t* const pixel = &data[4 * i];
+				if (pack_rgba8(pixel[0], pixel[1], pixel[2], 0) == key) {
+					pixel[3] = 0;
+				}
+			}
+		}
+
+		// round(x / 255) for x in [0, 255 * 255], exact
+		__m128i div_255(__m128i const x) {
+			__m128i const biased = _mm_add_epi16(x, _mm_set1_epi16(128));
+			return _mm_srli_epi16(_mm_add_epi16(biased, _mm_srli_epi16(biased, 8)), 8);
+		}
+
+		std::uint8_t div_255(std::uint32_t const x) {
+			auto const biased = x + 128;
+			return static_cast<std::uint8_t>((biased + (biased >> 8u)) >> 8u);
+		}
+
+		// Multiplying the gamma encoded values is the same as multiplying the linear ones stb's ldr_to_hdr produces, as
+		// (a * b) ^ gamma = a ^ gamma * b ^ gamma, so this matches the float path up to rounding.
+		void multiply_rgba8(std::uint8_t* const data, std::size_t const pixel_count, std::array<std::uint8_t, 4> const& multiplicand) {
+			__m128i const factors =
+			    _mm_set_epi16(multiplicand[3], multiplicand[2], multiplicand[1], multiplicand[0], //
+			                  multiplicand[3], multiplicand[2], multiplicand[1], multiplicand[0]);
+			__m128i const zero = _mm_setzero_si128();
+
+			// four pixels at a time, widened to 16 bits two pixels per register
+			std::size_t i = 0;
+			for (; i + 4 <= pixel_count; i += 4) {
+				auto* const address = reinterpret_cast<__m128i*>(&data[4 * i]);
+				__m128i const pixels = _mm_loadu_si128(address);
+				__m128i const low = div_255(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), factors));
+				__m128i const high = div_255(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), factors));
+				_mm_storeu_si128(address, _mm_packus_epi16(low, high));
+			}
+
+			for (; i < pixel_count; ++i) {
+				for (std::size_t channel = 0; channel < 4; ++channel) {
+					std::uint8_t& value = data[4 * i + channel];
+					value = div_255(std::uint32_t(value) * multiplicand[channel]);
+				}
+			}
+		}
+		void screendoor_rgba32f(float* const data, std::size_t const pixel_count, float const r, float const g, float const b) {
+			__m128 const filter = _mm_set_ps(1, b, g, r);
+			__m128 const eq_mask = _mm_castsi128_ps(_mm_set_epi32(0xFFFFFFFF, 0, 0, 0));
+			__m128 const assign_mask = _mm_castsi128_ps(_mm_set_epi32(0, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF));
+
+			for (std::size_t i = 0; i < pixel_count; ++i) {
+				__m128 const pixels = _mm_load_ps(&data[4 * i]);
+				__m128 const equality = _mm_cmpeq_ps(filter, pixels);
+				__m128 const true_equal = _mm_or_ps(equality, eq_mask);
+				bool const v = _mm_test_all_ones(_mm_castps_si128(true_equal)) == 1;
+				if (v) {
+					__m128 const doored = _mm_and_ps(pixels, assign_mask);
+					_mm_store_ps(&data[4 * i], doored);
+				}
+			}
+		}
+
+		void multiply_rgba32f(float* const data,
+		                      std::size_t const pixel_count,
+		                      float const r,
+		                      float const g,
+		                      float const b,
+		                      float const a) {
+			__m128 const multiplicand = _mm_set_ps(a, b, g, r);
+
+			for (std::size_t i = 0; i < pixel_count; ++i) {
+				__m128 pixel = _mm_load_ps(&data[4 * i]);
+				__m128 result = _mm_mul_ps(pixel, multiplicand);
+				_mm_store_ps(&data[4 * i], result);
+			}
+		}
+		// Pixels per chunk of a fused pass, small enough that a chunk in float still fits in L1 for the next operation
+		constexpr std::size_t pipeline_chunk_size = 512;
+
+		std::array<float, 256> const& ldr_to_hdr_table() {
+			static std::array<float, 256> const table = [] {
+				std::array<float, 256> result{};
+				for (std::size_t i = 0; i < result.size(); ++i) {
+					result[i] = Loader::ldr_to_hdr(static_cast<std::uint8_t>(i));
+				}
+				return result;
+			}();
+			return table;
+		}
+
+		void run_pipeline(std::uint8_t* const data, std::size_t const pixel_count, const PixelPipeline& pipeline) {
+			for (auto const& operation : pipeline.operations()) {
+				auto const& color = operation.color;
+				switch (operation.type) {
+					case PixelPipeline::Operation::Type::screendoor:
+						screendoor_rgba8(data, pixel_count, pack_rgba8(color[0], color[1], color[2], 0));
+						break;
+					case PixelPipeline::Operation::Type::multiply:
+						multiply_rgba8(data, pixel_count, color);
+						break;
+				}
+			}
+		}
+
+		// Same conversions as the byte overloads of Loader::applyScreendoor and Loader::multiply
+		void run_pipeline(float* const data, std::size_t const pixel_count, const PixelPipeline& pipeline) {
+			auto const& table = ldr_to_hdr_table();
+			for (auto const& operation : pipeline.operations()) {
+				auto const& color = operation.color;
+				switch (operation.type) {
+					case PixelPipeline::Operation::Type::screendoor:
+						screendoor_rgba32f(data, pixel_count, table[color[0]], table[color[1]], table[color[2]]);
+						break;
+					case PixelPipeline::Operation::Type::multiply:
+						multiply_rgba32f(data, pixel_count, table[color[0]], table[color[1]], table[color[2]],
+						                 static_cast<float>(color[3]) / 255.0f);
+						break;
+				}
+			}
+		}
+
+		template <class T>
+		void run_pipeline_chunked(T* const data, std::size_t const pixel_count, const PixelPipeline& pipeline) {
+			for (std::size_t begin = 0; begin < pixel_count; begin += pipeline_chunk_size) {
+				run_pipeline(&data[4 * begin], std::min(pipeline_chunk_size, pixel_count - begin), pipeline);
+			}
+		}
+
+		// Up to pipeline_chunk_size pixels. Destination must be 16 byte aligned.
+		void convert_chunk(std::uint8_t const* const source,
+		                   float* const destination,
+		                   std::size_t const count,
+		                   const PixelPipeline& pipeline) {
+			auto const& table = ldr_to_hdr_table();
+
+			// the same conversion stbi_loadf does, color through the gamma curve and alpha linear
+			for (std::size_t i = 0; i < 4 * count; i += 4) {
+				destination[i + 0] = table[source[i + 0]];
+				destination[i + 1] = table[source[i + 1]];
+				destination[i + 2] = table[source[i + 2]];
+				destination[i + 3] = static_cast<float>(source[i + 3]) / 255.0f;
+			}
+
+			run_pipeline(destination, count, pipeline);
+		}
+	} // namespace
+
+	namespace detail {
+		void* stb_malloc(std::size_t const size) {
+			util::Allocator* const allocator = stb_allocator;
+			std::size_t const total = sizeof(StbAllocationHeader) + size;
+			void* const block = allocator != nullptr ? allocator->allocate(total, alignof(StbAllocationHeader), 0) : std::malloc(total);
+			if (block == nullptr) {
+				return nullptr;
+			}
+			return new (block) StbAllocationHeader{allocator, size} + 1;
+		}
+
+		void* stb_realloc(void* const pointer, std::size_t const size) {
+			if (pointer == nullptr) {
+				return stb_malloc(size);
+			}
+
+			auto* const header = static_cast<StbAllocationHeader*>(pointer) - 1;
+			util::Allocator* const allocator = header->allocator;
+			if (allocator == nullptr) {
+				auto* const block = static_cast<StbAllocationHeader*>(std::realloc(header, sizeof(StbAllocationHeader) + size));
+				if (block == nullptr) {
+					return nullptr;
+				}
+				block->size = size;
+				return block + 1;
+			}
+
+			// stays with the allocator it came from, which has no realloc of its own
+			void* const block = allocator->allocate(sizeof(StbAllocationHeader) + size, alignof(StbAllocationHeader), 0);
+			if (block == nullptr) {
+				return nullptr;
+			}
+			auto* const moved = new (block) StbAllocationHeader{allocator, size} + 1;
+			std::memcpy(moved, pointer, std::min(size, header->size));
+			allocator->deallocate(header, sizeof(StbAllocationHeader) + header->size);
+			return moved;
+		}
+
+		void stb_free(void* const pointer) {
+			if (pointer == nullptr) {
+				return;
+			}
+
+			auto* const header = static_cast<StbAllocationHeader*>(pointer) - 1;
+			if (header->allocator != nullptr) {
+				header->allocator->deallocate(header, sizeof(StbAllocationHeader) + header->size);
+			}
+			else {
+				std::free(header);
+			}
+		}
+	} // namespace detail
+
+	Loader::Loader(std::string filename, PixelFormat const format) : dimensions_{}, format_(format) {
+		switch (format_) {
+			case PixelFormat::rgba32f:
+				data_ = stbi_loadf(filename.c_str(), &dimensions_.x, &dimensions_.y, nullptr, 4);
+				break;
+			case PixelFormat::rgba8:
+				data_rgba8_ = stbi_load(filename.c_str(), &dimensions_.x, &dimensions_.y, nullptr, 4);
+				break;
+		}
+	}
+	Loader::Loader(std::string filename, const PixelPipeline& pipeline, PixelFormat const format) : dimensions_{}, format_(format) {
+		if (format_ == PixelFormat::rgba32f && stbi_is_hdr(filename.c_str()) != 0) {
+			// real HDR data would be lost going through 8 bit
+			data_ = stbi_loadf(filename.c_str(), &dimensions_.x, &dimensions_.y, nullptr, 4);
+			if (data_ != nullptr) {
+				apply(pipeline);
+			}
+			return;
+		}
+
+		auto* const bytes = stbi_load(filename.c_str(), &dimensions_.x, &dimensions_.y, nullptr, 4);
+		if (bytes == nullptr) {
+			return;
+		}
+
+		std::size_t const pixel_count = std::size_t(dimensions_.x) * std::size_t(dimensions_.y);
+		if (format_ == PixelFormat::rgba8) {
+			data_rgba8_ = bytes;
+			run_pipeline_chunked(data_rgba8_, pixel_count, pipeline);
+			return;
+		}
+
+		// Freed with stbi_image_free like stb's own buffers, so this has to come from the same allocator. malloc's alignment is enough
+		// for the aligned SSE loads.
+		data_ = static_cast<float*>(STBI_MALLOC(pixel_count * 4 * sizeof(float)));
+		if (data_ == nullptr) {
+			stbi_image_free(bytes);
+			throw std::bad_alloc();
+		}
+
+		for (std::size_t begin = 0; begin < pixel_count; begin += pipeline_chunk_size) {
+			convert_chunk(&bytes[4 * begin], &data_[4 * begin], std::min(pipeline_chunk_size, pixel_count - begin), pipeline);
+		}
+
+		stbi_image_free(bytes);
 	}
 	glm::ivec2 Loader::dimensions() const noexcept {
 		return dimensions_;
 	}
+	PixelFormat Loader::pixelFormat() const noexcept {
+		return format_;
+	}
 	const float* Loader::data() const noexcept {
 		return data_;
 	}
+	const std::uint8_t* Loader::dataRGBA8() const noexcept {
+		return data_rgba8_;
+	}
 
 	void Loader::applyScreendoor(std::uint8_t const r, std::uint8_t const g, std::uint8_t const b) {
+		if (format_ == PixelFormat::rgba8) {
+			screendoor_rgba8(data_rgba8_, std::size_t(dimensions_.x) * std::size_t(dimensions_.y), pack_rgba8(r, g, b, 0));
+			return;
+		}
+
 		// Exact same conversion done by stbi__ldr_to_hdr
 		applyScreendoor(ldr_to_hdr(r), ldr_to_hdr(g), ldr_to_hdr(b));
 	}
 
 	// ReSharper disable once CppMemberFunctionMayBeConst
 	void Loader::applyScreendoor(float const r, float const g, float const b) {
-		__m128 const filter = _mm_set_ps(1, b, g, r);
-		__m128 const eq_mask = _mm_castsi128_ps(_mm_set_epi32(0xFFFFFFFF, 0, 0, 0));
-		__m128 const assign_mask = _mm_castsi128_ps(_mm_set_epi32(0, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF));
-
-		std::size_t const pixel_count = dimensions_.x * dimensions_.y;
-		for (std::size_t i = 0; i < pixel_count; ++i) {
-			__m128 const pixels = _mm_load_ps(&data_[4 * i]);
-			__m128 const equality = _mm_cmpeq_ps(filter, pixels);
-			__m128 const true_equal = _mm_or_ps(equality, eq_mask);
-			bool const v = _mm_test_all_ones(_mm_castps_si128(true_equal)) == 1;
-			if (v) {
-				__m128 const doored = _mm_and_ps(pixels, assign_mask);
-				_mm_store_ps(&data_[4 * i], doored);
-			}
+		if (format_ != PixelFormat::rgba32f) {
+			throw std::logic_error("Float screendoor color on an 8 bit image");
 		}
+
+		screendoor_rgba32f(data_, std::size_t(dimensions_.x) * std::size_t(dimensions_.y), r, g, b);
 	}
 
 	void Loader::multiply(std::uint8_t r, std::uint8_t g, std::uint8_t b, std::uint8_t a) {
+		if (format_ == PixelFormat::rgba8) {
+			multiply_rgba8(data_rgba8_, std::size_t(dimensions_.x) * std::size_t(dimensions_.y), {r, g, b, a});
+			return;
+		}
+
 		multiply(ldr_to_hdr(r), ldr_to_hdr(g), ldr_to_hdr(b), static_cast<float>(a) / 255.0f);
 	}
 
 	void Loader::multiply(float r, float g, float b, float a) {
-		__m128 const multiplicand = _mm_set_ps(a, b, g, r);
+		if (format_ != PixelFormat::rgba32f) {
+			throw std::logic_error("Float multiply on an 8 bit image");
+		}
+
+		multiply_rgba32f(data_, std::size_t(dimensions_.x) * std::size_t(dimensions_.y), r, g, b, a);
+	}
 
-		std::size_t const pixel_count = dimensions_.x * dimensions_.y;
-		for (std::size_t i = 0; i < pixel_count; ++i) {
-			__m128 pixel = _mm_load_ps(&data_[4 * i]);
-			__m128 result = _mm_mul_ps(pixel, multiplicand);
-			_mm_store_ps(&data_[4 * i], result);
+	void Loader::apply(const PixelPipeline& pipeline) {
+		std::size_t const pixel_count = std::size_t(dimensions_.x) * std::size_t(dimensions_.y);
+		if (format_ == PixelFormat::rgba8) {
+			run_pipeline_chunked(data_rgba8_, pixel_count, pipeline);
+		}
+		else {
+			run_pipeline_chunked(data_, pixel_count, pipeline);
 		}
 	}
 
 	bool Loader::valid() const noexcept {
-		return data_ != nullptr;
+		return data_ != nullptr || data_rgba8_ != nullptr;
 	}
 	Loader::~Loader() {
 		stbi_image_free(data_);
+		stbi_image_free(data_rgba8_);
+	}
+
+	bool decode_into(const std::string& filename,
+	                 const DecodeTarget& target,
+	                 const PixelPipeline& pipeline,
+	                 util::Allocator* const scratch) {
+		std::size_t const width = target.dimensions.x > 0 ? std::size_t(target.dimensions.x) : 0;
+		std::size_t const row_size = width * bytes_per_pixel(target.format);
+		if (target.pixels == nullptr || target.row_pitch < row_size) {
+			throw std::invalid_argument("Decode target rows are too small for its dimensions");
+		}
+
+		ScopedStbAllocator const scope(scratch);
+		auto* const rows = static_cast<std::uint8_t*>(target.pixels);
+		glm::ivec2 dimensions{};
+
+		// The target is written a row at a time, finished pixels only and never read back, as upload memory is often write combined.
+		if (target.format == PixelFormat::rgba32f && stbi_is_hdr(filename.c_str()) != 0) {
+			std::unique_ptr<float, StbFree> const floats(stbi_loadf(filename.c_str(), &dimensions.x, &dimensions.y, nullptr, 4));
+			if (floats == nullptr || dimensions != target.dimensions) {
+				return false;
+			}
+			for (int y = 0; y < dimensions.y; ++y) {
+				float* const source = floats.get() + 4 * width * std::size_t(y);
+				run_pipeline_chunked(source, width, pipeline);
+				std::memcpy(rows + std::size_t(y) * target.row_pitch, source, row_size);
+			}
+			return true;
+		}
+
+		std::unique_ptr<std::uint8_t, StbFree> const bytes(stbi_load(filename.c_str(), &dimensions.x, &dimensions.y, nullptr, 4));
+		if (bytes == nullptr || dimensions != target.dimensions) {
+			return false;
+		}
+
+		alignas(16) std::array<float, 4 * pipeline_chunk_size> chunk;
+		for (int y = 0; y < dimensions.y; ++y) {
+			std::uint8_t* const source = bytes.get() + 4 * width * std::size_t(y);
+			std::uint8_t* const destination = rows + std::size_t(y) * target.row_pitch;
+
+			if (target.format == PixelFormat::rgba8) {
+				run_pipeline_chunked(source, width, pipeline);
+				std::memcpy(destination, source, row_size);
+				continue;
+			}
+
+			for (std::size_t begin = 0; begin < width; begin += pipeline_chunk_size) {
+				std::size_t const count = std::min(pipeline_chunk_size, width - begin);
+				convert_chunk(&source[4 * begin], chunk.data(), count, pipeline);
+				std::memcpy(destination + begin * sizeof(float) * 4, chunk.data(), count * sizeof(float) * 4);
+			}
+		}
+		return true;
 	}
 
 	float Loader::ldr_to_hdr(uint8_t v) {
@@ -0,0 +1,177 @@
+#include "core/image/mipmaps.hpp"
+#include "core/image/loader.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <nmmintrin.h>
+
+namespace bve::core::image {
+	namespace {
+		// stb_image's default, which Loader::ldr_to_hdr converts with
+		constexpr float ldr_gamma = 2.2F;
+		// Rows filtered by one task when running on a pool
+		constexpr int rows_per_task = 16;
+
+		struct GammaTables {
+			std::array<float, 256> to_linear;
+			// linear value halfway between two bytes in gamma space, so searching it rounds to the nearest byte
+			std::array<float, 255> thresholds;
+		};
+
+		GammaTables const& gamma_tables() {
+			static GammaTables const tables = [] {
+				GammaTables result{};
+				for (std::size_t i = 0; i < result.to_linear.size(); ++i) {
+					result.to_linear[i] = Loader::ldr_to_hdr(static_cast<std::uint8_t>(i));
+				}
+				for (std::size_t i = 0; i < result.thresholds.size(); ++i) {
+					result.thresholds[i] = std::pow((static_cast<float>(i) + 0.5F) / 255.0F, ldr_gamma);
+				}
+				return result;
+			}();
+			return tables;
+		}
+
+		std::uint8_t to_ldr(GammaTables const& tables, float const linear) {
+			auto const position = std::upper_bound(tables.thresholds.begin(), tables.thresholds.end(), linear);
+			return static_cast<std::uint8_t>(position - tables.thresholds.begin());
+		}
+
+		std::uint8_t to_ldr_alpha(float const alpha) {
+			return static_cast<std::uint8_t>(std::lround(std::clamp(alpha, 0.0F, 1.0F) * 255.0F));
+		}
+
+		__m128 average(__m128 const p00, __m128 const p01, __m128 const p10, __m128 const p11) {
+			__m128 const sum = _mm_add_ps(_mm_add_ps(p00, p01), _mm_add_ps(p10, p11));
+			return _mm_mul_ps(sum, _mm_set1_ps(0.25F));
+		}
+
+		// color * alpha, alpha left as is
+		__m128 weigh_by_alpha(__m128 const pixel) {
+			__m128 const alpha = _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+			return _mm_blend_ps(_mm_mul_ps(pixel, alpha), pixel, 0b1000);
+		}
+
+		__m128 alpha_weighted_average(__m128 const p00, __m128 const p01, __m128 const p10, __m128 const p11) {
+			__m128 const total =
+			    _mm_add_ps(_mm_add_ps(weigh_by_alpha(p00), weigh_by_alpha(p01)), _mm_add_ps(weigh_by_alpha(p10), weigh_by_alpha(p11)));
+			__m128 const alpha_sum = _mm_shuffle_ps(total, total, _MM_SHUFFLE(3, 3, 3, 3));
+
+			if (_mm_cvtss_f32(alpha_sum) <= 0.0F) {
+				// nothing visible, the color doesn't matter but keep it sensible
+				return average(p00, p01, p10, p11);
+			}
+
+			__m128 const color = _mm_div_ps(total, alpha_sum);
+			return _mm_blend_ps(color, _mm_mul_ps(alpha_sum, _mm_set1_ps(0.25F)), 0b1000);
+		}
+
+		void filter_rows(const float* const source,
+		                 glm::ivec2 const source_dimensions,
+		                 float* const destination,
+		                 glm::ivec2 const destination_dimensions,
+		                 int const row_begin,
+		                 int const row_end,
+		                 bool const alpha_weighted) {
+			auto const pixel = [&](int const x, int const y) {
+				return _mm_loadu_ps(&source[4 * (std::size_t(y) * std::size_t(source_dimensions.x) + std::size_t(x))]);
+			};
+
+			for (int y = row_begin; y < row_end; ++y) {
+				int const y0 = std::min(2 * y, source_dimensions.y - 1);
+				int const y1 = std::min(2 * y + 1, source_dimensions.y - 1);
+				float* output = &destination[4 * std::size_t(y) * std::size_t(destination_dimensions.x)];
+
+				for (int x = 0; x < destination_dimensions.x; ++x) {
+					int const x0 = std::min(2 * x, source_dimensions.x - 1);
+					int const x1 = std::min(2 * x + 1, source_dimensions.x - 1);
+					__m128 const p00 = pixel(x0, y0);
+					__m128 const p01 = pixel(x1, y0);
+					__m128 const p10 = pixel(x0, y1);
+					__m128 const p11 = pixel(x1, y1);
+
+					_mm_storeu_ps(output, alpha_weighted ? alpha_weighted_average(p00, p01, p10, p11) : average(p00, p01, p10, p11));
+					output += 4;
+				}
+			}
+		}
+
+		// Run func(row_begin, row_end) over all rows, split across the pool if there is one
+		template <class Func>
+		void for_each_rows(int const rows, MipOptions const& options, Func const& func) {
+			if (options.pool == nullptr || rows <= rows_per_task) {
+				func(0, rows);
+				return;
+			}
+
+			auto const task_count = static_cast<std::size_t>((rows + rows_per_task - 1) / rows_per_task);
+			util::parallel_for(*options.pool, task_count, [&func, rows](std::size_t const task) {
+				int const begin = static_cast<int>(task) * rows_per_task;
+				func(begin, std::min(begin + rows_per_task, rows));
+			});
+		}
+	} // namespace
+
+	std::vector<MipLevel<float>> generate_mips(const float* const rgba, glm::ivec2 const dimensions, const MipOptions& options) {
+		std::vector<MipLevel<float>> levels;
+
+		const float* source = rgba;
+		glm::ivec2 source_dimensions = dimensions;
+		while (source_dimensions.x > 1 || source_dimensions.y > 1) {
+			glm::ivec2 const next = glm::max(source_dimensions / 2, glm::ivec2(1));
+
+			MipLevel<float> level{next, std::vector<float>(std::size_t(next.x) * std::size_t(next.y) * 4)};
+			for_each_rows(next.y, options, [&](int const begin, int const end) {
+				filter_rows(source, source_dimensions, level.pixels.data(), next, begin, end, options.alpha_weighted);
+			});
+
+			levels.emplace_back(std::move(level));
+			source = levels.back().pixels.data();
+			source_dimensions = next;
+		}
+
+		return levels;
+	}
+
+	std::vector<MipLevel<std::uint8_t>> generate_mips(const std::uint8_t* const rgba,
+	                                                  glm::ivec2 const dimensions,
+	                                                  const MipOptions& options) {
+		auto const& tables = gamma_tables();
+
+		std::vector<float> linear(std::size_t(dimensions.x) * std::size_t(dimensions.y) * 4);
+		for_each_rows(dimensions.y, options, [&](int const begin, int const end) {
+			auto const first = 4 * std::size_t(begin) * std::size_t(dimensions.x);
+			auto const last = 4 * std::size_t(end) * std::size_t(dimensions.x);
+			for (std::size_t i = first; i < last; i += 4) {
+				linear[i + 0] = tables.to_linear[rgba[i + 0]];
+				linear[i + 1] = tables.to_linear[rgba[i + 1]];
+				linear[i + 2] = tables.to_linear[rgba[i + 2]];
+				linear[i + 3] = static_cast<float>(rgba[i + 3]) / 255.0F;
+			}
+		});
+
+		auto const float_levels = generate_mips(linear.data(), dimensions, options);
+
+		std::vector<MipLevel<std::uint8_t>> levels;
+		levels.reserve(float_levels.size());
+		for (auto const& float_level : float_levels) {
+			auto const& level_dimensions = float_level.dimensions;
+			MipLevel<std::uint8_t> level{level_dimensions, std::vector<std::uint8_t>(float_level.pixels.size())};
+
+			for_each_rows(level_dimensions.y, options, [&](int const begin, int const end) {
+				auto const first = 4 * std::size_t(begin) * std::size_t(level_dimensions.x);
+				auto const last = 4 * std::size_t(end) * std::size_t(level_dimensions.x);
+				for (std::size_t i = first; i < last; i += 4) {
+					level.pixels[i + 0] = to_ldr(tables, float_level.pixels[i + 0]);
+					level.pixels[i + 1] = to_ldr(tables, float_level.pixels[i + 1]);
+					level.pixels[i + 2] = to_ldr(tables, float_level.pixels[i + 2]);
+					level.pixels[i + 3] = to_ldr_alpha(float_level.pixels[i + 3]);
+				}
+			});
+
+			levels.emplace_back(std::move(level));
+		}
+
+		return levels;
+	}
+} // namespace bve::core::image
@@ -0,0 +1,191 @@
+#include <stb_image.h>
+
+#include "core/image/probe.hpp"
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+namespace bve::core::image {
+	namespace {
+		struct FileCloser {
+			void operator()(std::FILE* const file) const noexcept {
+				std::fclose(file);
+			}
+		};
+		using File = std::unique_ptr<std::FILE, FileCloser>;
+
+		constexpr std::array<std::uint8_t, 8> png_signature{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+		// Chunks skipped looking for transparency before giving up. Real files have a handful before the image data.
+		constexpr int max_png_chunks = 64;
+
+		constexpr std::size_t bmp_file_header_size = 14;
+		// BITMAPCOREHEADER, from OS/2
+		constexpr std::uint32_t bmp_core_header_size = 12;
+		constexpr std::uint32_t bmp_info_header_size = 40;
+		// BITMAPV3INFOHEADER, the first one with an alpha mask
+		constexpr std::uint32_t bmp_v3_header_size = 56;
+		constexpr std::uint32_t bmp_bitfields = 3;
+
+		std::uint32_t read_le(const std::uint8_t* const bytes, std::size_t const count) {
+			std::uint32_t value = 0;
+			for (std::size_t i = 0; i < count; ++i) {
+				value |= std::uint32_t(bytes[i]) << (8 * i);
+			}
+			return value;
+		}
+
+		std::uint32_t read_be(const std::uint8_t* const bytes) {
+			return std::uint32_t(bytes[0]) << 24u | std::uint32_t(bytes[1]) << 16u | std::uint32_t(bytes[2]) << 8u
+			       | std::uint32_t(bytes[3]);
+		}
+
+		bool probe_png(std::FILE* const file, ImageInfo& info) {
+			// signature, then IHDR which must come first: length, type, 13 bytes of data
+			std::array<std::uint8_t, 8 + 8 + 13> header{};
+			if (std::fread(header.data(), 1, header.size(), file) != header.size()
+			    || std::memcmp(header.data(), png_signature.data(), png_signature.size()) != 0
+			    || std::memcmp(&header[12], "IHDR", 4) != 0) {
+				return false;
+			}
+
+			auto const width = read_be(&header[16]);
+			auto const height = read_be(&header[20]);
+			auto const bit_depth = header[24];
+			auto const color_type = header[25];
+			if (width == 0 || height == 0 || width > 0x7FFFFFFFu || height > 0x7FFFFFFFu) {
+				return false;
+			}
+
+			int channels;
+			switch (color_type) {
+				case 0:
+					channels = 1;
+					break;
+				case 2:
+				case 3:
+					channels = 3;
+					break;
+				case 4:
+					channels = 2;
+					break;
+				case 6:
+					channels = 4;
+					break;
+				default:
+					return false;
+			}
+
+			// Grey, RGB and palette images get alpha from a tRNS chunk, which has to come before the image data
+			if (color_type == 0 || color_type == 2 || color_type == 3) {
+				// past the CRC of IHDR
+				bool const seeked = std::fseek(file, static_cast<long>(header.size() + 4), SEEK_SET) == 0;
+				std::array<std::uint8_t, 8> chunk{};
+				for (int i = 0; seeked && i < max_png_chunks && std::fread(chunk.data(), 1, chunk.size(), file) == chunk.size(); ++i) {
+					if (std::memcmp(&chunk[4], "tRNS", 4) == 0) {
+						channels += 1;
+						break;
+					}
+					if (std::memcmp(&chunk[4], "IDAT", 4) == 0 || std::memcmp(&chunk[4], "IEND", 4) == 0) {
+						break;
+					}
+					// data and CRC
+					if (std::fseek(file, static_cast<long>(read_be(chunk.data())) + 4, SEEK_CUR) != 0) {
+						break;
+					}
+				}
+			}
+
+			info.format = FileFormat::png;
+			info.dimensions = {static_cast<int>(width), static_cast<int>(height)};
+			info.channels = channels;
+			info.bit_depth = bit_depth == 16 ? 16 : 8;
+			return true;
+		}
+
+		bool probe_bmp(std::FILE* const file, ImageInfo& info) {
+			// file header and an info header up to the alpha mask
+			std::array<std::uint8_t, bmp_file_header_size + bmp_v3_header_size> header{};
+			auto const read = std::fread(header.data(), 1, header.size(), file);
+			if (read < bmp_file_header_size + bmp_core_header_size || header[0] != 'B' || header[1] != 'M') {
+				return false;
+			}
+
+			auto const header_size = read_le(&header[14], 4);
+			std::int32_t width;
+			std::int32_t height;
+			std::uint32_t bits_per_pixel;
+			std::uint32_t compression = 0;
+			if (header_size == bmp_core_header_size) {
+				width = static_cast<std::int16_t>(read_le(&header[18], 2));
+				height = static_cast<std::int16_t>(read_le(&header[20], 2));
+				bits_per_pixel = read_le(&header[24], 2);
+			}
+			else if (header_size >= bmp_info_header_size && read >= bmp_file_header_size + bmp_info_header_size) {
+				width = static_cast<std::int32_t>(read_le(&header[18], 4));
+				height = static_cast<std::int32_t>(read_le(&header[22], 4));
+				bits_per_pixel = read_le(&header[28], 2);
+				compression = read_le(&header[30], 4);
+			}
+			else {
+				return false;
+			}
+
+			// negative height means top row first
+			if (width <= 0 || height == 0 || height == INT32_MIN) {
+				return false;
+			}
+
+			// Same rules as stb: 32 bit images have alpha in the top byte, bitfields only if the header has an alpha mask
+			bool alpha = bits_per_pixel == 32;
+			if (compression == bmp_bitfields) {
+				alpha = header_size >= bmp_v3_header_size && read == header.size() && read_le(&header[66], 4) != 0;
+			}
+
+			info.format = FileFormat::bmp;
+			info.dimensions = {width, std::abs(height)};
+			info.channels = alpha ? 4 : 3;
+			info.bit_depth = 8;
+			return true;
+		}
+	} // namespace
+
+	ImageInfo probe_image(const std::string& filename) {
+		File const file(std::fopen(filename.c_str(), "rb"));
+		if (!file) {
+			return {};
+		}
+
+		ImageInfo info;
+		if (probe_png(file.get(), info)) {
+			return info;
+		}
+		std::rewind(file.get());
+		if (probe_bmp(file.get(), info)) {
+			return info;
+		}
+		std::rewind(file.get());
+
+		int width;
+		int height;
+		int channels;
+		if (stbi_info_from_file(file.get(), &width, &height, &channels) == 0) {
+			return {};
+		}
+
+		info.format = FileFormat::other;
+		info.dimensions = {width, height};
+		info.channels = channels;
+		if (stbi_is_hdr_from_file(file.get()) != 0) {
+			info.bit_depth = 32;
+		}
+		else if (stbi_is_16_bit_from_file(file.get()) != 0) {
+			info.bit_depth = 16;
+		}
+		else {
+			info.bit_depth = 8;
+		}
+		return info;
+	}
+} // namespace bve::core::image
@@ -0,0 +1,176 @@
+#include "core/image/residency.hpp"
+#include <algorithm>
+#include <glm/geometric.hpp>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace bve::core::image {
+	namespace {
+		template <class Func>
+		std::vector<std::size_t> level_sizes(glm::ivec2 dimensions, bool const mips, Func const& level_size) {
+			std::vector<std::size_t> sizes{level_size(dimensions)};
+			while (mips && (dimensions.x > 1 || dimensions.y > 1)) {
+				dimensions = glm::max(dimensions / 2, glm::ivec2(1));
+				sizes.emplace_back(level_size(dimensions));
+			}
+			return sizes;
+		}
+
+		std::size_t index(Memory const memory) {
+			return static_cast<std::size_t>(memory);
+		}
+	} // namespace
+
+	std::vector<std::size_t> mip_level_sizes(glm::ivec2 const dimensions, PixelFormat const format, bool const mips) {
+		return level_sizes(dimensions, mips, [pixel_size = bytes_per_pixel(format)](glm::ivec2 const level) {
+			return std::size_t(level.x) * std::size_t(level.y) * pixel_size;
+		});
+	}
+
+	std::vector<std::size_t> mip_level_sizes(glm::ivec2 const dimensions, BlockFormat const format, bool const mips) {
+		std::size_t const block_size = format == BlockFormat::bc1 ? 8 : 16;
+		return level_sizes(dimensions, mips, [block_size](glm::ivec2 const level) {
+			return std::size_t((level.x + 3) / 4) * std::size_t((level.y + 3) / 4) * block_size;
+		});
+	}
+
+	ResidencyManager::ResidencyManager(ResidencyBudget const budget, EvictionPolicy const policy) :
+	    budget_{budget.cpu_bytes, budget.gpu_bytes}, stats_{}, policy_(policy) {}
+
+	void ResidencyManager::registerTexture(TextureID const id, std::vector<std::size_t> level_sizes, glm::vec3 const position) {
+		if (id >= textures_.size()) {
+			textures_.resize(std::size_t(id) + 1);
+		}
+
+		auto& texture = textures_[id];
+		texture.registered = true;
+		texture.level_sizes = std::move(level_sizes);
+		texture.position = position;
+	}
+
+	bool ResidencyManager::touch(TextureID const id, Memory const memory) {
+		auto& stats = stats_[index(memory)];
+		if (id >= textures_.size() || !textures_[id].residence[index(memory)].resident) {
+			++stats.misses;
+			return false;
+		}
+
+		use(textures_[id].residence[index(memory)]);
+		++stats.hits;
+		return true;
+	}
+
+	std::vector<ResidencyManager::TextureID> ResidencyManager::makeResident(TextureID const id,
+	                                                                       Memory const memory,
+	                                                                       std::size_t const first_level) {
+		if (id >= textures_.size() || !textures_[id].registered) {
+			throw std::out_of_range("Texture made resident before being registered");
+		}
+
+		auto& texture = textures_[id];
+		auto& residence = texture.residence[index(memory)];
+		auto& stats = stats_[index(memory)];
+
+		auto const first = std::min(first_level, texture.level_sizes.size());
+		std::size_t const bytes = std::accumulate(texture.level_sizes.begin() + first, texture.level_sizes.end(), std::size_t(0));
+
+		if (residence.resident) {
+			stats.resident_bytes -= residence.bytes;
+		}
+		else {
+			++stats.resident_textures;
+		}
+		residence.resident = true;
+		residence.bytes = bytes;
+		stats.resident_bytes += bytes;
+		use(residence);
+
+		return evict(memory, id);
+	}
+
+	void ResidencyManager::release(TextureID const id, Memory const memory) {
+		if (id >= textures_.size()) {
+			return;
+		}
+
+		auto& residence = textures_[id].residence[index(memory)];
+		if (residence.resident) {
+			auto& stats = stats_[index(memory)];
+			stats.resident_bytes -= residence.bytes;
+			--stats.resident_textures;
+			residence.resident = false;
+			residence.bytes = 0;
+		}
+	}
+
+	bool ResidencyManager::resident(TextureID const id, Memory const memory) const noexcept {
+		return id < textures_.size() && textures_[id].residence[index(memory)].resident;
+	}
+
+	void ResidencyManager::beginFrame() noexcept {
+		++frame_;
+	}
+
+	void ResidencyManager::setCameraPosition(glm::vec3 const position) noexcept {
+		camera_position_ = position;
+	}
+
+	std::vector<ResidencyManager::TextureID> ResidencyManager::setBudget(Memory const memory, std::size_t const bytes) {
+		budget_[index(memory)] = bytes;
+		return evict(memory, util::StringInterner::invalid_id);
+	}
+
+	ResidencyStats const& ResidencyManager::stats(Memory const memory) const noexcept {
+		return stats_[index(memory)];
+	}
+
+	void ResidencyManager::resetCounters() noexcept {
+		for (auto& stats : stats_) {
+			stats.hits = 0;
+			stats.misses = 0;
+			stats.evictions = 0;
+		}
+	}
+
+	std::vector<ResidencyManager::TextureID> ResidencyManager::evict(Memory const memory, TextureID const keep) {
+		auto& stats = stats_[index(memory)];
+		auto const budget = budget_[index(memory)];
+		if (stats.resident_bytes <= budget) {
+			return {};
+		}
+
+		// Only runs when over budget, which a well sized budget makes rare, so a scan is cheaper than keeping an order up to date on
+		// every touch. Smallest key goes first.
+		std::vector<std::pair<double, TextureID>> candidates;
+		for (TextureID id = 0; id < textures_.size(); ++id) {
+			auto const& texture = textures_[id];
+			auto const& residence = texture.residence[index(memory)];
+			if (!residence.resident || id == keep || residence.last_frame == frame_) {
+				continue;
+			}
+
+			double const key = policy_ == EvictionPolicy::least_recently_used
+			                       ? static_cast<double>(residence.last_use)
+			                       : -static_cast<double>(glm::distance(texture.position, camera_position_));
+			candidates.emplace_back(key, id);
+		}
+		std::sort(candidates.begin(), candidates.end());
+
+		std::vector<TextureID> evicted;
+		for (auto const& candidate : candidates) {
+			if (stats.resident_bytes <= budget) {
+				break;
+			}
+			release(candidate.second, memory);
+			++stats.evictions;
+			evicted.emplace_back(candidate.second);
+		}
+		return evicted;
+	}
+
+	void ResidencyManager::use(Residence& residence) noexcept {
+		residence.last_use = ++use_counter_;
+		residence.last_frame = frame_;
+	}
+} // namespace bve::core::image
@@ -0,0 +1,157 @@
+#include "core/image/texture_cache.hpp"
+#include "util/binary_io.hpp"
+#include "util/content_hash.hpp"
+#include "util/mapped_file.hpp"
+#include <algorithm>
+#include <array>
+#include <glm/common.hpp>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace bve::core::image {
+	namespace {
+		using util::binary::Reader;
+		using util::binary::Writer;
+
+		using Magic = std::array<char, 8>;
+		constexpr Magic cache_magic = {'B', 'V', 'E', 'T', 'E', 'X', 'T', 'R'};
+		// Bump whenever the serialized layout of CompressedTexture changes
+		constexpr std::uint32_t cache_version = 1;
+		// Bump whenever the encoder or mip generation produces different output for the same image. Part of the key.
+		constexpr std::uint32_t encoder_version = 2;
+
+		// A texture that is safe to hand to an uploader: a known format, a base level followed by nothing or a full halving chain down
+		// to 1x1, and exactly as many block bytes as every level's size needs.
+		bool valid_texture(const CompressedTexture& texture) {
+			if (texture.format != BlockFormat::bc1 && texture.format != BlockFormat::bc3) {
+				return false;
+			}
+			if (texture.levels.empty()) {
+				return false;
+			}
+
+			auto const& base = texture.levels.front().dimensions;
+			if (base.x <= 0 || base.y <= 0) {
+				return false;
+			}
+			for (std::size_t i = 1; i < texture.levels.size(); ++i) {
+				if (texture.levels[i].dimensions != glm::max(texture.levels[i - 1].dimensions / 2, glm::ivec2(1))) {
+					return false;
+				}
+			}
+			if (texture.levels.size() > 1 && texture.levels.back().dimensions != glm::ivec2(1)) {
+				return false;
+			}
+
+			return std::all_of(texture.levels.begin(), texture.levels.end(), [&](const CompressedLevel& level) {
+				return level.blocks.size() == compressed_level_size(texture.format, level.dimensions);
+			});
+		}
+	} // namespace
+
+	std::uint64_t texture_cache_key(const char* const file_contents,
+	                                std::size_t const size,
+	                                const DecodeRequest& texture,
+	                                bool const generate_mips) {
+		std::array<std::uint8_t, 6> const settings = {
+		    static_cast<std::uint8_t>(texture.has_transparent_color),
+		    texture.has_transparent_color ? texture.decal_transparent_color.x : std::uint8_t(0),
+		    texture.has_transparent_color ? texture.decal_transparent_color.y : std::uint8_t(0),
+		    texture.has_transparent_color ? texture.decal_transparent_color.z : std::uint8_t(0),
+		    static_cast<std::uint8_t>(generate_mips),
+		    static_cast<std::uint8_t>(encoder_version),
+		};
+
+		auto const hash = util::hash::content_hash(settings.data(), settings.size());
+		return util::hash::content_hash(file_contents, size, hash);
+	}
+
+	std::string texture_cache_filename(const std::string& cache_directory, std::uint64_t const key) {
+		std::ostringstream filename;
+		filename << cache_directory << '/' << std::hex << std::setw(16) << std::setfill('0') << key << ".bvetex";
+		return filename.str();
+	}
+
+	bool save_texture_cache(const std::string& cache_filename, std::uint64_t const key, const CompressedTexture& texture) {
+		Writer w;
+
+		w.write(cache_magic);
+		w.write(cache_version);
+		w.write(key);
+
+		w.write(texture.format);
+		w.write<std::uint64_t>(texture.levels.size());
+		for (auto& level : texture.levels) {
+			w.write(level.dimensions);
+			w.writeArray(level.blocks);
+		}
+
+		return w.saveToFile(cache_filename);
+	}
+
+	bool load_texture_cache(const std::string& cache_filename, std::uint64_t const key, CompressedTexture& texture) {
+		util::MappedFile const cache(cache_filename);
+		if (!cache.valid()) {
+			return false;
+		}
+
+		Reader r(cache.data(), cache.size());
+
+		try {
+			if (r.read<Magic>() != cache_magic || r.read<std::uint32_t>() != cache_version || r.read<std::uint64_t>() != key) {
+				return false;
+			}
+
+			CompressedTexture loaded;
+			loaded.format = static_cast<BlockFormat>(r.read<std::uint8_t>());
+			// every level holds at least its dimensions and block count
+			loaded.levels.resize(r.readCount(sizeof(glm::ivec2) + sizeof(std::uint64_t)));
+			for (auto& level : loaded.levels) {
+				level.dimensions = r.read<glm::ivec2>();
+				r.readArray(level.blocks);
+			}
+			if (r.remaining() != 0 || !valid_texture(loaded)) {
+				return false;
+			}
+
+			texture = std::move(loaded);
+			return true;
+		}
+		catch (const std::exception&) {
+			// Truncated or corrupted cache, treat it as a miss
+			return false;
+		}
+	}
+
+	CompressedTexture compress_cached(const std::string& cache_directory, const DecodeRequest& texture, bool const generate_mips) {
+		std::uint64_t key;
+		{
+			util::MappedFile const source(texture.file);
+			if (!source.valid()) {
+				throw std::runtime_error("Couldn't read texture " + texture.file);
+			}
+			key = texture_cache_key(source.data(), source.size(), texture, generate_mips);
+		}
+		auto const cache_filename = texture_cache_filename(cache_directory, key);
+
+		CompressedTexture compressed;
+		if (load_texture_cache(cache_filename, key, compressed)) {
+			return compressed;
+		}
+
+		Loader image(texture.file, PixelFormat::rgba8);
+		if (!image.valid()) {
+			throw std::runtime_error("Couldn't decode texture " + texture.file);
+		}
+		if (texture.has_transparent_color) {
+			auto const& color = texture.decal_transparent_color;
+			image.applyScreendoor(color.x, color.y, color.z);
+		}
+
+		compressed = compress_texture(image, generate_mips);
+		// A failed write only costs us the speedup next time
+		save_texture_cache(cache_filename, key, compressed);
+		return compressed;
+	}
+} // namespace bve::core::image
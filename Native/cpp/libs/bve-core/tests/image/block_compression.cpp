@@ -0,0 +1,173 @@
+#include "core/image/block_compression.hpp"
+#include "core/image/texture_cache.hpp"
+#include "image/write_bmp.hpp"
+#include <cppfs/FileHandle.h>
+#include <cppfs/fs.h>
+#include <cstdlib>
+#include <cstring>
+#include <doctest/doctest.h>
+#include <fstream>
+
+using namespace std::string_literals;
+
+namespace image = bve::core::image;
+
+TEST_SUITE_BEGIN("libcore - image");
+
+namespace {
+	// Gentle gradient with an odd size, so the edge blocks and every mip level get exercised
+	std::vector<std::uint8_t> gradient(glm::ivec2 const dimensions, bool const transparent_corner) {
+		std::vector<std::uint8_t> rgba;
+		for (int y = 0; y < dimensions.y; ++y) {
+			for (int x = 0; x < dimensions.x; ++x) {
+				bool const transparent = transparent_corner && x < 4 && y < 4;
+				auto const alpha = static_cast<std::uint8_t>(transparent ? 0 : 255);
+				rgba.insert(rgba.end(), {static_cast<std::uint8_t>(64 + x * 4), static_cast<std::uint8_t>(64 + y * 3), std::uint8_t(128), //
+				                         alpha});
+			}
+		}
+		return rgba;
+	}
+
+	int max_difference(std::vector<std::uint8_t> const& lhs, std::vector<std::uint8_t> const& rhs) {
+		int difference = 0;
+		for (std::size_t i = 0; i < lhs.size(); ++i) {
+			difference = std::max(difference, std::abs(int(lhs[i]) - int(rhs[i])));
+		}
+		return difference;
+	}
+} // namespace
+
+TEST_CASE("libcore - image - block_compression - bc1") {
+	glm::ivec2 const dimensions(13, 7);
+	auto const rgba = gradient(dimensions, false);
+
+	CHECK_EQ(image::choose_block_format(rgba.data(), rgba.size() / 4), image::BlockFormat::bc1);
+
+	auto const compressed = image::compress_texture(rgba.data(), dimensions, image::BlockFormat::bc1);
+	CHECK_EQ(compressed.format, image::BlockFormat::bc1);
+	REQUIRE_EQ(compressed.levels.size(), 4);
+	CHECK_EQ(compressed.levels[0].dimensions, glm::ivec2(13, 7));
+	CHECK_EQ(compressed.levels[1].dimensions, glm::ivec2(6, 3));
+	CHECK_EQ(compressed.levels[2].dimensions, glm::ivec2(3, 1));
+	CHECK_EQ(compressed.levels[3].dimensions, glm::ivec2(1, 1));
+	// 4 x 2 blocks of 8 bytes
+	CHECK_EQ(compressed.levels[0].blocks.size(), 4 * 2 * 8);
+
+	auto const decompressed = image::decompress_level(compressed.format, compressed.levels[0]);
+	REQUIRE_EQ(decompressed.size(), rgba.size());
+	CHECK_LE(max_difference(decompressed, rgba), 6);
+}
+
+TEST_CASE("libcore - image - block_compression - bc3 keeps alpha") {
+	glm::ivec2 const dimensions(8, 8);
+	auto const rgba = gradient(dimensions, true);
+
+	REQUIRE_EQ(image::choose_block_format(rgba.data(), rgba.size() / 4), image::BlockFormat::bc3);
+
+	auto const compressed = image::compress_texture(rgba.data(), dimensions, image::BlockFormat::bc3, false);
+	REQUIRE_EQ(compressed.levels.size(), 1);
+	CHECK_EQ(compressed.levels[0].blocks.size(), 2 * 2 * 16);
+
+	auto const decompressed = image::decompress_level(compressed.format, compressed.levels[0]);
+	for (std::size_t i = 0; i < rgba.size(); i += 4) {
+		CAPTURE(i);
+		CHECK_EQ(decompressed[i + 3], rgba[i + 3]);
+	}
+	CHECK_LE(max_difference(decompressed, rgba), 6);
+}
+
+TEST_CASE("libcore - image - block_compression - cache") {
+	auto const filename = "block_compression.bmp"s;
+	image::testing::write_bmp(filename, 8, 8, gradient({8, 8}, false));
+
+	image::DecodeRequest request{filename};
+	request.has_transparent_color = true;
+	request.decal_transparent_color = {64, 64, 128};
+
+	auto const first = image::compress_cached("."s, request);
+	auto const source = cppfs::fs::open(filename).readFile();
+	auto const key = image::texture_cache_key(source.data(), source.size(), request, true);
+	auto const cache_filename = image::texture_cache_filename("."s, key);
+
+	image::CompressedTexture cached;
+	CHECK_FALSE(image::load_texture_cache(cache_filename, key + 1, cached));
+	REQUIRE(image::load_texture_cache(cache_filename, key, cached));
+	auto const second = image::compress_cached("."s, request);
+
+	cppfs::fs::open(filename).remove();
+	cppfs::fs::open(cache_filename).remove();
+
+	// the pixel at 0, 0 matches the screendoor color
+	CHECK_EQ(first.format, image::BlockFormat::bc3);
+	REQUIRE_EQ(cached.levels.size(), first.levels.size());
+	REQUIRE_EQ(second.levels.size(), first.levels.size());
+	for (std::size_t i = 0; i < first.levels.size(); ++i) {
+		CHECK_EQ(cached.levels[i].dimensions, first.levels[i].dimensions);
+		CHECK_EQ(cached.levels[i].blocks, first.levels[i].blocks);
+		CHECK_EQ(second.levels[i].blocks, first.levels[i].blocks);
+	}
+
+	CHECK_THROWS_AS(image::compress_cached("."s, image::DecodeRequest{"missing.bmp"s}), std::runtime_error);
+}
+
+TEST_CASE("libcore - image - block_compression - corrupted cache") {
+	auto const filename = "block_compression_corrupted.bmp"s;
+	image::testing::write_bmp(filename, 8, 8, gradient({8, 8}, true));
+	image::DecodeRequest const request{filename};
+
+	auto const original = image::compress_cached("."s, request);
+	REQUIRE_EQ(original.format, image::BlockFormat::bc3);
+	REQUIRE_EQ(original.levels.size(), 4);
+
+	auto const source = cppfs::fs::open(filename).readFile();
+	auto const key = image::texture_cache_key(source.data(), source.size(), request, true);
+	auto const cache_filename = image::texture_cache_filename("."s, key);
+	auto const cache = cppfs::fs::open(cache_filename).readFile();
+
+	// magic, version and key, then the format, the level count and the levels, each its dimensions, block count and blocks
+	std::size_t const format_offset = 8 + 4 + 8;
+	std::size_t const level_count_offset = format_offset + 1;
+	std::size_t const base_offset = level_count_offset + 8;
+	std::size_t const second_offset = base_offset + 8 + 8 + 4 * 16;
+
+	auto const corrupt = [&](std::size_t const offset, auto const value) {
+		auto changed = cache;
+		std::memcpy(&changed[offset], &value, sizeof(value));
+		return changed;
+	};
+	std::vector<std::string> const corrupted = {
+	    corrupt(format_offset, std::uint8_t(2)),
+	    corrupt(level_count_offset, std::uint64_t(1) << 40U),
+	    corrupt(level_count_offset, std::uint64_t(3)),
+	    // 12 wide needs more blocks than an 8 wide level has
+	    corrupt(base_offset, 12),
+	    corrupt(base_offset, 0),
+	    // the second level isn't half of the first
+	    corrupt(second_offset, 3),
+	};
+
+	for (std::size_t i = 0; i < corrupted.size(); ++i) {
+		CAPTURE(i);
+		{
+			std::ofstream file(cache_filename, std::ios::binary | std::ios::trunc);
+			file << corrupted[i];
+		}
+
+		image::CompressedTexture loaded;
+		bool hit = true;
+		CHECK_NOTHROW(hit = image::load_texture_cache(cache_filename, key, loaded));
+		CHECK_FALSE(hit);
+
+		// compress_cached compresses again and replaces the broken entry
+		auto const recompressed = image::compress_cached("."s, request);
+		REQUIRE_EQ(recompressed.levels.size(), original.levels.size());
+		CHECK_EQ(recompressed.levels[0].blocks, original.levels[0].blocks);
+		CHECK(image::load_texture_cache(cache_filename, key, loaded));
+	}
+
+	cppfs::fs::open(filename).remove();
+	cppfs::fs::open(cache_filename).remove();
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,110 @@
+#include "core/image/loader.hpp"
+#include "image/write_bmp.hpp"
+#include <EASTL/allocator_fwd.hpp>
+#include <cstring>
+#include <doctest/doctest.h>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace image = bve::core::image;
+
+TEST_SUITE_BEGIN("libcore - image");
+
+namespace {
+	class CountingAllocator final : public bve::util::Allocator {
+	  public:
+		void* allocate(std::size_t const size, int) override {
+			return allocate(size, 16, 0, 0);
+		}
+
+		void* allocate(std::size_t const size, std::size_t, std::size_t, int) override {
+			++allocations;
+			live_bytes += size;
+			return std::malloc(size);
+		}
+
+		void deallocate(void* const pointer, std::size_t const size) override {
+			live_bytes -= size;
+			std::free(pointer);
+		}
+
+		std::size_t allocations = 0;
+		std::size_t live_bytes = 0;
+	};
+
+	// 5x3 so the rows aren't a multiple of four pixels
+	std::vector<std::uint8_t> test_pixels() {
+		std::vector<std::uint8_t> pixels;
+		for (std::uint8_t i = 0; i < 15; ++i) {
+			pixels.insert(pixels.end(), {std::uint8_t(i * 17), 20, std::uint8_t(255 - i), std::uint8_t(i % 3 == 0 ? 255 : i * 10)});
+		}
+		// screendoored below
+		pixels[4 * 7 + 0] = 10;
+		pixels[4 * 7 + 1] = 20;
+		pixels[4 * 7 + 2] = 30;
+		return pixels;
+	}
+
+	constexpr std::uint8_t padding_byte = 0xCD;
+
+	image::PixelPipeline const pipeline = image::PixelPipeline().screendoor(10, 20, 30).multiply(255, 128, 64, 200);
+} // namespace
+
+TEST_CASE("libcore - image - decode_into - rgba8") {
+	auto const filename = "decode_into_rgba8.bmp"s;
+	image::testing::write_bmp(filename, 5, 3, test_pixels());
+
+	image::Loader const expected(filename, pipeline, image::PixelFormat::rgba8);
+	std::size_t const pitch = 5 * 4 + 12;
+	std::vector<std::uint8_t> buffer(pitch * 3, padding_byte);
+	CountingAllocator scratch;
+	bool const decoded = image::decode_into(filename, image::DecodeTarget{buffer.data(), pitch, {5, 3}, image::PixelFormat::rgba8},
+	                                        pipeline, &scratch);
+	cppfs::fs::open(filename).remove();
+
+	REQUIRE(decoded);
+	CHECK_GT(scratch.allocations, 0);
+	CHECK_EQ(scratch.live_bytes, 0);
+	for (std::size_t y = 0; y < 3; ++y) {
+		CAPTURE(y);
+		CHECK_EQ(std::memcmp(&buffer[y * pitch], expected.dataRGBA8() + y * 5 * 4, 5 * 4), 0);
+		CHECK_EQ(buffer[y * pitch + 5 * 4], padding_byte);
+		CHECK_EQ(buffer[y * pitch + pitch - 1], padding_byte);
+	}
+}
+
+TEST_CASE("libcore - image - decode_into - rgba32f") {
+	auto const filename = "decode_into_rgba32f.bmp"s;
+	image::testing::write_bmp(filename, 5, 3, test_pixels());
+
+	image::Loader const expected(filename, pipeline);
+	// rows 4 bytes off from 16 byte alignment
+	std::size_t const pitch = 5 * 16 + 4;
+	std::vector<std::uint8_t> buffer(pitch * 3 + 4, padding_byte);
+	bool const decoded =
+	    image::decode_into(filename, image::DecodeTarget{&buffer[4], pitch, {5, 3}, image::PixelFormat::rgba32f}, pipeline);
+	cppfs::fs::open(filename).remove();
+
+	REQUIRE(decoded);
+	for (std::size_t y = 0; y < 3; ++y) {
+		CAPTURE(y);
+		CHECK_EQ(std::memcmp(&buffer[4 + y * pitch], expected.data() + y * 5 * 4, 5 * 16), 0);
+	}
+	CHECK_EQ(buffer[0], padding_byte);
+}
+
+TEST_CASE("libcore - image - decode_into - mismatched target") {
+	auto const filename = "decode_into_mismatched.bmp"s;
+	image::testing::write_bmp(filename, 5, 3, test_pixels());
+
+	std::vector<std::uint8_t> buffer(6 * 3 * 4, padding_byte);
+	CHECK_FALSE(image::decode_into(filename, image::DecodeTarget{buffer.data(), 6 * 4, {6, 3}, image::PixelFormat::rgba8}));
+	CHECK_EQ(buffer, std::vector<std::uint8_t>(buffer.size(), padding_byte));
+	CHECK_FALSE(image::decode_into("decode_into_missing.bmp", image::DecodeTarget{buffer.data(), 6 * 4, {6, 3}}));
+	CHECK_THROWS_AS(image::decode_into(filename, image::DecodeTarget{buffer.data(), 4 * 4, {5, 3}}), std::invalid_argument);
+
+	cppfs::fs::open(filename).remove();
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,96 @@
+#include "core/image/decode_queue.hpp"
+#include "image/write_bmp.hpp"
+#include <doctest/doctest.h>
+
+using namespace std::string_literals;
+
+namespace image = bve::core::image;
+
+TEST_SUITE_BEGIN("libcore - image");
+
+TEST_CASE("libcore - image - decode_queue - deduplication") {
+	auto const filename = "decode_queue.bmp"s;
+	image::testing::write_bmp(filename, 2, 1, {1, 2, 3, 255, 4, 5, 6, 255});
+
+	image::DecodeQueue queue(2);
+
+	image::DecodeRequest plain{filename};
+	plain.format = image::PixelFormat::rgba8;
+	image::DecodeRequest doored = plain;
+	doored.has_transparent_color = true;
+	doored.decal_transparent_color = {4, 5, 6};
+
+	auto const first = queue.request(plain, 10);
+	auto const second = queue.request(plain, 5);
+	auto const screendoor = queue.request(doored);
+	auto const missing = queue.request(image::DecodeRequest{"missing.bmp"s});
+	queue.wait();
+
+	cppfs::fs::open(filename).remove();
+
+	CHECK_EQ(queue.queued(), 0);
+	REQUIRE(first.get());
+	CHECK_EQ(first.get(), second.get());
+	CHECK_NE(first.get(), screendoor.get());
+
+	REQUIRE(first.get()->valid());
+	CHECK_EQ(first.get()->dataRGBA8()[7], 255);
+	REQUIRE(screendoor.get()->valid());
+	CHECK_EQ(screendoor.get()->dataRGBA8()[3], 255);
+	CHECK_EQ(screendoor.get()->dataRGBA8()[7], 0);
+
+	CHECK_FALSE(missing.get()->valid());
+
+	// finished and still held, so it isn't decoded again
+	auto const again = queue.request(plain);
+	CHECK_EQ(again.get(), first.get());
+}
+
+TEST_CASE("libcore - image - decode_queue - many requests") {
+	std::vector<std::string> filenames;
+	for (std::size_t i = 0; i < 8; ++i) {
+		filenames.emplace_back("decode_queue_"s + std::to_string(i) + ".bmp");
+		auto const value = static_cast<std::uint8_t>(i);
+		image::testing::write_bmp(filenames.back(), 1, 1, {value, value, value, 255});
+	}
+
+	image::DecodeQueue queue(3);
+
+	std::vector<std::shared_future<image::DecodeQueue::Result>> futures;
+	for (std::size_t i = 0; i < 64; ++i) {
+		image::DecodeRequest request{filenames[i % filenames.size()]};
+		request.format = image::PixelFormat::rgba8;
+		futures.emplace_back(queue.request(request, static_cast<float>(64 - i)));
+	}
+
+	for (std::size_t i = 0; i < futures.size(); ++i) {
+		CAPTURE(i);
+		auto const& result = futures[i].get();
+		REQUIRE(result->valid());
+		CHECK_EQ(result->dataRGBA8()[0], i % filenames.size());
+		CHECK_EQ(result, futures[i % filenames.size()].get());
+	}
+
+	for (auto const& filename : filenames) {
+		cppfs::fs::open(filename).remove();
+	}
+}
+
+TEST_CASE("libcore - image - decode_queue - finished textures are forgotten") {
+	auto const filename = "decode_queue_held.bmp"s;
+	image::testing::write_bmp(filename, 1, 1, {1, 2, 3, 255});
+
+	image::DecodeQueue queue(2);
+	auto const held = queue.request(image::DecodeRequest{filename}).get();
+
+	for (std::size_t i = 0; i < 512; ++i) {
+		queue.request(image::DecodeRequest{"decode_queue_missing_"s + std::to_string(i) + ".bmp"}).get();
+		CHECK_LE(queue.tracked(), 100);
+	}
+	cppfs::fs::open(filename).remove();
+
+	// still held, so it survived every prune
+	CHECK_EQ(queue.request(image::DecodeRequest{filename}).get(), held);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,129 @@
+#include "core/image/loader.hpp"
+#include "image/write_bmp.hpp"
+#include <doctest/doctest.h>
+#include <stdexcept>
+
+using namespace std::string_literals;
+
+namespace image = bve::core::image;
+
+TEST_SUITE_BEGIN("libcore - image");
+
+namespace {
+	// Five pixels so both the four wide and the leftover code paths run
+	std::vector<std::uint8_t> const pixels{
+	    10, 20, 30, 255, //
+	    0, 0, 255, 200,  //
+	    10, 20, 30, 128, //
+	    255, 255, 255, 0, //
+	    10, 20, 30, 40,  //
+	};
+} // namespace
+
+TEST_CASE("libcore - image - loader - rgba8") {
+	auto const filename = "loader_rgba8.bmp"s;
+	image::testing::write_bmp(filename, 5, 1, pixels);
+
+	image::Loader const hdr(filename);
+	image::Loader const ldr(filename, image::PixelFormat::rgba8);
+	cppfs::fs::open(filename).remove();
+
+	REQUIRE(ldr.valid());
+	CHECK_EQ(ldr.pixelFormat(), image::PixelFormat::rgba8);
+	CHECK_EQ(ldr.dimensions(), glm::ivec2(5, 1));
+	CHECK_EQ(ldr.data(), nullptr);
+	CHECK_EQ(std::vector<std::uint8_t>(ldr.dataRGBA8(), ldr.dataRGBA8() + pixels.size()), pixels);
+
+	REQUIRE(hdr.valid());
+	CHECK_EQ(hdr.dataRGBA8(), nullptr);
+	CHECK_EQ(hdr.data()[0], image::Loader::ldr_to_hdr(10));
+}
+
+TEST_CASE("libcore - image - loader - rgba8 screendoor") {
+	auto const filename = "loader_screendoor.bmp"s;
+	image::testing::write_bmp(filename, 5, 1, pixels);
+
+	image::Loader hdr(filename);
+	image::Loader ldr(filename, image::PixelFormat::rgba8);
+	cppfs::fs::open(filename).remove();
+
+	hdr.applyScreendoor(std::uint8_t(10), std::uint8_t(20), std::uint8_t(30));
+	ldr.applyScreendoor(std::uint8_t(10), std::uint8_t(20), std::uint8_t(30));
+
+	for (std::size_t i = 0; i < 5; ++i) {
+		CAPTURE(i);
+		bool const doored = pixels[4 * i] == 10 && pixels[4 * i + 1] == 20 && pixels[4 * i + 2] == 30;
+		CHECK_EQ(ldr.dataRGBA8()[4 * i + 3], doored ? 0 : pixels[4 * i + 3]);
+		CHECK_EQ(hdr.data()[4 * i + 3] == 0, ldr.dataRGBA8()[4 * i + 3] == 0);
+		// color is left alone
+		CHECK_EQ(ldr.dataRGBA8()[4 * i], pixels[4 * i]);
+	}
+
+	CHECK_THROWS_AS(ldr.applyScreendoor(0.0F, 0.0F, 0.0F), std::logic_error);
+}
+
+TEST_CASE("libcore - image - loader - rgba8 multiply") {
+	auto const filename = "loader_multiply.bmp"s;
+	image::testing::write_bmp(filename, 5, 1, pixels);
+
+	image::Loader ldr(filename, image::PixelFormat::rgba8);
+	cppfs::fs::open(filename).remove();
+
+	std::uint8_t const factors[4] = {255, 128, 0, 77};
+	ldr.multiply(factors[0], factors[1], factors[2], factors[3]);
+
+	for (std::size_t i = 0; i < pixels.size(); ++i) {
+		CAPTURE(i);
+		auto const expected = (pixels[i] * factors[i % 4] + 127) / 255;
+		CHECK_EQ(ldr.dataRGBA8()[i], expected);
+	}
+
+	CHECK_THROWS_AS(ldr.multiply(1.0F, 1.0F, 1.0F, 1.0F), std::logic_error);
+}
+
+TEST_CASE("libcore - image - loader - fused pipeline") {
+	// more pixels than one chunk of the fused pass, and not a multiple of it
+	glm::ivec2 const dimensions(37, 29);
+	std::vector<std::uint8_t> rgba;
+	for (int i = 0; i < dimensions.x * dimensions.y; ++i) {
+		bool const doored = i % 3 == 0;
+		rgba.insert(rgba.end(), {static_cast<std::uint8_t>(doored ? 10 : i), std::uint8_t(doored ? 20 : 7), std::uint8_t(30),
+		                         static_cast<std::uint8_t>(i * 3)});
+	}
+
+	auto const filename = "loader_pipeline.bmp"s;
+	image::testing::write_bmp(filename, dimensions.x, dimensions.y, rgba);
+
+	image::PixelPipeline pipeline;
+	pipeline.screendoor(10, 20, 30).multiply(200, 128, 255, 100);
+
+	for (auto const format : {image::PixelFormat::rgba32f, image::PixelFormat::rgba8}) {
+		image::Loader sequential(filename, format);
+		sequential.applyScreendoor(std::uint8_t(10), std::uint8_t(20), std::uint8_t(30));
+		sequential.multiply(std::uint8_t(200), std::uint8_t(128), std::uint8_t(255), std::uint8_t(100));
+
+		image::Loader const fused(filename, pipeline, format);
+
+		image::Loader applied(filename, format);
+		applied.apply(pipeline);
+
+		REQUIRE(fused.valid());
+		REQUIRE(applied.valid());
+		CHECK_EQ(fused.dimensions(), dimensions);
+		auto const size = rgba.size();
+		if (format == image::PixelFormat::rgba32f) {
+			auto const expected = std::vector<float>(sequential.data(), sequential.data() + size);
+			CHECK_EQ(std::vector<float>(fused.data(), fused.data() + size), expected);
+			CHECK_EQ(std::vector<float>(applied.data(), applied.data() + size), expected);
+		}
+		else {
+			auto const expected = std::vector<std::uint8_t>(sequential.dataRGBA8(), sequential.dataRGBA8() + size);
+			CHECK_EQ(std::vector<std::uint8_t>(fused.dataRGBA8(), fused.dataRGBA8() + size), expected);
+			CHECK_EQ(std::vector<std::uint8_t>(applied.dataRGBA8(), applied.dataRGBA8() + size), expected);
+		}
+	}
+
+	cppfs::fs::open(filename).remove();
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,98 @@
+#include "core/image/mipmaps.hpp"
+#include <doctest/doctest.h>
+
+namespace image = bve::core::image;
+
+TEST_SUITE_BEGIN("libcore - image");
+
+TEST_CASE("libcore - image - mipmaps - float chain") {
+	// 3x2, every pixel's channels are its index
+	std::vector<float> rgba;
+	for (int i = 0; i < 6; ++i) {
+		rgba.insert(rgba.end(), 4, static_cast<float>(i));
+	}
+
+	auto const levels = image::generate_mips(rgba.data(), {3, 2});
+	REQUIRE_EQ(levels.size(), 1);
+	CHECK_EQ(levels[0].dimensions, glm::ivec2(1, 1));
+	// pixels 0, 1, 3 and 4
+	CHECK_EQ(levels[0].pixels[0], doctest::Approx(2.0));
+	CHECK_EQ(levels[0].pixels[3], doctest::Approx(2.0));
+
+	auto const odd = image::generate_mips(rgba.data(), {6, 1});
+	REQUIRE_EQ(odd.size(), 2);
+	CHECK_EQ(odd[0].dimensions, glm::ivec2(3, 1));
+	CHECK_EQ(odd[1].dimensions, glm::ivec2(1, 1));
+	// the missing bottom row is the top row repeated
+	CHECK_EQ(odd[0].pixels[0], doctest::Approx(0.5));
+	// halving an odd width drops the last column
+	CHECK_EQ(odd[1].pixels[0], doctest::Approx((0.5 + 2.5) / 2));
+}
+
+TEST_CASE("libcore - image - mipmaps - gamma correct") {
+	std::vector<std::uint8_t> const uniform(4 * 4 * 4, 100);
+	auto const uniform_levels = image::generate_mips(uniform.data(), {4, 4});
+	REQUIRE_EQ(uniform_levels.size(), 2);
+	for (auto const& level : uniform_levels) {
+		for (auto const value : level.pixels) {
+			CHECK_EQ(value, 100);
+		}
+	}
+
+	// half black half white averages to half the light, which is well above 128 once gamma encoded
+	std::vector<std::uint8_t> const checker{0, 0, 0, 255, 255, 255, 255, 255};
+	auto const levels = image::generate_mips(checker.data(), {2, 1});
+	REQUIRE_EQ(levels.size(), 1);
+	CHECK_GT(levels[0].pixels[0], 180);
+	CHECK_LT(levels[0].pixels[0], 190);
+	CHECK_EQ(levels[0].pixels[3], 255);
+}
+
+TEST_CASE("libcore - image - mipmaps - alpha weighted") {
+	// opaque red next to a screendoored blue
+	std::vector<std::uint8_t> const rgba{255, 0, 0, 255, 0, 0, 255, 0};
+
+	image::MipOptions weighted;
+	weighted.alpha_weighted = true;
+
+	auto const plain_levels = image::generate_mips(rgba.data(), {2, 1});
+	auto const weighted_levels = image::generate_mips(rgba.data(), {2, 1}, weighted);
+
+	REQUIRE_EQ(plain_levels.size(), 1);
+	REQUIRE_EQ(weighted_levels.size(), 1);
+	CHECK_GT(plain_levels[0].pixels[2], 0);
+	CHECK_EQ(weighted_levels[0].pixels[0], 255);
+	CHECK_EQ(weighted_levels[0].pixels[2], 0);
+	CHECK_EQ(weighted_levels[0].pixels[3], 128);
+
+	// nothing visible at all still produces something
+	std::vector<std::uint8_t> const invisible{10, 20, 30, 0, 10, 20, 30, 0};
+	auto const invisible_levels = image::generate_mips(invisible.data(), {2, 1}, weighted);
+	REQUIRE_EQ(invisible_levels.size(), 1);
+	CHECK_EQ(invisible_levels[0].pixels[0], 10);
+	CHECK_EQ(invisible_levels[0].pixels[3], 0);
+}
+
+TEST_CASE("libcore - image - mipmaps - threaded") {
+	glm::ivec2 const dimensions(67, 45);
+	std::vector<std::uint8_t> rgba;
+	for (int i = 0; i < dimensions.x * dimensions.y * 4; ++i) {
+		rgba.emplace_back(static_cast<std::uint8_t>(i * 7));
+	}
+
+	bve::util::ThreadPool pool(3);
+	image::MipOptions options;
+	options.alpha_weighted = true;
+	auto const single = image::generate_mips(rgba.data(), dimensions, options);
+	options.pool = &pool;
+	auto const threaded = image::generate_mips(rgba.data(), dimensions, options);
+
+	REQUIRE_EQ(single.size(), 6);
+	REQUIRE_EQ(threaded.size(), single.size());
+	for (std::size_t i = 0; i < single.size(); ++i) {
+		CHECK_EQ(threaded[i].dimensions, single[i].dimensions);
+		CHECK_EQ(threaded[i].pixels, single[i].pixels);
+	}
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,109 @@
+#include "core/image/probe.hpp"
+#include "image/write_bmp.hpp"
+#include <doctest/doctest.h>
+
+using namespace std::string_literals;
+
+namespace image = bve::core::image;
+
+TEST_SUITE_BEGIN("libcore - image");
+
+namespace {
+	void write_file(std::string const& filename, std::vector<std::uint8_t> const& bytes) {
+		std::unique_ptr<std::ostream> const stream = cppfs::fs::open(filename).createOutputStream();
+		stream->write(reinterpret_cast<char const*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	// Only the parts of a PNG the probe reads, CRCs and image data are garbage
+	std::vector<std::uint8_t> png_header(std::uint32_t const width,
+	                                     std::uint32_t const height,
+	                                     std::uint8_t const bit_depth,
+	                                     std::uint8_t const color_type,
+	                                     bool const transparency) {
+		std::vector<std::uint8_t> file{0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+		auto const put = [&file](std::uint32_t const value) {
+			for (std::uint32_t shift = 32; shift != 0; shift -= 8) {
+				file.emplace_back(static_cast<std::uint8_t>(value >> (shift - 8)));
+			}
+		};
+		auto const chunk = [&](char const* type, std::uint32_t const length) {
+			put(length);
+			file.insert(file.end(), type, type + 4);
+			file.resize(file.size() + length + 4);
+		};
+
+		put(13);
+		file.insert(file.end(), {'I', 'H', 'D', 'R'});
+		put(width);
+		put(height);
+		file.insert(file.end(), {bit_depth, color_type, 0, 0, 0});
+		put(0);
+
+		chunk("gAMA", 4);
+		if (transparency) {
+			chunk("tRNS", 6);
+		}
+		chunk("IDAT", 16);
+		if (!transparency) {
+			// after the image data, so it doesn't count
+			chunk("tRNS", 6);
+		}
+		chunk("IEND", 0);
+		return file;
+	}
+} // namespace
+
+TEST_CASE("libcore - image - probe - bmp") {
+	auto const filename = "probe.bmp"s;
+	image::testing::write_bmp(filename, 3, 2, std::vector<std::uint8_t>(3 * 2 * 4, 255));
+
+	auto const info = image::probe_image(filename);
+	cppfs::fs::open(filename).remove();
+
+	REQUIRE(info.valid());
+	CHECK_EQ(info.format, image::FileFormat::bmp);
+	CHECK_EQ(info.dimensions, glm::ivec2(3, 2));
+	CHECK_EQ(info.channels, 4);
+	CHECK_EQ(info.bit_depth, 8);
+}
+
+TEST_CASE("libcore - image - probe - png") {
+	auto const filename = "probe.png"s;
+
+	write_file(filename, png_header(640, 480, 16, 2, false));
+	auto info = image::probe_image(filename);
+	REQUIRE(info.valid());
+	CHECK_EQ(info.format, image::FileFormat::png);
+	CHECK_EQ(info.dimensions, glm::ivec2(640, 480));
+	CHECK_EQ(info.channels, 3);
+	CHECK_EQ(info.bit_depth, 16);
+
+	write_file(filename, png_header(1, 4096, 4, 3, true));
+	info = image::probe_image(filename);
+	REQUIRE(info.valid());
+	CHECK_EQ(info.dimensions, glm::ivec2(1, 4096));
+	CHECK_EQ(info.channels, 4);
+	CHECK_EQ(info.bit_depth, 8);
+
+	write_file(filename, png_header(16, 16, 8, 4, false));
+	info = image::probe_image(filename);
+	CHECK_EQ(info.channels, 2);
+
+	// unknown color type
+	write_file(filename, png_header(16, 16, 8, 5, false));
+	CHECK_FALSE(image::probe_image(filename).valid());
+
+	cppfs::fs::open(filename).remove();
+}
+
+TEST_CASE("libcore - image - probe - invalid") {
+	auto const filename = "probe.txt"s;
+	write_file(filename, {'n', 'o', 't', ' ', 'a', 'n', ' ', 'i', 'm', 'a', 'g', 'e'});
+
+	CHECK_FALSE(image::probe_image(filename).valid());
+	CHECK_FALSE(image::probe_image("probe_missing.png").valid());
+
+	cppfs::fs::open(filename).remove();
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,91 @@
+#include "core/image/residency.hpp"
+#include <doctest/doctest.h>
+#include <stdexcept>
+
+namespace image = bve::core::image;
+
+TEST_SUITE_BEGIN("libcore - image");
+
+TEST_CASE("libcore - image - residency - mip level sizes") {
+	CHECK_EQ(image::mip_level_sizes({4, 2}, image::PixelFormat::rgba8), std::vector<std::size_t>{32, 8, 4});
+	CHECK_EQ(image::mip_level_sizes({4, 2}, image::PixelFormat::rgba32f, false), std::vector<std::size_t>{128});
+	CHECK_EQ(image::mip_level_sizes({8, 6}, image::BlockFormat::bc1), std::vector<std::size_t>{32, 8, 8, 8});
+	CHECK_EQ(image::mip_level_sizes({1, 1}, image::BlockFormat::bc3), std::vector<std::size_t>{16});
+}
+
+TEST_CASE("libcore - image - residency - least recently used") {
+	image::ResidencyManager manager({300, 1000});
+	for (image::ResidencyManager::TextureID id = 0; id < 4; ++id) {
+		manager.registerTexture(id, {100});
+	}
+
+	CHECK_FALSE(manager.touch(0, image::Memory::cpu));
+	CHECK(manager.makeResident(0, image::Memory::cpu).empty());
+	CHECK(manager.makeResident(1, image::Memory::cpu).empty());
+	CHECK(manager.makeResident(2, image::Memory::cpu).empty());
+	manager.beginFrame();
+
+	CHECK(manager.touch(0, image::Memory::cpu));
+	manager.beginFrame();
+
+	// 1 is the oldest now that 0 was touched
+	CHECK_EQ(manager.makeResident(3, image::Memory::cpu), std::vector<image::ResidencyManager::TextureID>{1});
+	CHECK_FALSE(manager.resident(1, image::Memory::cpu));
+	CHECK_FALSE(manager.touch(1, image::Memory::cpu));
+
+	auto const& stats = manager.stats(image::Memory::cpu);
+	CHECK_EQ(stats.hits, 1);
+	CHECK_EQ(stats.misses, 2);
+	CHECK_EQ(stats.evictions, 1);
+	CHECK_EQ(stats.resident_bytes, 300);
+	CHECK_EQ(stats.resident_textures, 3);
+
+	// gpu is tracked on its own
+	CHECK_EQ(manager.stats(image::Memory::gpu).resident_bytes, 0);
+	CHECK_FALSE(manager.resident(0, image::Memory::gpu));
+
+	manager.resetCounters();
+	CHECK_EQ(stats.hits, 0);
+	CHECK_EQ(stats.resident_bytes, 300);
+}
+
+TEST_CASE("libcore - image - residency - current frame is kept") {
+	image::ResidencyManager manager({150, 150});
+	manager.registerTexture(0, {100});
+	manager.registerTexture(1, {100});
+
+	manager.makeResident(0, image::Memory::gpu);
+	// both used this frame, so the budget is exceeded instead
+	CHECK(manager.makeResident(1, image::Memory::gpu).empty());
+	CHECK_EQ(manager.stats(image::Memory::gpu).resident_bytes, 200);
+
+	manager.beginFrame();
+	manager.touch(1, image::Memory::gpu);
+	CHECK_EQ(manager.setBudget(image::Memory::gpu, 100), std::vector<image::ResidencyManager::TextureID>{0});
+	CHECK(manager.resident(1, image::Memory::gpu));
+}
+
+TEST_CASE("libcore - image - residency - farthest from camera") {
+	image::ResidencyManager manager({1000, 1000}, image::EvictionPolicy::farthest_from_camera);
+	manager.registerTexture(0, image::mip_level_sizes({8, 8}, image::PixelFormat::rgba8), {0, 0, 500});
+	manager.registerTexture(1, image::mip_level_sizes({8, 8}, image::PixelFormat::rgba8), {0, 0, 100});
+	manager.registerTexture(2, image::mip_level_sizes({8, 8}, image::PixelFormat::rgba8), {0, 0, -50});
+	CHECK_THROWS_AS(manager.makeResident(3, image::Memory::cpu), std::out_of_range);
+
+	// 256 + 64 + 16 + 4 bytes with all mips, 80 without the first
+	manager.makeResident(0, image::Memory::cpu);
+	manager.makeResident(1, image::Memory::cpu, 1);
+	manager.makeResident(2, image::Memory::cpu);
+	CHECK_EQ(manager.stats(image::Memory::cpu).resident_bytes, 340 + 84 + 340);
+	manager.beginFrame();
+
+	manager.setCameraPosition({0, 0, 400});
+	CHECK_EQ(manager.setBudget(image::Memory::cpu, 500), std::vector<image::ResidencyManager::TextureID>{2});
+
+	manager.setCameraPosition({0, 0, 0});
+	CHECK_EQ(manager.setBudget(image::Memory::cpu, 100), std::vector<image::ResidencyManager::TextureID>{0});
+	CHECK(manager.resident(1, image::Memory::cpu));
+	CHECK_EQ(manager.stats(image::Memory::cpu).evictions, 2);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cppfs/FileHandle.h>
+#include <cppfs/fs.h>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bve::core::image::testing {
+	/**
+	 * Write an uncompressed 32 bit BMP so image tests don't need files checked in.
+	 *
+	 * \param filename Path to write to.
+	 * \param width    Width in pixels.
+	 * \param height   Height in pixels.
+	 * \param rgba     width * height pixels of r, g, b, a bytes, top row first.
+	 */
+	inline void write_bmp(std::string const& filename, int const width, int const height, std::vector<std::uint8_t> const& rgba) {
+		std::uint32_t const header_size = 14 + 40;
+		std::uint32_t const image_size = static_cast<std::uint32_t>(width * height * 4);
+
+		std::vector<std::uint8_t> file;
+		auto const put = [&file](std::uint32_t const value, std::size_t const bytes) {
+			for (std::size_t i = 0; i < bytes; ++i) {
+				file.emplace_back(static_cast<std::uint8_t>(value >> (8 * i)));
+			}
+		};
+
+		// file header
+		file.emplace_back('B');
+		file.emplace_back('M');
+		put(header_size + image_size, 4);
+		put(0, 4);
+		put(header_size, 4);
+
+		// BITMAPINFOHEADER, negative height means top row first
+		put(40, 4);
+		put(static_cast<std::uint32_t>(width), 4);
+		put(static_cast<std::uint32_t>(-height), 4);
+		put(1, 2);
+		put(32, 2);
+		put(0, 4);
+		put(image_size, 4);
+		put(2835, 4);
+		put(2835, 4);
+		put(0, 4);
+		put(0, 4);
+
+		// pixels are stored b, g, r, a
+		for (std::size_t i = 0; i < rgba.size(); i += 4) {
+			file.insert(file.end(), {rgba[i + 2], rgba[i + 1], rgba[i + 0], rgba[i + 3]});
+		}
+
+		std::unique_ptr<std::ostream> const stream = cppfs::fs::open(filename).createOutputStream();
+		stream->write(reinterpret_cast<char const*>(file.data()), static_cast<std::streamsize>(file.size()));
+	}
+} // namespace bve::core::image::testing
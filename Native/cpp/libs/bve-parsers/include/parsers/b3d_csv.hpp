@@ -3,6 +3,8 @@
 #include "parsers/dependencies.hpp"
 #include "parsers/errors.hpp"
 #include "util/datatypes.hpp"
+#include <array>
+#include <cstdint>
 #include <vector>
 
 // ReSharper disable once CppInconsistentNaming
@@ -17,26 +19,89 @@ namespace bve::parsers::b3d_csv_object {
 		util::datatypes::Color8RGB emissive_color = {0, 0, 0};
 	};
 
+	// Simplified version of a mesh. Shares the vertices of its mesh, only the triangles differ.
+	struct MeshLod {
+		// Follow the same compaction as Mesh
+		std::vector<std::size_t> indices;
+		std::vector<std::uint16_t> indices_16;
+		std::vector<std::uint32_t> indices_32;
+		std::vector<FaceData> face_data;
+		// Largest root mean square distance, in meters, between a moved vertex and the surface it used to be on
+		float error = 0;
+	};
+
 	struct Mesh {
 		std::vector<Vertex> verts;
+		// Empty once the mesh has been through compact_indices, which moves them into indices_16 or indices_32
 		std::vector<std::size_t> indices;
+		std::vector<std::uint16_t> indices_16;
+		std::vector<std::uint32_t> indices_32;
 		std::vector<FaceData> face_data;
 		dependencies::Texture texture;
 		util::datatypes::Color8RGBA color = {255, 255, 255, 255};
 		enum BlendMode { normal, additive } blend_mode;
 		enum GlowAttenuationMode { divide_exponent2, divide_exponent4 } glow_attenuation_mode;
 		uint16_t glow_half_distance = 0;
+		// From most to least detailed, empty unless ParseOptions::generate_lods is set
+		std::vector<MeshLod> lods;
+	};
+
+	// Post-transform vertex cache misses of a simulated FIFO cache, before and after optimize_vertex_cache.
+	// ACMR (average cache miss ratio) is misses / triangle_count; 0.5 is the best possible for a regular grid, 3 the worst.
+	struct VertexCacheReport {
+		std::size_t triangle_count = 0;
+		std::size_t misses_before = 0;
+		std::size_t misses_after = 0;
 	};
 
 	// ReSharper disable once CppInconsistentNaming IdentifierTypo
 	struct ParsedB3DCSVObject {
 		std::vector<Mesh> meshes;
+		// summed over all meshes, only filled in when ParseOptions::optimize_vertex_cache is set
+		VertexCacheReport vertex_cache_report;
 		dependencies::Dependencies dependencies;
 		errors::Errors errors;
 	};
 
+	// Optional post-processing applied to every mesh as it is finished
+	struct ParseOptions {
+		// merge vertices that are identical after quantization
+		bool weld_vertices = false;
+		// reorder triangles for the post-transform vertex cache and vertices for fetch locality
+		bool optimize_vertex_cache = false;
+		// once the whole object is parsed, combine neighboring meshes that have identical materials
+		bool merge_meshes = false;
+		// simplified versions of every mesh at the triangle ratios in default_lod_ratios
+		bool generate_lods = false;
+		// move the indices into the smallest index type that can hold them
+		bool compact_indices = false;
+	};
+
+	// defined in b3d_csv_object/mesh_optimization.cpp
+	void weld_vertices(Mesh& mesh);
+	// These need the full size indices, so have to happen before compact_indices
+	std::size_t count_vertex_cache_misses(const Mesh& mesh);
+	VertexCacheReport optimize_vertex_cache(Mesh& mesh);
+	// Concatenates each run of neighboring meshes with the same texture, color, blend mode and glow into the first of the run, so draw
+	// order is kept.
+	// Has to happen before generate_lods.
+	void merge_meshes(std::vector<Mesh>& meshes);
+	// Compacts the lods as well
+	void compact_indices(Mesh& mesh);
+
+	// defined in b3d_csv_object/simplification.cpp
+	constexpr std::array<float, 3> default_lod_ratios = {0.5F, 0.25F, 0.1F};
+	constexpr float default_lod_max_error = 0.05F;
+	// Quadric error edge collapse down to each fraction of the original triangle count in turn. Texture seams, open borders and the
+	// edges between emissive colors are kept intact, and no collapse may cause an error over max_error times the size of the mesh's
+	// bounding box. Stops early when nothing more can be collapsed, so there may be fewer levels than ratios. Needs the full size
+	// indices.
+	std::vector<MeshLod> generate_lods(const Mesh& mesh,
+	                                   const std::vector<float>& triangle_ratios,
+	                                   float max_error = default_lod_max_error);
+
 	// defined in b3d_csv_object/parse.cpp
 	// ReSharper disable once CppInconsistentNaming
-	ParsedB3DCSVObject parse_b3d(std::string file_contents);
-	ParsedB3DCSVObject parse_csv(std::string file_contents);
+	ParsedB3DCSVObject parse_b3d(std::string file_contents, const ParseOptions& options = {});
+	ParsedB3DCSVObject parse_csv(std::string file_contents, const ParseOptions& options = {});
 } // namespace bve::parsers::b3d_csv_object
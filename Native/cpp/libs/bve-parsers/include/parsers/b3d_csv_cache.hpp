@@ -0,0 +1,27 @@
+#pragma once
+
+#include "parsers/b3d_csv.hpp"
+#include <absl/types/optional.h>
+#include <cstdint>
+#include <string>
+
+// ReSharper disable once CppInconsistentNaming
+namespace bve::parsers::b3d_csv_object {
+	enum class ObjectFormat { b3d, csv };
+
+	// defined in b3d_csv_object/cache.cpp
+	// Cache entries are content addressed: the key is a hash of the file contents, its format, the parse options and the version of the
+	// parser, so the same object used by several routes shares one entry and a parser change never picks up stale data.
+	std::uint64_t object_cache_key(const std::string& file_contents, ObjectFormat format, const ParseOptions& options);
+	std::string object_cache_filename(const std::string& cache_directory, std::uint64_t key);
+
+	// Vertex, index and face data are stored as flat arrays and copied straight out of the memory mapped file on load.
+	bool save_object_cache(const std::string& cache_filename, std::uint64_t key, const ParsedB3DCSVObject& object);
+	absl::optional<ParsedB3DCSVObject> load_object_cache(const std::string& cache_filename, std::uint64_t key);
+
+	// Load the object from cache_directory if present, otherwise parse it and add it to the cache. cache_directory must exist.
+	ParsedB3DCSVObject parse_cached(const std::string& cache_directory,
+	                                std::string file_contents,
+	                                ObjectFormat format,
+	                                const ParseOptions& options = {});
+} // namespace bve::parsers::b3d_csv_object
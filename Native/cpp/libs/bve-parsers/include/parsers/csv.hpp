@@ -19,6 +19,31 @@ namespace bve::parsers::csv {
 
 	ParsedCSV parse(const std::string& file, SplitFirstColumn sfc = SplitFirstColumn::no, char delim = ',', char split_char = ' ');
 
+	// defined in core_csv/row_reader.cpp
+	// Tokenizes the same way as parse, but one row at a time into a buffer supplied by the caller, so the whole file never exists
+	// as tokens. If comment isn't '\0', everything from it to the end of the line is ignored. The file must outlive the reader.
+	class RowReader {
+	  public:
+		explicit RowReader(const std::string& file,
+		                   SplitFirstColumn sfc = SplitFirstColumn::no,
+		                   char delim = ',',
+		                   char split_char = ' ',
+		                   char comment = '\0');
+
+		// Returns false once every row has been read
+		bool next(std::vector<CSVToken>& row);
+
+	  private:
+		const std::string& file_;
+		std::size_t position_ = 0;
+		std::size_t current_line_ = 1;
+		SplitFirstColumn sfc_;
+		char delim_;
+		char split_char_;
+		char comment_;
+		bool done_ = false;
+	};
+
 	std::ostream& operator<<(std::ostream& os, const CSVToken& rhs);
 	std::ostream& operator<<(std::ostream& os, const ParsedCSV& rhs);
 } // namespace bve::parsers::csv
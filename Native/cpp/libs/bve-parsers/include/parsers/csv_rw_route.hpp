@@ -5,6 +5,7 @@
 #include "parsers/internal/csv_rw_route/instructions.hpp"
 #include "parsers/internal/csv_rw_route/route_structure.hpp"
 #include "util/datatypes.hpp"
+#include <absl/types/optional.h>
 #include <functional>
 #include <mapbox/variant.hpp>
 #include <string>
@@ -154,6 +155,37 @@ namespace bve::parsers::csv_rw_route {
 	                                errors::MultiError& errors,
 	                                const RelativeFileFunc& get_abs_path);
 
+	// Everything placed within [start, end) of the track. Objects are ordered by track position.
+	struct RouteChunk {
+		float start = 0;
+		float end = 0;
+		std::vector<RailObjectInfo> objects;
+		std::vector<TrackLimit> limits;
+		std::vector<Section> sections;
+		std::vector<Beacon> beacons;
+	};
+
+	using RouteChunkConsumer = std::function<void(RouteChunk&& chunk)>;
+
+	// Streaming version of pass 3. Objects, limits, sections and beacons are handed to consumer in chunks of roughly chunk_length
+	// meters instead of being accumulated in rd, so their memory use no longer scales with the length of the route. Everything else
+	// still ends up in rd.
+	void execute_instructions_pass3(ParsedRoute& rd,
+	                                InstructionList& list,
+	                                errors::MultiError& errors,
+	                                const RelativeFileFunc& get_abs_path,
+	                                float chunk_length,
+	                                const RouteChunkConsumer& consumer);
+
+	// defined in csv_rw_route/cache.cpp
+	// The cache records the size and content hash of every file in lines.filenames. A load only succeeds if all of them are unchanged.
+	// $Rnd is not part of the key: a route using it will keep loading with the values chosen when the cache was written.
+	bool save_route_cache(const std::string& cache_filename,
+	                      const ParsedRoute& route,
+	                      const errors::MultiError& errors,
+	                      const PreprocessedLines& lines);
+	absl::optional<ParsedRoute> load_route_cache(const std::string& cache_filename, errors::MultiError& errors);
+
 } // namespace bve::parsers::csv_rw_route
 
 std::ostream& operator<<(std::ostream& os, const bve::parsers::csv_rw_route::Instruction& i);
@@ -4,7 +4,8 @@
 #include "parsers/xml/dynamic_lighting.hpp"
 #include "parsers/xml/route_marker.hpp"
 #include "parsers/xml/stations.hpp"
-#include <set>
+#include "util/math.hpp"
+#include "util/string_interner.hpp"
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -24,13 +25,35 @@ namespace bve::parsers::csv_rw_route {
 			glm::vec3 direction{};
 			bool valid = false;
 		} cache;
+
+		// Derived from cache at the end of pass 2, lets evaluate_block place things without re-deriving the turning circle.
+		struct CurveParameters {
+			// center of the turning circle, or the start of the block on straight track
+			glm::vec3 center{};
+			// normalized direction of travel on straight track
+			glm::vec3 straight_direction{0, 0, 1};
+			// angle of the start of the block on the turning circle
+			float start_angle = 0;
+			float abs_radius = 0;
+			// 1 for curves to the right, -1 for curves to the left
+			float side = 1;
+			// height gained and ground covered per meter traveled
+			float pitch_slope = 0;
+			float horizontal_factor = 1;
+			float direction_length = 1;
+			// rotation about the direction of travel caused by cant, positive leaning into curves to the right
+			float cant_angle = 0;
+			float cant_sin = 0;
+			float cant_cos = 1;
+		} curve;
 	};
 
-	using FilenameSet = std::set<std::string>;
-	using FilenameSetIterator = std::set<std::string>::const_iterator;
+	// Filenames are interned, objects refer to them by their index in the corresponding ParsedRoute table
+	using FilenameSet = util::StringInterner;
+	using FilenameID = FilenameSet::ID;
 
 	struct RailObjectInfo {
-		FilenameSetIterator filename;
+		FilenameID filename = FilenameSet::invalid_id;
 		glm::vec3 position{};
 		glm::vec3 rotation{};
 		bool flip_x = false;
@@ -79,8 +102,8 @@ namespace bve::parsers::csv_rw_route {
 	struct RailStation {
 		xml::stations::RequestStopMarker request_stop_info;
 		std::string name;
-		FilenameSetIterator arrival_sound;
-		FilenameSetIterator departure_sound;
+		FilenameID arrival_sound = FilenameSet::invalid_id;
+		FilenameID departure_sound = FilenameSet::invalid_id;
 		std::size_t timetable_index = 0;
 		std::vector<RailStationStop> stop_points;
 		util::datatypes::Time arrival{};
@@ -144,12 +167,12 @@ namespace bve::parsers::csv_rw_route {
 	struct Announcement {
 		float position{};
 		float speed = 0;
-		FilenameSetIterator filename;
+		FilenameID filename = FilenameSet::invalid_id;
 	};
 
 	struct Sound {
 		glm::vec3 position{};
-		FilenameSetIterator filename;
+		FilenameID filename = FilenameSet::invalid_id;
 	};
 
 	template <class T, std::intmax_t Def>
@@ -190,7 +213,7 @@ namespace bve::parsers::csv_rw_route {
 		// Speed limits
 		std::vector<TrackLimit> limits;
 
-		// file references
+		// file references, indexed by FilenameID
 		FilenameSet object_filenames;
 		FilenameSet texture_filenames;
 		FilenameSet sound_filenames;
@@ -241,4 +264,27 @@ namespace bve::parsers::csv_rw_route {
 		float pressure = 101.325F;
 		float altitude = 0;
 	};
+
+	// defined in csv_rw_route/route_queries.cpp
+	// gauge is in millimeters, like cant
+	void calculate_curve_parameters(RailBlockInfo& block, float gauge);
+	// Same result as util::math::evaluate_curve on the block's cache, distance is relative to the start of the block
+	util::math::EvaluateCurveState evaluate_block(const RailBlockInfo& block, float distance);
+
+	// Ground height is linearly interpolated between Track.Height commands and held constant past the first and last.
+	float ground_height_at(const ParsedRoute& route, float position);
+
+	// Ground height lookup for callers that walk along the track. Remembers the last segment, so queries near the previous one are
+	// O(1); big jumps fall back to a binary search. The route must outlive the cursor.
+	class GroundHeightCursor {
+	  public:
+		explicit GroundHeightCursor(const ParsedRoute& route) : table_(&route.ground_height) {}
+
+		float at(float position);
+
+	  private:
+		const std::vector<GroundHeight>* table_;
+		// invariant: (*table_)[index_].position <= position of last in-range query
+		std::size_t index_ = 0;
+	};
 } // namespace bve::parsers::csv_rw_route
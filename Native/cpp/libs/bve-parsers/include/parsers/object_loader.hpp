@@ -0,0 +1,37 @@
+#pragma once
+
+#include "parsers/animated.hpp"
+#include "parsers/b3d_csv.hpp"
+#include "parsers/errors.hpp"
+#include "parsers/find_relative_file.hpp"
+#include "util/string_interner.hpp"
+#include <mapbox/variant.hpp>
+#include <string>
+#include <vector>
+
+namespace bve::parsers::object_loader {
+	// The file couldn't be loaded, the reason is in LoadedObject::errors
+	struct NoObject {};
+
+	using Object = mapbox::util::variant<NoObject, b3d_csv_object::ParsedB3DCSVObject, animated_object::ParsedAnimatedObject>;
+
+	struct LoadedObject {
+		// Filename after going through the RelativeFileFunc
+		std::string path;
+		Object object;
+		// Problems with the file itself, like it missing or having an unknown extension. Errors in its contents are in the object.
+		errors::Errors errors;
+	};
+
+	// defined in object_loader/load_objects.cpp
+	// Parses every file in filenames on a pool of thread_count threads, 0 meaning one per hardware thread. The result at index i is
+	// the file with ID i, so a ParsedRoute's FilenameIDs index straight into it. Files are resolved with get_abs_path(base_file, name),
+	// which gets called from the worker threads. Objects included by animated objects aren't loaded.
+	// When cache_directory isn't empty, B3D and CSV objects go through the object cache in that directory.
+	std::vector<LoadedObject> load_objects(const util::StringInterner& filenames,
+	                                       const std::string& base_file,
+	                                       const RelativeFileFunc& get_abs_path,
+	                                       const b3d_csv_object::ParseOptions& options = {},
+	                                       std::size_t thread_count = 0,
+	                                       const std::string& cache_directory = {});
+} // namespace bve::parsers::object_loader
@@ -6,6 +6,7 @@
 #include "parsers/errors.hpp"
 #include "parsers/find_relative_file.hpp"
 #include "parsers/function_scripts.hpp"
+#include "parsers/object_loader.hpp"
 #include "parsers/xml/dynamic_background.hpp"
 #include "parsers/xml/dynamic_lighting.hpp"
 #include "parsers/xml/route_marker.hpp"
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "parsers/b3d_csv.hpp"
+#include "parsers/find_relative_file.hpp"
+#include "parsers/internal/csv_rw_route/route_structure.hpp"
+#include "parsers/object_loader.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace bve::parsers::static_batching {
+	// Range of StaticBatches::indices drawn with one material. Indices are absolute into StaticBatches::vertices.
+	struct Batch {
+		// file is resolved against the object that uses it, empty when untextured
+		dependencies::Texture texture;
+		util::datatypes::Color8RGBA color = {255, 255, 255, 255};
+		b3d_csv_object::Mesh::BlendMode blend_mode = b3d_csv_object::Mesh::BlendMode::normal;
+		b3d_csv_object::Mesh::GlowAttenuationMode glow_attenuation_mode = b3d_csv_object::Mesh::GlowAttenuationMode::divide_exponent4;
+		std::uint16_t glow_half_distance = 0;
+
+		std::uint32_t first_index = 0;
+		std::uint32_t index_count = 0;
+	};
+
+	// Square world space cell, x and z in [cell * chunk_length, (cell + 1) * chunk_length). Owns batches
+	// [first_batch, first_batch + batch_count) and the world space bounds of their vertices.
+	struct Chunk {
+		std::int32_t cell_x = 0;
+		std::int32_t cell_z = 0;
+		glm::vec3 min{};
+		glm::vec3 max{};
+		std::uint32_t first_batch = 0;
+		std::uint32_t batch_count = 0;
+	};
+
+	struct StaticBatches {
+		// world space
+		std::vector<b3d_csv_object::Vertex> vertices;
+		std::vector<std::uint32_t> indices;
+		std::vector<b3d_csv_object::FaceData> face_data;
+		std::vector<Batch> batches;
+		std::vector<Chunk> chunks;
+		// Placements that couldn't be baked as they aren't static B3D/CSV objects, by index into the input. They still have to
+		// be drawn individually.
+		std::vector<std::size_t> unbatched_objects;
+	};
+
+	// defined in static_batching/build_batches.cpp
+	// Bakes every placement of a B3D/CSV object into world space meshes, one per material per chunk. Placements are assigned to a chunk by
+	// their position, so an object is never split between chunks. Chunks are ordered by cell. objects is indexed by FilenameID, as
+	// returned by object_loader::load_objects. Textures are resolved with get_abs_path(object path, texture), so objects in different
+	// folders that name the same texture file don't share a batch.
+	// A placement's rotation is applied as yaw (y), then pitch (x), then roll (z), in radians. flip_x mirrors the object along x.
+	StaticBatches build_static_batches(const std::vector<csv_rw_route::RailObjectInfo>& placements,
+	                                   const std::vector<object_loader::LoadedObject>& objects,
+	                                   const RelativeFileFunc& get_abs_path,
+	                                   float chunk_length = 500);
+} // namespace bve::parsers::static_batching
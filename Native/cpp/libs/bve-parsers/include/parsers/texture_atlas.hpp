@@ -0,0 +1,66 @@
+#pragma once
+
+#include "parsers/b3d_csv.hpp"
+#include "parsers/dependencies.hpp"
+#include <cstdint>
+#include <functional>
+#include <glm/vec2.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace bve::parsers::texture_atlas {
+	struct AtlasInput {
+		dependencies::Texture texture;
+		// Size of the image in pixels, which the parsers can't know on their own
+		glm::ivec2 dimensions{};
+	};
+
+	struct AtlasOptions {
+		// Size of every page
+		glm::ivec2 page_size{2048, 2048};
+		// Pixels of edge color repeated around every texture, so filtering and mips don't pick up the neighbors
+		int padding = 4;
+		// Textures larger than this in either direction are left out, atlasing them gains nothing
+		int max_texture_size = 256;
+		// Pages are called page_prefix followed by their index
+		std::string page_prefix = "atlas:";
+	};
+
+	struct Placement {
+		std::size_t page = 0;
+		// pixel position of the texture itself inside the page, padding not included
+		glm::ivec2 position{};
+		glm::ivec2 size{};
+		// atlas uv = uv_offset + texture uv * uv_scale
+		glm::vec2 uv_offset{};
+		glm::vec2 uv_scale{};
+	};
+
+	struct Atlas {
+		AtlasOptions options;
+		// The texture meshes use to refer to each page. Screendoor colors are baked into the pages, so these have none.
+		std::vector<dependencies::Texture> pages;
+		std::map<dependencies::Texture, Placement> placements;
+		// Inputs that didn't get a place, because they're too big or have no size
+		std::vector<dependencies::Texture> unplaced;
+	};
+
+	// defined in texture_atlas/pack.cpp
+	// Skyline bottom-left packing, tallest textures first, opening a new page whenever a texture doesn't fit the current ones.
+	Atlas pack_atlas(std::vector<AtlasInput> textures, const AtlasOptions& options = {});
+
+	// 8 bit RGBA pixels of a texture with its screendoor already applied, top row first, or nullptr if it couldn't be loaded.
+	using PixelSource = std::function<const std::uint8_t*(const dependencies::Texture& texture)>;
+
+	// Builds the RGBA pixels of one page, filling the padding of every texture with its edge pixels. Textures whose pixels are
+	// missing are left transparent black.
+	std::vector<std::uint8_t> compose_page(const Atlas& atlas, std::size_t page, const PixelSource& get_pixels);
+
+	// Point the mesh at its atlas page and remap its texture coordinates. Meshes whose texture isn't in the atlas, or whose coordinates
+	// leave [0, 1] and so depend on the texture repeating, are left alone. Returns if the mesh was changed.
+	bool remap_texture_coords(b3d_csv_object::Mesh& mesh, const Atlas& atlas);
+
+	// remap_texture_coords on every mesh, updating the object's dependencies to match. Returns the amount of meshes changed.
+	std::size_t remap_texture_coords(b3d_csv_object::ParsedB3DCSVObject& object, const Atlas& atlas);
+} // namespace bve::parsers::texture_atlas
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "parsers/b3d_csv.hpp"
+#include "parsers/csv.hpp"
+#include <absl/types/optional.h>
 #include <iosfwd>
 #include <mapbox/variant.hpp>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -210,6 +213,7 @@ namespace bve::parsers::b3d_csv_object {
 
 		struct ParsedCSVObjectBuilder {
 			ParsedB3DCSVObject pso;
+			ParseOptions options;
 
 			// More data is needed for the faces before we convert them to
 			// internal format all of this data has to be consistent within an
@@ -231,12 +235,20 @@ namespace bve::parsers::b3d_csv_object {
 			struct UntriangulatedFace {
 				std::vector<std::size_t> indices;
 				ExtendedFaceData data;
+				// indices is already a list of triangles. Primitives are added as one of these, so they don't need a vector per face.
+				bool pretriangulated = false;
 			};
 
 			std::vector<Vertex> vertices;
 			std::vector<UntriangulatedFace> untriangulated_faces;
 
+			// (cos, sin) of every step around a circle, by amount of steps
+			std::unordered_map<std::size_t, std::vector<glm::vec2>> unit_circles;
+			const std::vector<glm::vec2>& unitCircle(std::size_t steps);
+
 			void addMeshBuilder();
+			// Adds the final mesh builder and applies the whole object post-processing
+			void finish();
 
 			void operator()(const Error& arg);
 			void operator()(const CreateMeshBuilder& arg);
@@ -285,7 +297,12 @@ namespace bve::parsers::b3d_csv_object {
 		csv
 	};
 
+	// defined in b3d_csv_object/instruction_generator.cpp
+	// Turns a single tokenized row into an instruction. Rows that don't produce an instruction give nullopt. Lowercases the command.
+	absl::optional<Instruction> create_instruction(std::vector<csv::CSVToken>& row, FileType ft);
+	// Whole file at once, the instruction list is kept around for diagnostics and tests
 	InstructionList create_instructions(std::string text, FileType ft);
 
-	ParsedB3DCSVObject run_csv_instructions(const InstructionList& /*ilist*/);
+	// defined in b3d_csv_object/executor.cpp
+	ParsedB3DCSVObject run_csv_instructions(const InstructionList& /*ilist*/, const ParseOptions& options = {});
 } // namespace bve::parsers::b3d_csv_object
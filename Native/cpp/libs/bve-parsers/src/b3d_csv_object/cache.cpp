@@ -0,0 +1,214 @@
+#include "parsers/b3d_csv_cache.hpp"
+#include "util/binary_io.hpp"
+#include "util/content_hash.hpp"
+#include "util/mapped_file.hpp"
+#include <array>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+// ReSharper disable once CppInconsistentNaming
+namespace bve::parsers::b3d_csv_object {
+	namespace {
+		using util::binary::Reader;
+		using util::binary::Writer;
+
+		using Magic = std::array<char, 8>;
+		constexpr Magic cache_magic = {'B', 'V', 'E', 'O', 'B', 'J', 'C', 'T'};
+		// Bump whenever the serialized layout of ParsedB3DCSVObject changes
+		constexpr std::uint32_t cache_version = 2;
+		// Bump whenever the parser produces different output for the same file. Part of the key, so old entries are simply never hit.
+		constexpr std::uint32_t parser_version = 2;
+
+		using Fingerprint = std::array<std::uint32_t, 3>;
+		constexpr Fingerprint layout_fingerprint = {sizeof(Vertex), sizeof(FaceData), sizeof(std::size_t)};
+
+		void write_mesh(Writer& w, const Mesh& mesh) {
+			w.writeArray(mesh.verts);
+			w.writeArray(mesh.indices);
+			w.writeArray(mesh.indices_16);
+			w.writeArray(mesh.indices_32);
+			w.writeArray(mesh.face_data);
+			w.writeString(mesh.texture.file);
+			w.write(mesh.texture.decal_transparent_color);
+			w.write(mesh.texture.has_transparent_color);
+			w.write(mesh.color);
+			w.write<std::uint8_t>(mesh.blend_mode);
+			w.write<std::uint8_t>(mesh.glow_attenuation_mode);
+			w.write(mesh.glow_half_distance);
+
+			w.write<std::uint64_t>(mesh.lods.size());
+			for (auto& lod : mesh.lods) {
+				w.writeArray(lod.indices);
+				w.writeArray(lod.indices_16);
+				w.writeArray(lod.indices_32);
+				w.writeArray(lod.face_data);
+				w.write(lod.error);
+			}
+		}
+
+		template <class Enum>
+		Enum read_enum(Reader& r, Enum const last) {
+			auto const value = r.read<std::uint8_t>();
+			if (value > last) {
+				throw std::out_of_range("Invalid enum in cached object");
+			}
+			return static_cast<Enum>(value);
+		}
+
+		void read_mesh(Reader& r, Mesh& mesh) {
+			r.readArray(mesh.verts);
+			r.readArray(mesh.indices);
+			r.readArray(mesh.indices_16);
+			r.readArray(mesh.indices_32);
+			r.readArray(mesh.face_data);
+			mesh.texture.file = r.readString();
+			mesh.texture.decal_transparent_color = r.read<util::datatypes::Color8RGB>();
+			mesh.texture.has_transparent_color = r.readBool();
+			mesh.color = r.read<util::datatypes::Color8RGBA>();
+			mesh.blend_mode = read_enum(r, Mesh::additive);
+			mesh.glow_attenuation_mode = read_enum(r, Mesh::divide_exponent4);
+			mesh.glow_half_distance = r.read<std::uint16_t>();
+
+			// every lod holds at least its index counts
+			mesh.lods.resize(r.readCount(sizeof(std::uint64_t)));
+			for (auto& lod : mesh.lods) {
+				r.readArray(lod.indices);
+				r.readArray(lod.indices_16);
+				r.readArray(lod.indices_32);
+				r.readArray(lod.face_data);
+				lod.error = r.read<float>();
+			}
+		}
+
+		void write_object(Writer& w, const ParsedB3DCSVObject& object) {
+			w.write<std::uint64_t>(object.meshes.size());
+			for (auto& mesh : object.meshes) {
+				write_mesh(w, mesh);
+			}
+
+			w.write<std::uint64_t>(object.vertex_cache_report.triangle_count);
+			w.write<std::uint64_t>(object.vertex_cache_report.misses_before);
+			w.write<std::uint64_t>(object.vertex_cache_report.misses_after);
+
+			w.write<std::uint64_t>(object.dependencies.textures.size());
+			for (auto& texture : object.dependencies.textures) {
+				w.writeString(texture.file);
+				w.write(texture.decal_transparent_color);
+				w.write(texture.has_transparent_color);
+			}
+
+			w.write<std::uint64_t>(object.errors.size());
+			for (auto& error : object.errors) {
+				w.write(error.line);
+				w.writeString(error.error);
+			}
+		}
+
+		void read_object(Reader& r, ParsedB3DCSVObject& object) {
+			// every mesh holds at least its vertex count
+			object.meshes.resize(r.readCount(sizeof(std::uint64_t)));
+			for (auto& mesh : object.meshes) {
+				read_mesh(r, mesh);
+			}
+
+			object.vertex_cache_report.triangle_count = r.read<std::uint64_t>();
+			object.vertex_cache_report.misses_before = r.read<std::uint64_t>();
+			object.vertex_cache_report.misses_after = r.read<std::uint64_t>();
+
+			auto const texture_count = r.readCount(sizeof(std::uint64_t));
+			for (std::size_t i = 0; i < texture_count; ++i) {
+				dependencies::Texture texture;
+				texture.file = r.readString();
+				texture.decal_transparent_color = r.read<util::datatypes::Color8RGB>();
+				texture.has_transparent_color = r.readBool();
+				object.dependencies.textures.insert(std::move(texture));
+			}
+
+			auto const error_count = r.readCount(sizeof(std::intmax_t) + sizeof(std::uint64_t));
+			for (std::size_t i = 0; i < error_count; ++i) {
+				errors::Error error;
+				error.line = r.read<std::intmax_t>();
+				error.error = r.readString();
+				object.errors.emplace_back(std::move(error));
+			}
+		}
+	} // namespace
+
+	std::uint64_t object_cache_key(const std::string& file_contents, ObjectFormat const format, const ParseOptions& options) {
+		std::array<std::uint8_t, 7> const settings = {
+		    static_cast<std::uint8_t>(format),
+		    static_cast<std::uint8_t>(options.weld_vertices),
+		    static_cast<std::uint8_t>(options.optimize_vertex_cache),
+		    static_cast<std::uint8_t>(options.merge_meshes),
+		    static_cast<std::uint8_t>(options.generate_lods),
+		    static_cast<std::uint8_t>(options.compact_indices),
+		    static_cast<std::uint8_t>(parser_version),
+		};
+
+		auto const hash = util::hash::content_hash(settings.data(), settings.size());
+		return util::hash::content_hash(file_contents, hash);
+	}
+
+	std::string object_cache_filename(const std::string& cache_directory, std::uint64_t const key) {
+		std::ostringstream filename;
+		filename << cache_directory << '/' << std::hex << std::setw(16) << std::setfill('0') << key << ".bveobj";
+		return filename.str();
+	}
+
+	bool save_object_cache(const std::string& cache_filename, std::uint64_t const key, const ParsedB3DCSVObject& object) {
+		Writer w;
+
+		w.write(cache_magic);
+		w.write(cache_version);
+		w.write(layout_fingerprint);
+		w.write(key);
+
+		write_object(w, object);
+
+		return w.saveToFile(cache_filename);
+	}
+
+	absl::optional<ParsedB3DCSVObject> load_object_cache(const std::string& cache_filename, std::uint64_t const key) {
+		util::MappedFile const cache(cache_filename);
+		if (!cache.valid()) {
+			return absl::nullopt;
+		}
+
+		Reader r(cache.data(), cache.size());
+
+		try {
+			if (r.read<Magic>() != cache_magic || r.read<std::uint32_t>() != cache_version
+			    || r.read<Fingerprint>() != layout_fingerprint || r.read<std::uint64_t>() != key) {
+				return absl::nullopt;
+			}
+
+			ParsedB3DCSVObject object;
+			read_object(r, object);
+			return object;
+		}
+		catch (const std::exception&) {
+			// Truncated or corrupted cache, treat it as a miss. parse_cached then overwrites it with a fresh entry.
+			return absl::nullopt;
+		}
+	}
+
+	ParsedB3DCSVObject parse_cached(const std::string& cache_directory,
+	                                std::string file_contents,
+	                                ObjectFormat const format,
+	                                const ParseOptions& options) {
+		auto const key = object_cache_key(file_contents, format, options);
+		auto const cache_filename = object_cache_filename(cache_directory, key);
+
+		auto cached = load_object_cache(cache_filename, key);
+		if (cached) {
+			return std::move(*cached);
+		}
+
+		auto object = format == ObjectFormat::b3d ? parse_b3d(std::move(file_contents), options)
+		                                          : parse_csv(std::move(file_contents), options);
+		// A failed write only costs us the speedup next time
+		save_object_cache(cache_filename, key, object);
+		return object;
+	}
+} // namespace bve::parsers::b3d_csv_object
@@ -1,8 +1,13 @@
 #include "b3d_csv_object.hpp"
+#include "util/string_interner.hpp"
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <glm/gtx/component_wise.hpp>
 #include <glm/gtx/rotate_vector.hpp>
 #include <sstream>
+#include <stdexcept>
+#include <unordered_map>
 
 // ReSharper disable once CppInconsistentNaming
 #define _USE_MATH_DEFINES
@@ -11,79 +16,82 @@
 // ReSharper disable once CppInconsistentNaming
 namespace bve::parsers::b3d_csv_object {
 	namespace {
-		// Following
-		// https://stackoverflow.com/questions/3574680/sort-based-on-multiple-things-in-c
-		// Sort based on properties to get all faces with same properties next
-		// to each other
-		bool sort_function(const instructions::ParsedCSVObjectBuilder::UntriangulatedFace& face1,
-		                   const instructions::ParsedCSVObjectBuilder::UntriangulatedFace& face2) {
-			auto& data1 = face1.data;
-			auto& data2 = face2.data;
-
-			if (data1.texture < data2.texture) {
-				return true;
-			}
-			if (data2.texture > data1.texture) {
-				return false;
-			}
-
-			// Need to create an order, though the order doesn't matter as long
-			// as they are not equal
-			auto const dtc_equal = data1.decal_transparent_color == data2.decal_transparent_color;
-			auto const dtc_a = compAdd(data1.decal_transparent_color);
-			auto const dtc_b = compAdd(data2.decal_transparent_color);
-			if (!dtc_equal && dtc_a < dtc_b) {
-				return true;
-			}
-			if (!dtc_equal && dtc_a >= dtc_b) {
-				return false;
-			}
-
-			if (static_cast<int>(data1.has_decal_transparent_color) < static_cast<int>(data2.has_decal_transparent_color)) {
-				return true;
-			}
-			if (static_cast<int>(data2.has_decal_transparent_color) > static_cast<int>(data1.has_decal_transparent_color)) {
-				return false;
-			}
-
-			// blend mode integer
-			auto const bmi_a = std::underlying_type<decltype(data1.blend_mode)>::type(data1.blend_mode);
-			auto const bmi_b = std::underlying_type<decltype(data2.blend_mode)>::type(data2.blend_mode);
-			if (bmi_a < bmi_b) {
-				return true;
-			}
-			if (bmi_b > bmi_a) {
-				return false;
-			}
+		using FaceTraits = instructions::ParsedCSVObjectBuilder::ExtendedFaceData;
+		using KeyedFace = std::pair<std::uint64_t, std::size_t>;
+
+		// Faces end up in the same mesh when their 64-bit material keys are equal. From most to least significant bit:
+		//   [63, 50] texture state id  [49] blend mode  [48] glow attenuation mode  [47, 32] glow half distance  [31, 0] color
+		// The texture state (file, decal color and whether the decal color is used) is interned per mesh builder, so a handful of
+		// bits is plenty for it.
+		constexpr std::uint64_t texture_state_bits = 14;
+		constexpr std::size_t max_texture_states = std::size_t(1) << texture_state_bits;
+
+		class TextureStateInterner {
+		  public:
+			std::uint64_t insert(const FaceTraits& data) {
+				auto const file = std::uint64_t(files_.insert(data.texture));
+				auto const decal = std::uint64_t(data.decal_transparent_color.x) << 16U
+				                   | std::uint64_t(data.decal_transparent_color.y) << 8U
+				                   | std::uint64_t(data.decal_transparent_color.z);
+				auto const state = file << 25U | std::uint64_t(data.has_decal_transparent_color) << 24U | decal;
+
+				auto const found = states_.find(state);
+				if (found != states_.end()) {
+					return found->second;
+				}
+				if (states_.size() == max_texture_states) {
+					throw std::length_error("Too many distinct textures in a single mesh builder");
+				}
+				auto const id = std::uint64_t(states_.size());
+				states_.emplace(state, id);
+				return id;
+			}
+
+		  private:
+			util::StringInterner files_;
+			std::unordered_map<std::uint64_t, std::uint64_t> states_;
+		};
+
+		std::uint64_t material_key(const FaceTraits& data, std::uint64_t const texture_state) {
+			using BlendModeInt = std::underlying_type<decltype(data.blend_mode)>::type;
+			using GlowModeInt = std::underlying_type<decltype(data.glow_attenuation_mode)>::type;
+
+			return texture_state << 50U                                                     //
+			       | std::uint64_t(BlendModeInt(data.blend_mode) != 0) << 49U               //
+			       | std::uint64_t(GlowModeInt(data.glow_attenuation_mode) != 0) << 48U     //
+			       | std::uint64_t(data.glow_half_distance) << 32U                          //
+			       | std::uint64_t(data.color.x) << 24U | std::uint64_t(data.color.y) << 16U //
+			       | std::uint64_t(data.color.z) << 8U | std::uint64_t(data.color.w);
+		}
 
-			// glow attenuation mode integer
-			auto const gam_a = std::underlying_type<decltype(data1.glow_attenuation_mode)>::type(data1.glow_attenuation_mode);
-			auto const gam_b = std::underlying_type<decltype(data2.glow_attenuation_mode)>::type(data2.glow_attenuation_mode);
-			if (gam_a < gam_b) {
-				return true;
-			}
-			if (gam_b > gam_a) {
-				return false;
+		// Stable LSD radix sort on the key, a byte at a time. Bytes that are equal across all keys are skipped, which is most of them,
+		// as a mesh builder rarely has more than a couple of materials.
+		void radix_sort(std::vector<KeyedFace>& faces) {
+			if (faces.empty()) {
+				return;
 			}
 
-			if (data1.glow_half_distance < data2.glow_half_distance) {
-				return true;
-			}
-			if (data2.glow_half_distance < data1.glow_half_distance) {
-				return false;
-			}
+			std::vector<KeyedFace> scratch(faces.size());
+			for (std::uint64_t shift = 0; shift < 64; shift += 8) {
+				std::array<std::size_t, 256> offsets{};
+				for (auto const& face : faces) {
+					++offsets[(face.first >> shift) & 0xFFU];
+				}
+				if (offsets[(faces.front().first >> shift) & 0xFFU] == faces.size()) {
+					continue;
+				}
 
-			auto const c_equal = data1.color == data2.color;
-			auto const c_a = compAdd(data1.color);
-			auto const c_b = compAdd(data2.color);
-			if (!c_equal && c_a < c_b) {
-				return true;
-			}
-			if (!c_equal && c_a >= c_b) {
-				return false;
+				std::size_t offset = 0;
+				for (auto& bucket : offsets) {
+					auto const count = bucket;
+					bucket = offset;
+					offset += count;
+				}
+				for (auto const& face : faces) {
+					scratch[offsets[(face.first >> shift) & 0xFFU]++] = face;
+				}
+				std::swap(faces, scratch);
 			}
-
-			return false;
 		}
 
 		void calculate_normals(Mesh& mesh) {
@@ -139,6 +147,42 @@ namespace bve::parsers::b3d_csv_object {
 			return face_count;
 		}
 
+		std::size_t copy_triangles(std::vector<std::size_t>& output_list, const std::vector<std::size_t>& triangles, bool const two_sided) {
+			auto const face_count = triangles.size() / 3 * (two_sided ? 2 : 1);
+			output_list.reserve(output_list.size() + face_count * 3);
+
+			for (std::size_t i = 0; i + 2 < triangles.size(); i += 3) {
+				output_list.insert(output_list.end(), triangles.begin() + static_cast<std::ptrdiff_t>(i),
+				                   triangles.begin() + static_cast<std::ptrdiff_t>(i + 3));
+
+				if (two_sided) {
+					output_list.emplace_back(triangles[i + 2]);
+					output_list.emplace_back(triangles[i + 1]);
+					output_list.emplace_back(triangles[i + 0]);
+				}
+			}
+
+			return face_count;
+		}
+
+		// Grow geometrically even when the final size is known, so a long run of primitives doesn't reallocate on every one
+		template <class T>
+		void reserve_additional(std::vector<T>& vector, std::size_t const additional) {
+			auto const needed = vector.size() + additional;
+			if (needed > vector.capacity()) {
+				vector.reserve(std::max(needed, vector.capacity() * 2));
+			}
+		}
+
+		// Splits the quad a, b, c, d the same way triangulate_faces would
+		void add_quad(std::vector<std::size_t>& triangles,
+		              std::size_t const a,
+		              std::size_t const b,
+		              std::size_t const c,
+		              std::size_t const d) {
+			triangles.insert(triangles.end(), {a, b, c, a, c, d});
+		}
+
 		std::vector<Vertex> shrink_vertex_list(const std::vector<Vertex>& vertices, std::vector<std::size_t>& indices) {
 			std::vector<std::size_t> translation(vertices.size(), 0);
 			std::vector<bool> use_vertex(vertices.size(), false);
@@ -190,53 +234,51 @@ namespace bve::parsers::b3d_csv_object {
 	} // namespace
 
 	void instructions::ParsedCSVObjectBuilder::addMeshBuilder() {
-		// sort to keep faces with identical traits together
-		std::sort(untriangulated_faces.begin(), untriangulated_faces.end(), sort_function);
-
 		// check for an empty mesh
 		if (untriangulated_faces.empty()) {
 			return;
 		}
 
+		// sort to keep faces with identical traits together
+		TextureStateInterner texture_states;
+		std::vector<KeyedFace> keyed_faces;
+		keyed_faces.reserve(untriangulated_faces.size());
+		for (std::size_t i = 0; i < untriangulated_faces.size(); ++i) {
+			auto const& data = untriangulated_faces[i].data;
+			keyed_faces.emplace_back(material_key(data, texture_states.insert(data)), i);
+		}
+		radix_sort(keyed_faces);
+
 		// find the next mesh with different traits
 		// then copy turn all the in-between meshes into internal format
-		auto begin = untriangulated_faces.begin();
-		auto const end = untriangulated_faces.end();
+		auto begin = keyed_faces.cbegin();
+		auto const end = keyed_faces.cend();
 		while (true) {
-			auto const cmp_func = [&begin](const UntriangulatedFace& face) -> bool {
-				auto const tex_same = begin->data.texture == face.data.texture;
-				auto const c_same = begin->data.color == face.data.color;
-				auto const dtc_same = begin->data.decal_transparent_color == face.data.decal_transparent_color;
-				auto const has_decal_color = begin->data.has_decal_transparent_color == face.data.has_decal_transparent_color;
-				auto const blend_same = begin->data.blend_mode == face.data.blend_mode;
-				auto const glow_same = begin->data.glow_attenuation_mode == face.data.glow_attenuation_mode;
-				auto const glow_half = begin->data.glow_half_distance == face.data.glow_half_distance;
-
-				return !(tex_same && c_same && dtc_same && has_decal_color && blend_same && glow_same && glow_half);
-			};
-
-			auto const next_face = std::find_if(begin, end, cmp_func);
+			auto const next_face = std::find_if(begin, end, [&begin](const KeyedFace& face) { return face.first != begin->first; });
+			auto const& traits = untriangulated_faces[begin->second].data;
 
 			Mesh mesh;
 			dependencies::Texture tex;
 
 			// apply properties to the texture
-			tex.file = begin->data.texture;
-			tex.decal_transparent_color = begin->data.decal_transparent_color;
-			tex.has_transparent_color = begin->data.has_decal_transparent_color;
+			tex.file = traits.texture;
+			tex.decal_transparent_color = traits.decal_transparent_color;
+			tex.has_transparent_color = traits.has_decal_transparent_color;
 
 			// properties that must be the same for all faces in an internal
 			// mesh
 			mesh.texture = tex;
-			mesh.color = begin->data.color;
-			mesh.blend_mode = begin->data.blend_mode;
-			mesh.glow_attenuation_mode = begin->data.glow_attenuation_mode;
-			mesh.glow_half_distance = begin->data.glow_half_distance;
+			mesh.color = traits.color;
+			mesh.blend_mode = traits.blend_mode;
+			mesh.glow_attenuation_mode = traits.glow_attenuation_mode;
+			mesh.glow_half_distance = traits.glow_half_distance;
 			mesh.texture = tex;
 
 			// Add faces and apply properties that can change per face
-			std::for_each(begin, next_face, [&mesh](UntriangulatedFace& face) {
-				auto const count = triangulate_faces(mesh.indices, face.indices, face.data.back_visible);
+			std::for_each(begin, next_face, [this, &mesh](const KeyedFace& keyed_face) {
+				auto const& face = untriangulated_faces[keyed_face.second];
+				auto const count = face.pretriangulated ? copy_triangles(mesh.indices, face.indices, face.data.back_visible)
+				                                        : triangulate_faces(mesh.indices, face.indices, face.data.back_visible);
 				for (std::size_t i = 0; i < count; ++i) {
 					mesh.face_data.emplace_back(FaceData{face.data.emissive_color});
 				}
@@ -250,6 +292,16 @@ namespace bve::parsers::b3d_csv_object {
 
 			calculate_normals(mesh);
 
+			if (options.weld_vertices) {
+				weld_vertices(mesh);
+			}
+			if (options.optimize_vertex_cache) {
+				auto const report = optimize_vertex_cache(mesh);
+				pso.vertex_cache_report.triangle_count += report.triangle_count;
+				pso.vertex_cache_report.misses_before += report.misses_before;
+				pso.vertex_cache_report.misses_after += report.misses_after;
+			}
+
 			pso.meshes.emplace_back(std::move(mesh));
 			pso.dependencies.textures.insert(std::move(tex));
 
@@ -265,6 +317,26 @@ namespace bve::parsers::b3d_csv_object {
 		untriangulated_faces.clear();
 	}
 
+	void instructions::ParsedCSVObjectBuilder::finish() {
+		addMeshBuilder();
+
+		// the whole object stages all work on the full size indices, so compacting comes last
+		if (options.merge_meshes) {
+			merge_meshes(pso.meshes);
+		}
+		if (options.generate_lods) {
+			std::vector<float> const ratios(default_lod_ratios.begin(), default_lod_ratios.end());
+			for (auto& mesh : pso.meshes) {
+				mesh.lods = generate_lods(mesh, ratios);
+			}
+		}
+		if (options.compact_indices) {
+			for (auto& mesh : pso.meshes) {
+				compact_indices(mesh);
+			}
+		}
+	}
+
 	void instructions::ParsedCSVObjectBuilder::operator()(const Error& arg) {
 		add_error(pso.errors, arg.line, arg.cause);
 	}
@@ -294,12 +366,25 @@ namespace bve::parsers::b3d_csv_object {
 		untriangulated_faces.back().data.back_visible = arg.side_count == Sides::two;
 	}
 
+	const std::vector<glm::vec2>& instructions::ParsedCSVObjectBuilder::unitCircle(std::size_t const steps) {
+		auto& circle = unit_circles[steps];
+		if (circle.size() != steps) {
+			circle.resize(steps);
+			for (std::size_t i = 0; i < steps; ++i) {
+				auto const angle = 2 * static_cast<float>(M_PI) * static_cast<float>(i) / static_cast<float>(steps);
+				circle[i] = glm::vec2(std::cos(angle), std::sin(angle));
+			}
+		}
+		return circle;
+	}
+
 	void instructions::ParsedCSVObjectBuilder::operator()(const Cube& arg) {
 		// http://openbve-project.net/documentation/HTML/object_cubecylinder.html
 		// Pre cube size
 		auto const v = vertices.size();
 
 		// Create vertices
+		reserve_additional(vertices, 8);
 		vertices.emplace_back(Vertex{glm::vec3(arg.half_width, arg.half_height, -arg.half_depth)});
 		vertices.emplace_back(Vertex{glm::vec3(arg.half_width, -arg.half_height, -arg.half_depth)});
 		vertices.emplace_back(Vertex{glm::vec3(-arg.half_width, -arg.half_height, -arg.half_depth)});
@@ -309,13 +394,17 @@ namespace bve::parsers::b3d_csv_object {
 		vertices.emplace_back(Vertex{glm::vec3(-arg.half_width, -arg.half_height, arg.half_depth)});
 		vertices.emplace_back(Vertex{glm::vec3(-arg.half_width, arg.half_height, arg.half_depth)});
 
-		// Create faces
-		untriangulated_faces.emplace_back(UntriangulatedFace{std::vector<std::size_t>{v + 0, v + 1, v + 2, v + 3}, {}});
-		untriangulated_faces.emplace_back(UntriangulatedFace{std::vector<std::size_t>{v + 0, v + 4, v + 5, v + 1}, {}});
-		untriangulated_faces.emplace_back(UntriangulatedFace{std::vector<std::size_t>{v + 0, v + 3, v + 7, v + 4}, {}});
-		untriangulated_faces.emplace_back(UntriangulatedFace{std::vector<std::size_t>{v + 6, v + 5, v + 4, v + 7}, {}});
-		untriangulated_faces.emplace_back(UntriangulatedFace{std::vector<std::size_t>{v + 6, v + 7, v + 3, v + 2}, {}});
-		untriangulated_faces.emplace_back(UntriangulatedFace{std::vector<std::size_t>{v + 6, v + 2, v + 1, v + 5}, {}});
+		// Create faces, six quads of two triangles
+		UntriangulatedFace faces;
+		faces.pretriangulated = true;
+		faces.indices.reserve(6 * 2 * 3);
+		add_quad(faces.indices, v + 0, v + 1, v + 2, v + 3);
+		add_quad(faces.indices, v + 0, v + 4, v + 5, v + 1);
+		add_quad(faces.indices, v + 0, v + 3, v + 7, v + 4);
+		add_quad(faces.indices, v + 6, v + 5, v + 4, v + 7);
+		add_quad(faces.indices, v + 6, v + 7, v + 3, v + 2);
+		add_quad(faces.indices, v + 6, v + 2, v + 1, v + 5);
+		untriangulated_faces.emplace_back(std::move(faces));
 	}
 
 	void instructions::ParsedCSVObjectBuilder::operator()(const Cylinder& arg) {
@@ -330,30 +419,31 @@ namespace bve::parsers::b3d_csv_object {
 		auto& r2 = arg.lower_radius;
 		auto& h = arg.height;
 
+		if (n == 0) {
+			return;
+		}
+
 		// Add vertices
+		auto const& circle = unitCircle(n);
+		reserve_additional(vertices, 2 * n);
 		for (std::size_t i = 0; i < n; ++i) {
-			vertices.emplace_back(
-			    Vertex{glm::vec3{std::cos(2 * static_cast<float>(M_PI) * static_cast<float>(i) / static_cast<float>(n)) * r1, //
-			                     h / 2,                                                                                       //
-			                     std::sin(2 * static_cast<float>(M_PI) * static_cast<float>(i) / static_cast<float>(n)) * r1}});
-
-			vertices.emplace_back(
-			    Vertex{glm::vec3{std::cos(2 * static_cast<float>(M_PI) * static_cast<float>(i) / static_cast<float>(n)) * r2, //
-			                     -h / 2,                                                                                      //
-			                     std::sin(2 * static_cast<float>(M_PI) * static_cast<float>(i) / static_cast<float>(n)) * r2}});
+			vertices.emplace_back(Vertex{glm::vec3{circle[i].x * r1, h / 2, circle[i].y * r1}});
+			vertices.emplace_back(Vertex{glm::vec3{circle[i].x * r2, -h / 2, circle[i].y * r2}});
 		}
 
-		// Add Faces
+		// Add Faces, one quad per side, the last one wrapping around to the first vertices
+		UntriangulatedFace faces;
+		faces.pretriangulated = true;
+		faces.indices.reserve(n * 2 * 3);
 		for (std::size_t i = 0; i < n; ++i) {
 			if (i != n - 1) {
-				untriangulated_faces.emplace_back(
-				    UntriangulatedFace{std::vector<std::size_t>{v + (2 * i + 2), v + (2 * i + 3), v + (2 * i + 1), v + (2 * i + 0)}, {}});
+				add_quad(faces.indices, v + (2 * i + 2), v + (2 * i + 3), v + (2 * i + 1), v + (2 * i + 0));
 			}
 			else {
-				untriangulated_faces.emplace_back(
-				    UntriangulatedFace{std::vector<std::size_t>{v + 0, v + 1, v + (2 * i + 1), v + (2 * i + 0)}, {}});
+				add_quad(faces.indices, v + 0, v + 1, v + (2 * i + 1), v + (2 * i + 0));
 			}
 		}
+		untriangulated_faces.emplace_back(std::move(faces));
 	}
 
 	void instructions::ParsedCSVObjectBuilder::operator()(const Translate& arg) {
@@ -490,13 +580,13 @@ namespace bve::parsers::b3d_csv_object {
 		}
 	}
 
-	ParsedB3DCSVObject run_csv_instructions(const InstructionList& ilist) {
+	ParsedB3DCSVObject run_csv_instructions(const InstructionList& ilist, const ParseOptions& options) {
 		instructions::ParsedCSVObjectBuilder parsed_csv_object_builder;
+		parsed_csv_object_builder.options = options;
 		for (auto& inst : ilist) {
 			apply_visitor(parsed_csv_object_builder, inst);
 		}
-		// Add final mesh builder
-		parsed_csv_object_builder.addMeshBuilder();
+		parsed_csv_object_builder.finish();
 		return parsed_csv_object_builder.pso;
 	}
 } // namespace bve::parsers::b3d_csv_object
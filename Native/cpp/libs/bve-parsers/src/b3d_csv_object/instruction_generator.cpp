@@ -414,6 +414,38 @@ namespace bve::parsers::b3d_csv_object {
 		};
 	} // namespace
 
+	absl::optional<Instruction> create_instruction(std::vector<csv::CSVToken>& row, FileType const ft) {
+		if (row.empty() || row[0].text.empty()) {
+			return absl::nullopt;
+		}
+		if (ft == FileType::b3d && util::parsers::match_against_lower(row[0].text, "[texture]")) {
+			return absl::nullopt;
+		}
+		if (ft == FileType::csv && util::parsers::match_against_lower(row[0].text, "generatenormals")) {
+			return absl::nullopt;
+		}
+
+		Instruction ins;
+		util::parsers::lower(row[0].text);
+		auto const found_func = function_mapping.find(row[0].text);
+		if (found_func == function_mapping.end()) {
+			ins = instructions::Error{"Function \""s + row[0].text + "\" not found"s};
+		}
+		else {
+			try {
+				ins = found_func->second(row);
+			}
+			catch (const std::invalid_argument& e) {
+				ins = instructions::Error{e.what()};
+			}
+		}
+
+		// Set line number for appropriate debugging help
+		apply_visitor([&row](auto& x) { x.line = row[0].line_begin; }, ins);
+
+		return ins;
+	}
+
 	InstructionList create_instructions(std::string text, FileType const ft) {
 		InstructionList il;
 
@@ -422,37 +454,12 @@ namespace bve::parsers::b3d_csv_object {
 		auto csv = parse(text, ft == FileType::b3d ? csv::SplitFirstColumn::yes : csv::SplitFirstColumn::no);
 
 		for (auto& row : csv) {
-			if (row.empty() || row[0].text.empty()) {
-				continue;
+			auto ins = create_instruction(row, ft);
+			if (ins) {
+				il.emplace_back(std::move(*ins));
 			}
-			if (ft == FileType::b3d && util::parsers::match_against_lower(row[0].text, "[texture]")) {
-				continue;
-			}
-			if (ft == FileType::csv && util::parsers::match_against_lower(row[0].text, "generatenormals")) {
-				continue;
-			}
-
-			Instruction ins;
-			util::parsers::lower(row[0].text);
-			auto const found_func = function_mapping.find(row[0].text);
-			if (found_func == function_mapping.end()) {
-				ins = instructions::Error{"Function \""s + row[0].text + "\" not found"s};
-			}
-			else {
-				try {
-					ins = found_func->second(row);
-				}
-				catch (const std::invalid_argument& e) {
-					ins = instructions::Error{e.what()};
-				}
-			}
-
-			// Set line number for appropriate debugging help
-			apply_visitor([&row](auto& x) { x.line = row[0].line_begin; }, ins);
-
-			il.emplace_back(std::move(ins));
 		}
 
 		return il;
-	} // namespace b3d_csv_object
+	}
 } // namespace bve::parsers::b3d_csv_object
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "parsers/b3d_csv.hpp"
+#include <cstdint>
+#include <string>
+#include <tuple>
+
+// ReSharper disable once CppInconsistentNaming
+namespace bve::parsers::b3d_csv_object {
+	// Everything that has to be identical for two meshes to be drawn in the same call
+	using MaterialKey = std::tuple<std::string, std::uint32_t, bool, std::uint32_t, int, int, std::uint16_t>;
+
+	inline MaterialKey material_key(const Mesh& mesh) {
+		auto const& decal = mesh.texture.decal_transparent_color;
+		auto const decal_rgb = std::uint32_t(decal.x) << 16U | std::uint32_t(decal.y) << 8U | std::uint32_t(decal.z);
+		auto const color = std::uint32_t(mesh.color.x) << 24U | std::uint32_t(mesh.color.y) << 16U | std::uint32_t(mesh.color.z) << 8U
+		                   | std::uint32_t(mesh.color.w);
+
+		return MaterialKey{mesh.texture.file,    decal_rgb, mesh.texture.has_transparent_color, color, int(mesh.blend_mode),
+		                   int(mesh.glow_attenuation_mode), mesh.glow_half_distance};
+	}
+} // namespace bve::parsers::b3d_csv_object
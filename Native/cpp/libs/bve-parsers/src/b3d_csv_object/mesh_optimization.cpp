@@ -0,0 +1,346 @@
+#include "material_key.hpp"
+#include "parsers/b3d_csv.hpp"
+#include "util/content_hash.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+// ReSharper disable once CppInconsistentNaming
+namespace bve::parsers::b3d_csv_object {
+	namespace {
+		// Vertices closer than this in every attribute are merged. Object files are authored in meters, so positions are welded at
+		// a tenth of a millimeter.
+		constexpr float position_step = 1e-4F;
+		constexpr float normal_step = 1e-3F;
+		constexpr float texture_coord_step = 1e-5F;
+
+		struct QuantizedVertex {
+			std::array<std::int32_t, 8> values;
+
+			friend bool operator==(const QuantizedVertex& lhs, const QuantizedVertex& rhs) {
+				return lhs.values == rhs.values;
+			}
+		};
+
+		struct QuantizedVertexHash {
+			std::size_t operator()(const QuantizedVertex& qv) const noexcept {
+				return static_cast<std::size_t>(util::hash::content_hash(qv.values.data(), sizeof(qv.values)));
+			}
+		};
+
+		std::int32_t quantize(float const value, float const step) {
+			return static_cast<std::int32_t>(std::lround(value / step));
+		}
+
+		// Size of the FIFO cache used to measure the result. Conservative compared to current hardware, so improvements carry over.
+		constexpr std::size_t measured_cache_size = 16;
+
+		// Tuning of Tom Forsyth's "Linear-Speed Vertex Cache Optimisation", using his published constants. The optimizer models an
+		// LRU cache, which also does well on FIFO hardware.
+		constexpr std::size_t modeled_cache_size = 32;
+		constexpr float cache_decay_power = 1.5F;
+		constexpr float last_triangle_score = 0.75F;
+		constexpr float valence_boost_scale = 2.0F;
+		constexpr float valence_boost_power = 0.5F;
+
+		float vertex_score(std::intmax_t const cache_position, std::size_t const remaining_triangles) {
+			if (remaining_triangles == 0) {
+				// no triangle needs this vertex anymore
+				return -1;
+			}
+
+			float score = 0;
+			if (cache_position >= 0) {
+				if (cache_position < 3) {
+					// used by the last triangle, fixed score so the next triangle doesn't only favor strips
+					score = last_triangle_score;
+				}
+				else {
+					auto const scale = 1.0F / static_cast<float>(modeled_cache_size - 3);
+					score = std::pow(1.0F - static_cast<float>(cache_position - 3) * scale, cache_decay_power);
+				}
+			}
+
+			// favor vertices with few triangles left, so lone triangles don't get stranded
+			score += valence_boost_scale * std::pow(static_cast<float>(remaining_triangles), -valence_boost_power);
+
+			return score;
+		}
+
+		QuantizedVertex quantize(const Vertex& v) {
+			return QuantizedVertex{{
+			    quantize(v.position.x, position_step),
+			    quantize(v.position.y, position_step),
+			    quantize(v.position.z, position_step),
+			    quantize(v.normal.x, normal_step),
+			    quantize(v.normal.y, normal_step),
+			    quantize(v.normal.z, normal_step),
+			    quantize(v.texture_coord.x, texture_coord_step),
+			    quantize(v.texture_coord.y, texture_coord_step),
+			}};
+		}
+
+		void compact_indices(std::vector<std::size_t>& indices,
+		                     std::vector<std::uint16_t>& indices_16,
+		                     std::vector<std::uint32_t>& indices_32,
+		                     std::size_t const vertex_count) {
+			if (indices.empty()) {
+				return;
+			}
+
+			if (vertex_count < std::size_t(std::numeric_limits<std::uint16_t>::max()) + 1) {
+				indices_16.resize(indices.size());
+				std::transform(indices.begin(), indices.end(), indices_16.begin(),
+				               [](std::size_t const index) { return static_cast<std::uint16_t>(index); });
+			}
+			else {
+				indices_32.resize(indices.size());
+				std::transform(indices.begin(), indices.end(), indices_32.begin(),
+				               [](std::size_t const index) { return static_cast<std::uint32_t>(index); });
+			}
+
+			indices.clear();
+			indices.shrink_to_fit();
+		}
+	} // namespace
+
+	void weld_vertices(Mesh& mesh) {
+		// Needs the full size indices, nothing to do once they have been compacted
+		if (mesh.indices.empty()) {
+			return;
+		}
+
+		std::unordered_map<QuantizedVertex, std::size_t, QuantizedVertexHash> lookup;
+		lookup.reserve(mesh.verts.size());
+
+		std::vector<Vertex> welded;
+		std::vector<std::size_t> remap(mesh.verts.size());
+
+		for (std::size_t i = 0; i < mesh.verts.size(); ++i) {
+			auto const result = lookup.emplace(quantize(mesh.verts[i]), welded.size());
+			if (result.second) {
+				welded.emplace_back(mesh.verts[i]);
+			}
+			remap[i] = result.first->second;
+		}
+
+		for (auto& index : mesh.indices) {
+			index = remap[index];
+		}
+
+		mesh.verts = std::move(welded);
+	}
+
+	std::size_t count_vertex_cache_misses(const Mesh& mesh) {
+		std::array<std::size_t, measured_cache_size> cache{};
+		std::size_t cache_fill = 0;
+		std::size_t cache_head = 0;
+		std::size_t misses = 0;
+
+		for (auto const index : mesh.indices) {
+			auto const end = cache.begin() + static_cast<std::ptrdiff_t>(cache_fill);
+			if (std::find(cache.begin(), end, index) != end) {
+				continue;
+			}
+			++misses;
+			cache[cache_head] = index;
+			cache_head = (cache_head + 1) % measured_cache_size;
+			cache_fill = std::min(cache_fill + 1, measured_cache_size);
+		}
+
+		return misses;
+	}
+
+	VertexCacheReport optimize_vertex_cache(Mesh& mesh) {
+		VertexCacheReport report;
+		report.triangle_count = mesh.indices.size() / 3;
+		report.misses_before = count_vertex_cache_misses(mesh);
+
+		auto const triangle_count = report.triangle_count;
+		auto const vertex_count = mesh.verts.size();
+
+		if (triangle_count == 0) {
+			report.misses_after = report.misses_before;
+			return report;
+		}
+
+		// Triangles using each vertex, flattened: vertex v owns the range [triangle_offset[v], triangle_offset[v] + remaining[v])
+		std::vector<std::size_t> remaining(vertex_count, 0);
+		for (auto const index : mesh.indices) {
+			++remaining[index];
+		}
+		std::vector<std::size_t> triangle_offset(vertex_count + 1, 0);
+		for (std::size_t v = 0; v < vertex_count; ++v) {
+			triangle_offset[v + 1] = triangle_offset[v] + remaining[v];
+		}
+		std::vector<std::size_t> vertex_triangles(mesh.indices.size());
+		{
+			std::vector<std::size_t> fill(triangle_offset.begin(), triangle_offset.end() - 1);
+			for (std::size_t i = 0; i < mesh.indices.size(); ++i) {
+				vertex_triangles[fill[mesh.indices[i]]++] = i / 3;
+			}
+		}
+
+		std::vector<std::intmax_t> cache_position(vertex_count, -1);
+		std::vector<float> scores(vertex_count);
+		for (std::size_t v = 0; v < vertex_count; ++v) {
+			scores[v] = vertex_score(-1, remaining[v]);
+		}
+
+		std::vector<float> triangle_scores(triangle_count);
+		std::vector<bool> emitted(triangle_count, false);
+		for (std::size_t t = 0; t < triangle_count; ++t) {
+			triangle_scores[t] = scores[mesh.indices[t * 3]] + scores[mesh.indices[t * 3 + 1]] + scores[mesh.indices[t * 3 + 2]];
+		}
+
+		// three extra slots for the vertices pushed out by the triangle being added
+		std::vector<std::size_t> cache;
+		std::vector<std::size_t> new_cache;
+		cache.reserve(modeled_cache_size + 3);
+		new_cache.reserve(modeled_cache_size + 3);
+
+		std::vector<std::size_t> order;
+		order.reserve(triangle_count);
+
+		auto best_triangle = std::max_element(triangle_scores.begin(), triangle_scores.end()) - triangle_scores.begin();
+		std::size_t scan_cursor = 0;
+
+		while (order.size() < triangle_count) {
+			auto const triangle = static_cast<std::size_t>(best_triangle);
+			emitted[triangle] = true;
+			order.emplace_back(triangle);
+
+			// put the triangle's vertices at the front of the cache, the rest keep their order
+			new_cache.clear();
+			for (std::size_t i = 0; i < 3; ++i) {
+				auto const v = mesh.indices[triangle * 3 + i];
+				new_cache.emplace_back(v);
+
+				// remove the triangle from the vertex's list
+				auto const begin = vertex_triangles.begin() + static_cast<std::ptrdiff_t>(triangle_offset[v]);
+				auto const end = begin + static_cast<std::ptrdiff_t>(remaining[v]);
+				std::iter_swap(std::find(begin, end, triangle), end - 1);
+				--remaining[v];
+			}
+			for (auto const v : cache) {
+				if (std::find(new_cache.begin(), new_cache.begin() + 3, v) == new_cache.begin() + 3) {
+					new_cache.emplace_back(v);
+				}
+			}
+			std::swap(cache, new_cache);
+
+			// rescore everything that was in the cache, including what just fell out of it
+			for (std::size_t i = 0; i < cache.size(); ++i) {
+				auto const v = cache[i];
+				cache_position[v] = i < modeled_cache_size ? static_cast<std::intmax_t>(i) : -1;
+				scores[v] = vertex_score(cache_position[v], remaining[v]);
+			}
+
+			// the best next triangle is almost always one touching the cache
+			float best_score = -1;
+			for (auto const v : cache) {
+				auto const begin = vertex_triangles.begin() + static_cast<std::ptrdiff_t>(triangle_offset[v]);
+				auto const end = begin + static_cast<std::ptrdiff_t>(remaining[v]);
+				for (auto it = begin; it != end; ++it) {
+					auto const t = *it;
+					triangle_scores[t] = scores[mesh.indices[t * 3]] + scores[mesh.indices[t * 3 + 1]] + scores[mesh.indices[t * 3 + 2]];
+					if (triangle_scores[t] > best_score) {
+						best_score = triangle_scores[t];
+						best_triangle = static_cast<std::ptrdiff_t>(t);
+					}
+				}
+			}
+
+			if (cache.size() > modeled_cache_size) {
+				cache.resize(modeled_cache_size);
+			}
+
+			// nothing connected to the cache, continue with the next unused triangle
+			if (best_score < 0 && order.size() < triangle_count) {
+				while (emitted[scan_cursor]) {
+					++scan_cursor;
+				}
+				best_triangle = static_cast<std::ptrdiff_t>(scan_cursor);
+			}
+		}
+
+		// apply the triangle order
+		std::vector<std::size_t> new_indices;
+		new_indices.reserve(mesh.indices.size());
+		for (auto const triangle : order) {
+			new_indices.insert(new_indices.end(), mesh.indices.begin() + static_cast<std::ptrdiff_t>(triangle * 3),
+			                   mesh.indices.begin() + static_cast<std::ptrdiff_t>(triangle * 3 + 3));
+		}
+		if (mesh.face_data.size() == triangle_count) {
+			std::vector<FaceData> new_face_data;
+			new_face_data.reserve(triangle_count);
+			for (auto const triangle : order) {
+				new_face_data.emplace_back(mesh.face_data[triangle]);
+			}
+			mesh.face_data = std::move(new_face_data);
+		}
+
+		// renumber vertices in order of first use so vertex fetch walks memory linearly
+		constexpr auto unassigned = std::numeric_limits<std::size_t>::max();
+		std::vector<std::size_t> remap(vertex_count, unassigned);
+		std::vector<Vertex> new_verts;
+		new_verts.reserve(vertex_count);
+		for (auto& index : new_indices) {
+			if (remap[index] == unassigned) {
+				remap[index] = new_verts.size();
+				new_verts.emplace_back(mesh.verts[index]);
+			}
+			index = remap[index];
+		}
+		// unreferenced vertices keep their relative order at the end
+		for (std::size_t v = 0; v < vertex_count; ++v) {
+			if (remap[v] == unassigned) {
+				new_verts.emplace_back(mesh.verts[v]);
+			}
+		}
+
+		mesh.indices = std::move(new_indices);
+		mesh.verts = std::move(new_verts);
+
+		report.misses_after = count_vertex_cache_misses(mesh);
+		return report;
+	}
+
+	void merge_meshes(std::vector<Mesh>& meshes) {
+		// Only neighbors are merged. Meshes are drawn in file order, so moving one past a mesh with a different material would change
+		// how overlapping transparent faces blend.
+		std::vector<Mesh> merged;
+		merged.reserve(meshes.size());
+		MaterialKey last_key;
+
+		for (auto& mesh : meshes) {
+			auto key = material_key(mesh);
+			if (merged.empty() || key != last_key) {
+				last_key = std::move(key);
+				merged.emplace_back(std::move(mesh));
+				continue;
+			}
+
+			auto& destination = merged.back();
+			auto const base = destination.verts.size();
+
+			destination.verts.insert(destination.verts.end(), mesh.verts.begin(), mesh.verts.end());
+			destination.indices.reserve(destination.indices.size() + mesh.indices.size());
+			for (auto const index : mesh.indices) {
+				destination.indices.emplace_back(base + index);
+			}
+			destination.face_data.insert(destination.face_data.end(), mesh.face_data.begin(), mesh.face_data.end());
+		}
+
+		meshes = std::move(merged);
+	}
+
+	void compact_indices(Mesh& mesh) {
+		compact_indices(mesh.indices, mesh.indices_16, mesh.indices_32, mesh.verts.size());
+		for (auto& lod : mesh.lods) {
+			compact_indices(lod.indices, lod.indices_16, lod.indices_32, mesh.verts.size());
+		}
+	}
+} // namespace bve::parsers::b3d_csv_object
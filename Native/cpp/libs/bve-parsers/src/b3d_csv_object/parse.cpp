@@ -1,19 +1,39 @@
 #include "b3d_csv_object.hpp"
 #include "parsers/b3d_csv.hpp"
+#include "parsers/csv.hpp"
 #include "util/parsing.hpp"
 
 // ReSharper disable once CppInconsistentNaming
 namespace bve::parsers::b3d_csv_object {
+	namespace {
+		// Tokenizes and executes one row at a time, so neither the tokens nor the instructions for the whole file are ever stored.
+		// Produces the same result as run_csv_instructions(create_instructions(...)).
+		ParsedB3DCSVObject parse_streaming(const std::string& file_contents, FileType const ft, const ParseOptions& options) {
+			instructions::ParsedCSVObjectBuilder parsed_csv_object_builder;
+			parsed_csv_object_builder.options = options;
+
+			csv::RowReader reader(file_contents, ft == FileType::b3d ? csv::SplitFirstColumn::yes : csv::SplitFirstColumn::no, ',', ' ',
+			                      ';');
+			std::vector<csv::CSVToken> row;
+
+			while (reader.next(row)) {
+				auto const inst = create_instruction(row, ft);
+				if (inst) {
+					apply_visitor(parsed_csv_object_builder, *inst);
+				}
+			}
+
+			parsed_csv_object_builder.finish();
+			return std::move(parsed_csv_object_builder.pso);
+		}
+	} // namespace
+
 	// ReSharper disable once CppInconsistentNaming
-	ParsedB3DCSVObject parse_b3d(std::string file_contents) {
-		auto const inst = create_instructions(file_contents, FileType::b3d);
-		auto object = run_csv_instructions(inst);
-		return object;
+	ParsedB3DCSVObject parse_b3d(std::string file_contents, const ParseOptions& options) {
+		return parse_streaming(file_contents, FileType::b3d, options);
 	}
 
-	ParsedB3DCSVObject parse_csv(std::string file_contents) {
-		auto const inst = create_instructions(file_contents, FileType::csv);
-		auto object = run_csv_instructions(inst);
-		return object;
+	ParsedB3DCSVObject parse_csv(std::string file_contents, const ParseOptions& options) {
+		return parse_streaming(file_contents, FileType::csv, options);
 	}
 } // namespace bve::parsers::b3d_csv_object
@@ -0,0 +1,405 @@
+#include "parsers/b3d_csv.hpp"
+#include "util/content_hash.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <queue>
+#include <set>
+#include <unordered_map>
+
+// ReSharper disable once CppInconsistentNaming
+namespace bve::parsers::b3d_csv_object {
+	namespace {
+		// Error quadric of Garland and Heckbert. Symmetric 4x4 matrix, only the upper triangle is stored:
+		// a² ab ac ad b² bc bd c² cd d²
+		// Planes are weighted by the area of their triangle, the total weight is kept so the error can be turned back into a distance.
+		struct Quadric {
+			std::array<double, 10> m{};
+			double weight = 0;
+
+			static Quadric fromPlane(glm::vec3 const& normal, float const distance, double const weight) {
+				double const a = normal.x;
+				double const b = normal.y;
+				double const c = normal.z;
+				double const d = distance;
+
+				Quadric q;
+				q.m = {a * a, a * b, a * c, a * d, b * b, b * c, b * d, c * c, c * d, d * d};
+				for (auto& value : q.m) {
+					value *= weight;
+				}
+				q.weight = weight;
+				return q;
+			}
+
+			Quadric& operator+=(Quadric const& rhs) {
+				for (std::size_t i = 0; i < m.size(); ++i) {
+					m[i] += rhs.m[i];
+				}
+				weight += rhs.weight;
+				return *this;
+			}
+
+			// mean squared distance to all the accumulated planes
+			double evaluate(glm::vec3 const& p) const {
+				if (weight <= 0) {
+					return 0;
+				}
+				double const x = p.x;
+				double const y = p.y;
+				double const z = p.z;
+				auto const sum = m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x   //
+				       + m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y                   //
+				       + m[7] * z * z + 2 * m[8] * z                                      //
+				       + m[9];
+				return std::max(sum / weight, 0.0);
+			}
+		};
+
+		struct PositionHash {
+			std::size_t operator()(std::array<float, 3> const& p) const noexcept {
+				return static_cast<std::size_t>(util::hash::content_hash(p.data(), sizeof(p)));
+			}
+		};
+
+		struct Collapse {
+			double cost;
+			std::size_t from;
+			std::size_t to;
+			std::uint32_t from_version;
+			std::uint32_t to_version;
+
+			// std::priority_queue is a max heap, cheapest collapse has to come out first
+			friend bool operator<(Collapse const& lhs, Collapse const& rhs) {
+				return lhs.cost > rhs.cost;
+			}
+		};
+
+		// Half edge collapse simplifier. Vertices only ever move onto other existing vertices, so every level is just a new index
+		// buffer into the untouched vertex list.
+		//
+		// Positions are what's collapsed, as flat shading leaves one vertex per corner. Positions that sit on an open border, a texture
+		// seam or the edge between two emissive colors are locked in place, so outlines, texture mapping and emissive regions survive.
+		class Simplifier {
+		  public:
+			Simplifier(Mesh const& mesh, float const max_error) : mesh_(mesh), corners_(mesh.indices) {
+				auto const triangle_count = corners_.size() / 3;
+				alive_.assign(triangle_count, true);
+				live_triangles_ = triangle_count;
+
+				findPositions();
+				lockPositions();
+				buildQuadrics();
+
+				glm::vec3 min = positions_.front();
+				glm::vec3 max = positions_.front();
+				for (auto const& p : positions_) {
+					min = glm::min(min, p);
+					max = glm::max(max, p);
+				}
+				auto const max_distance = static_cast<double>(glm::length(max - min) * max_error);
+				max_cost_ = max_distance * max_distance;
+
+				for (std::size_t t = 0; t < triangle_count; ++t) {
+					for (std::size_t i = 0; i < 3; ++i) {
+						auto const a = positionOf(t, i);
+						auto const b = positionOf(t, (i + 1) % 3);
+						pushCollapse(a, b);
+						pushCollapse(b, a);
+					}
+				}
+			}
+
+			std::vector<MeshLod> run(std::vector<float> const& triangle_ratios) {
+				std::vector<MeshLod> lods;
+				auto const original = alive_.size();
+
+				for (auto const ratio : triangle_ratios) {
+					auto const target = static_cast<std::size_t>(static_cast<float>(original) * ratio);
+					while (live_triangles_ > target && !queue_.empty()) {
+						auto const collapse = queue_.top();
+						queue_.pop();
+						tryCollapse(collapse);
+					}
+
+					// out of valid collapses, nothing more to gain from further levels
+					auto const previous = lods.empty() ? original : lods.back().indices.size() / 3;
+					if (live_triangles_ >= previous || live_triangles_ == 0) {
+						break;
+					}
+					lods.emplace_back(snapshot());
+				}
+
+				return lods;
+			}
+
+		  private:
+			std::size_t positionOf(std::size_t const triangle, std::size_t const corner) const {
+				return position_of_vertex_[corners_[triangle * 3 + corner]];
+			}
+
+			void findPositions() {
+				std::unordered_map<std::array<float, 3>, std::size_t, PositionHash> lookup;
+				position_of_vertex_.resize(mesh_.verts.size());
+
+				for (std::size_t v = 0; v < mesh_.verts.size(); ++v) {
+					auto const& p = mesh_.verts[v].position;
+					auto const inserted = lookup.emplace(std::array<float, 3>{p.x, p.y, p.z}, positions_.size());
+					if (inserted.second) {
+						positions_.emplace_back(p);
+						vertices_at_.emplace_back();
+					}
+					position_of_vertex_[v] = inserted.first->second;
+					vertices_at_[inserted.first->second].emplace_back(v);
+				}
+
+				triangles_at_.resize(positions_.size());
+				for (std::size_t t = 0; t < alive_.size(); ++t) {
+					for (std::size_t i = 0; i < 3; ++i) {
+						triangles_at_[positionOf(t, i)].emplace_back(t);
+					}
+				}
+
+				locked_.assign(positions_.size(), false);
+				removed_.assign(positions_.size(), false);
+				version_.assign(positions_.size(), 0);
+			}
+
+			void lockPositions() {
+				// texture seams
+				for (std::size_t p = 0; p < positions_.size(); ++p) {
+					auto const& first = mesh_.verts[vertices_at_[p].front()].texture_coord;
+					for (auto const v : vertices_at_[p]) {
+						if (mesh_.verts[v].texture_coord != first) {
+							locked_[p] = true;
+						}
+					}
+				}
+
+				// edges between emissive colors
+				if (mesh_.face_data.size() == alive_.size()) {
+					for (std::size_t p = 0; p < positions_.size(); ++p) {
+						auto const& first = mesh_.face_data[triangles_at_[p].front()].emissive_color;
+						for (auto const t : triangles_at_[p]) {
+							if (mesh_.face_data[t].emissive_color != first) {
+								locked_[p] = true;
+							}
+						}
+					}
+				}
+
+				// Open borders and non-manifold edges, anything not shared by exactly two triangles. The back of a two sided face is
+				// the same triangle reversed, so it's only counted once.
+				std::map<std::pair<std::size_t, std::size_t>, std::size_t> edge_use;
+				std::set<std::array<std::size_t, 3>> seen_triangles;
+				for (std::size_t t = 0; t < alive_.size(); ++t) {
+					std::array<std::size_t, 3> triangle = {positionOf(t, 0), positionOf(t, 1), positionOf(t, 2)};
+					std::sort(triangle.begin(), triangle.end());
+					if (!seen_triangles.insert(triangle).second) {
+						continue;
+					}
+					for (std::size_t i = 0; i < 3; ++i) {
+						auto const a = positionOf(t, i);
+						auto const b = positionOf(t, (i + 1) % 3);
+						++edge_use[std::minmax(a, b)];
+					}
+				}
+				for (auto const& edge : edge_use) {
+					if (edge.second != 2) {
+						locked_[edge.first.first] = true;
+						locked_[edge.first.second] = true;
+					}
+				}
+			}
+
+			void buildQuadrics() {
+				quadrics_.resize(positions_.size());
+				for (std::size_t t = 0; t < alive_.size(); ++t) {
+					auto const& a = positions_[positionOf(t, 0)];
+					auto const& b = positions_[positionOf(t, 1)];
+					auto const& c = positions_[positionOf(t, 2)];
+
+					auto const cross = glm::cross(b - a, c - a);
+					auto const length = glm::length(cross);
+					if (length <= 0) {
+						continue;
+					}
+					auto const normal = cross / length;
+					auto const quadric = Quadric::fromPlane(normal, -glm::dot(normal, a), length * 0.5);
+
+					for (std::size_t i = 0; i < 3; ++i) {
+						quadrics_[positionOf(t, i)] += quadric;
+					}
+				}
+			}
+
+			void pushCollapse(std::size_t const from, std::size_t const to) {
+				if (from == to || locked_[from]) {
+					return;
+				}
+				Quadric combined = quadrics_[from];
+				combined += quadrics_[to];
+				queue_.push(Collapse{combined.evaluate(positions_[to]), from, to, version_[from], version_[to]});
+			}
+
+			// vertex at position to that should replace vertex on a corner moving there
+			std::size_t replacementVertex(std::size_t const vertex, glm::vec2 const& texture_coord, std::size_t const to) const {
+				auto best = vertices_at_[to].front();
+				auto best_dot = -2.0F;
+				for (auto const candidate : vertices_at_[to]) {
+					if (mesh_.verts[candidate].texture_coord != texture_coord) {
+						continue;
+					}
+					auto const dot = glm::dot(mesh_.verts[candidate].normal, mesh_.verts[vertex].normal);
+					if (dot > best_dot) {
+						best = candidate;
+						best_dot = dot;
+					}
+				}
+				return best;
+			}
+
+			void tryCollapse(Collapse const& collapse) {
+				auto const from = collapse.from;
+				auto const to = collapse.to;
+				if (removed_[from] || removed_[to] || collapse.from_version != version_[from] || collapse.to_version != version_[to]) {
+					return;
+				}
+				if (collapse.cost > max_cost_) {
+					return;
+				}
+
+				// The corners moving onto to take the texture coordinate the triangles along the edge use there. If those disagree
+				// there is no single right choice, so leave the edge alone.
+				bool edge_found = false;
+				glm::vec2 texture_coord{};
+				for (auto const t : triangles_at_[from]) {
+					if (!alive_[t]) {
+						continue;
+					}
+					for (std::size_t i = 0; i < 3; ++i) {
+						if (positionOf(t, i) != to) {
+							continue;
+						}
+						auto const& uv = mesh_.verts[corners_[t * 3 + i]].texture_coord;
+						if (edge_found && uv != texture_coord) {
+							return;
+						}
+						edge_found = true;
+						texture_coord = uv;
+					}
+				}
+				if (!edge_found) {
+					return;
+				}
+
+				// reject collapses that would fold a triangle over
+				for (auto const t : triangles_at_[from]) {
+					if (!alive_[t] || containsPosition(t, to)) {
+						continue;
+					}
+					std::array<glm::vec3, 3> before{};
+					std::array<glm::vec3, 3> after{};
+					for (std::size_t i = 0; i < 3; ++i) {
+						before[i] = positions_[positionOf(t, i)];
+						after[i] = positionOf(t, i) == from ? positions_[to] : before[i];
+					}
+					auto const normal_before = glm::cross(before[1] - before[0], before[2] - before[0]);
+					auto const normal_after = glm::cross(after[1] - after[0], after[2] - after[0]);
+					if (glm::dot(normal_before, normal_after) <= 0) {
+						return;
+					}
+				}
+
+				for (auto const t : triangles_at_[from]) {
+					if (!alive_[t]) {
+						continue;
+					}
+					if (containsPosition(t, to)) {
+						alive_[t] = false;
+						--live_triangles_;
+						continue;
+					}
+					for (std::size_t i = 0; i < 3; ++i) {
+						auto& corner = corners_[t * 3 + i];
+						if (position_of_vertex_[corner] == from) {
+							corner = replacementVertex(corner, texture_coord, to);
+						}
+					}
+					triangles_at_[to].emplace_back(t);
+				}
+
+				removed_[from] = true;
+				quadrics_[to] += quadrics_[from];
+				++version_[to];
+				max_error_ = std::max(max_error_, collapse.cost);
+
+				// every collapse involving to has a new cost
+				for (auto const t : triangles_at_[to]) {
+					if (!alive_[t]) {
+						continue;
+					}
+					for (std::size_t i = 0; i < 3; ++i) {
+						auto const neighbor = positionOf(t, i);
+						pushCollapse(to, neighbor);
+						pushCollapse(neighbor, to);
+					}
+				}
+			}
+
+			bool containsPosition(std::size_t const triangle, std::size_t const position) const {
+				return positionOf(triangle, 0) == position || positionOf(triangle, 1) == position || positionOf(triangle, 2) == position;
+			}
+
+			MeshLod snapshot() const {
+				MeshLod lod;
+				lod.indices.reserve(live_triangles_ * 3);
+				auto const has_face_data = mesh_.face_data.size() == alive_.size();
+				if (has_face_data) {
+					lod.face_data.reserve(live_triangles_);
+				}
+
+				for (std::size_t t = 0; t < alive_.size(); ++t) {
+					if (!alive_[t]) {
+						continue;
+					}
+					lod.indices.insert(lod.indices.end(), corners_.begin() + static_cast<std::ptrdiff_t>(t * 3),
+					                   corners_.begin() + static_cast<std::ptrdiff_t>(t * 3 + 3));
+					if (has_face_data) {
+						lod.face_data.emplace_back(mesh_.face_data[t]);
+					}
+				}
+
+				lod.error = static_cast<float>(std::sqrt(max_error_));
+				return lod;
+			}
+
+			Mesh const& mesh_;
+			std::vector<std::size_t> corners_;
+			std::vector<bool> alive_;
+			std::size_t live_triangles_ = 0;
+
+			std::vector<glm::vec3> positions_;
+			std::vector<std::size_t> position_of_vertex_;
+			std::vector<std::vector<std::size_t>> vertices_at_;
+			std::vector<std::vector<std::size_t>> triangles_at_;
+			std::vector<bool> locked_;
+			std::vector<bool> removed_;
+			std::vector<std::uint32_t> version_;
+			std::vector<Quadric> quadrics_;
+
+			std::priority_queue<Collapse> queue_;
+			double max_cost_ = 0;
+			double max_error_ = 0;
+		};
+	} // namespace
+
+	std::vector<MeshLod> generate_lods(const Mesh& mesh, const std::vector<float>& triangle_ratios, float const max_error) {
+		if (mesh.indices.size() < 3) {
+			return {};
+		}
+		return Simplifier(mesh, max_error).run(triangle_ratios);
+	}
+} // namespace bve::parsers::b3d_csv_object
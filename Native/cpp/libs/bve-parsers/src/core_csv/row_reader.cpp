@@ -0,0 +1,76 @@
+#include "parsers/csv.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace bve::parsers::csv {
+	namespace {
+		bool is_strippable(char const c) {
+			return c != '\0' && std::strchr("\t\n\v\f\r ", c) != nullptr;
+		}
+	} // namespace
+
+	RowReader::RowReader(const std::string& file, SplitFirstColumn const sfc, char const delim, char const split_char, char const comment) :
+	    file_(file),
+	    sfc_(sfc),
+	    delim_(delim),
+	    split_char_(split_char),
+	    comment_(comment) {}
+
+	bool RowReader::next(std::vector<CSVToken>& row) {
+		if (done_) {
+			return false;
+		}
+
+		auto const line_begin = file_.begin() + static_cast<std::ptrdiff_t>(position_);
+		auto const line_end = std::find(line_begin, file_.end(), '\n');
+		auto const content_end = comment_ != '\0' ? std::find(line_begin, line_end, comment_) : line_end;
+
+		std::size_t count = 0;
+		auto begin = line_begin;
+		auto first = true;
+
+		while (true) {
+			auto const next_delim = std::find_if(begin, content_end, [&](char const c) {
+				return (sfc_ == SplitFirstColumn::yes && first ? c == split_char_ : false) || c == delim_;
+			});
+			first = false;
+
+			auto text_begin = begin;
+			auto text_end = next_delim;
+			while (text_begin != text_end && is_strippable(*text_begin)) {
+				++text_begin;
+			}
+			while (text_begin != text_end && is_strippable(*(text_end - 1))) {
+				--text_end;
+			}
+
+			if (count == row.size()) {
+				row.emplace_back();
+			}
+			auto& token = row[count++];
+			// assign rather than construct so the buffer's strings get reused from row to row
+			token.text.assign(text_begin, text_end);
+			token.line_begin = current_line_;
+			token.line_end = current_line_;
+			token.char_begin = static_cast<std::size_t>(std::distance(line_begin, begin));
+			token.char_end = static_cast<std::size_t>(std::distance(line_begin, next_delim));
+
+			if (next_delim == content_end) {
+				break;
+			}
+			begin = next_delim + 1;
+		}
+
+		row.resize(count);
+
+		if (line_end == file_.end()) {
+			done_ = true;
+		}
+		else {
+			position_ = static_cast<std::size_t>(std::distance(file_.begin(), line_end)) + 1;
+			current_line_++;
+		}
+
+		return true;
+	}
+} // namespace bve::parsers::csv
@@ -0,0 +1,528 @@
+#include "parsers/csv_rw_route.hpp"
+#include "util/binary_io.hpp"
+#include "util/content_hash.hpp"
+#include "util/mapped_file.hpp"
+#include <array>
+#include <stdexcept>
+
+namespace bve::parsers::csv_rw_route {
+	namespace {
+		using util::binary::Reader;
+		using util::binary::Writer;
+
+		using Magic = std::array<char, 8>;
+		constexpr Magic cache_magic = {'B', 'V', 'E', 'R', 'O', 'U', 'T', 'E'};
+		// Bump whenever the serialized layout of ParsedRoute changes
+		constexpr std::uint32_t cache_version = 3;
+
+		// Structures which are copied wholesale. Their sizes are part of the header so a layout change in a different build invalidates
+		// the cache even if someone forgets to bump the version.
+		using Fingerprint = std::array<std::uint32_t, 12>;
+		constexpr Fingerprint layout_fingerprint = {
+		    sizeof(RailBlockInfo), sizeof(GroundHeight), sizeof(RailAdhesion),      sizeof(RailObjectInfo),
+		    sizeof(TrackLimit),    sizeof(Beacon),       sizeof(ATSPSection),       sizeof(Fog),
+		    sizeof(Sound),         sizeof(Announcement), sizeof(RailStationStop),   sizeof(xml::dynamic_lighting::LightingInfo),
+		};
+
+		/////////////
+		// Writing //
+		/////////////
+
+		void write_filename_set(Writer& w, const FilenameSet& set) {
+			w.write<std::uint64_t>(set.size());
+			for (auto& str : set) {
+				w.writeString(str);
+			}
+		}
+
+		void write_message(Writer& w, const xml::stations::Message& m) {
+			w.writeString(m.early);
+			w.writeString(m.ontime);
+			w.writeString(m.late);
+		}
+
+		void write_station(Writer& w, const RailStation& rs) {
+			auto& rsm = rs.request_stop_info;
+			w.write(rsm.early_time);
+			w.write(rsm.using_early);
+			w.write(rsm.late_time);
+			w.write(rsm.using_late);
+			w.write(rsm.distance);
+			write_message(w, rsm.stop_message);
+			write_message(w, rsm.pass_message);
+			w.write(rsm.probability);
+			w.write(rsm.max_cars);
+			w.write(rsm.ai_behaviour);
+
+			w.writeString(rs.name);
+			w.write(rs.arrival_sound);
+			w.write(rs.departure_sound);
+			w.write<std::uint64_t>(rs.timetable_index);
+			w.writeArray(rs.stop_points);
+			w.write(rs.arrival);
+			w.write(rs.departure);
+			w.write(rs.stop_duration);
+			w.write(rs.passenger_ratio);
+			w.write(rs.pass_alarm);
+			w.write(rs.force_red);
+			w.write(rs.system);
+			w.write(rs.arrival_tag);
+			w.write(rs.departure_tag);
+			w.write(rs.doors);
+		}
+
+		void write_background(Writer& w, const Background& b) {
+			using xml::dynamic_background::ObjectBackgroundInfo;
+			using xml::dynamic_background::TextureBackgroundInfo;
+
+			w.write(b.position);
+			if (b.value.is<ObjectBackgroundInfo>()) {
+				w.write<std::uint8_t>(1);
+				w.writeString(b.value.get_unchecked<ObjectBackgroundInfo>().filename);
+				return;
+			}
+
+			auto& textures = b.value.get_unchecked<std::vector<TextureBackgroundInfo>>();
+			w.write<std::uint8_t>(0);
+			w.write<std::uint64_t>(textures.size());
+			for (auto& tbi : textures) {
+				w.write(tbi.time);
+				w.write(tbi.transition_mode);
+				w.write<std::uint64_t>(tbi.repetitions);
+				w.writeString(tbi.filename);
+				w.write<std::uint64_t>(tbi.transition_time);
+				w.write(tbi.preserve_aspect);
+				w.write(tbi.from_xml);
+			}
+		}
+
+		template <class Marker>
+		void write_marker_common(Writer& w, const Marker& m) {
+			w.write<std::uint64_t>(m.allowed_trains.size());
+			for (auto& train : m.allowed_trains) {
+				w.writeString(train);
+			}
+			w.write(m.early_time);
+			w.write(m.late_time);
+			w.write(m.timeout);
+			w.write(m.distance);
+			w.write(m.using_early);
+			w.write(m.using_ontime);
+			w.write(m.using_late);
+		}
+
+		void write_marker(Writer& w, const Marker& m) {
+			using xml::route_marker::ImageMarker;
+			using xml::route_marker::TextMarker;
+
+			w.write(m.start);
+			w.write(m.end);
+			if (m.marker.is<ImageMarker>()) {
+				auto& im = m.marker.get_unchecked<ImageMarker>();
+				w.write<std::uint8_t>(0);
+				write_marker_common(w, im);
+				w.writeString(im.early_filename);
+				w.writeString(im.on_time_filename);
+				w.writeString(im.late_filename);
+			}
+			else {
+				auto& tm = m.marker.get_unchecked<TextMarker>();
+				w.write<std::uint8_t>(1);
+				write_marker_common(w, tm);
+				w.writeString(tm.early_text);
+				w.writeString(tm.on_time_text);
+				w.writeString(tm.late_text);
+				w.write(tm.early_color);
+				w.write(tm.on_time_color);
+				w.write(tm.late_color);
+			}
+		}
+
+		void write_size_map(Writer& w, const std::unordered_map<std::size_t, std::size_t>& map) {
+			w.write<std::uint64_t>(map.size());
+			for (auto& pair : map) {
+				w.write<std::uint64_t>(pair.first);
+				w.write<std::uint64_t>(pair.second);
+			}
+		}
+
+		void write_errors(Writer& w, const errors::MultiError& errors) {
+			w.write<std::uint64_t>(errors.size());
+			for (auto& file : errors) {
+				w.writeString(file.first);
+				w.write<std::uint64_t>(file.second.size());
+				for (auto& error : file.second) {
+					w.write(error.line);
+					w.writeString(error.error);
+				}
+			}
+		}
+
+		void write_route(Writer& w, const ParsedRoute& route) {
+			w.writeArray(route.blocks);
+			w.writeArray(route.ground_height);
+			w.writeArray(route.bumpers);
+			w.writeArray(route.adhesion);
+			w.writeArray(route.objects);
+
+			w.write<std::uint64_t>(route.stations.size());
+			for (auto& station : route.stations) {
+				write_station(w, station);
+			}
+
+			w.writeArray(route.limits);
+
+			write_filename_set(w, route.object_filenames);
+			write_filename_set(w, route.texture_filenames);
+			write_filename_set(w, route.sound_filenames);
+
+			w.writeArray(route.lighting);
+			w.write<std::uint64_t>(route.backgrounds.size());
+			for (auto& background : route.backgrounds) {
+				write_background(w, background);
+			}
+			w.writeArray(route.fog);
+			w.writeArray(route.brightness_levels);
+
+			w.writeArray(route.signal_speed);
+			w.write<std::uint64_t>(route.sections.size());
+			for (auto& section : route.sections) {
+				w.write(section.position);
+				w.writeArray(section.value);
+			}
+			w.writeArray(route.beacons);
+			w.writeArray(route.patterns);
+
+			w.writeArray(route.pretrain_points);
+			w.writeArray(route.ai_train_start_intervals);
+			w.write(route.ai_max_speed);
+
+			w.write(route.compatibility);
+
+			w.write(route.safety_system_status);
+			w.write(route.game_start_time);
+
+			w.writeArray(route.sounds);
+			w.writeArray(route.announcements);
+			write_size_map(w, route.rail_runsound_mapping);
+			write_size_map(w, route.rail_flangesound_mapping);
+
+			w.writeString(route.default_train);
+			w.writeString(route.image_location);
+			w.writeString(route.loading_image_location);
+			w.writeString(route.comment);
+			w.writeString(route.timetable_text);
+			w.writeString(route.display_unit.unit_name);
+			w.write(route.display_unit.conversion_factor);
+			w.write<std::uint64_t>(route.markers.size());
+			for (auto& marker : route.markers) {
+				write_marker(w, marker);
+			}
+			w.write<std::uint64_t>(route.points_of_interest.size());
+			for (auto& poi : route.points_of_interest) {
+				w.write(poi.position);
+				w.write(poi.camera_rotation);
+				w.writeString(poi.text);
+			}
+
+			w.write(route.gauge);
+			w.write(route.acceleration_due_to_gravity);
+			w.write(route.temperature);
+			w.write(route.pressure);
+			w.write(route.altitude);
+		}
+
+		/////////////
+		// Reading //
+		/////////////
+
+		// Every entry of a counted list holds at least one string or count of its own
+		constexpr std::size_t min_entry_size = sizeof(std::uint64_t);
+
+		// Fixup pass for the string tables, rebuilds the hash index. IDs are handed out in insertion order, so they match the originals.
+		void read_filename_set(Reader& r, FilenameSet& set) {
+			auto const count = r.readCount(min_entry_size);
+			set.clear();
+			set.reserve(count);
+			for (std::size_t i = 0; i < count; ++i) {
+				set.insert(r.readString());
+			}
+			if (set.size() != count) {
+				throw std::out_of_range("Duplicate strings in cached filename table");
+			}
+		}
+
+		void read_message(Reader& r, xml::stations::Message& m) {
+			m.early = r.readString();
+			m.ontime = r.readString();
+			m.late = r.readString();
+		}
+
+		void read_station(Reader& r, RailStation& rs) {
+			auto& rsm = rs.request_stop_info;
+			rsm.early_time = r.read<decltype(rsm.early_time)>();
+			rsm.using_early = r.readBool();
+			rsm.late_time = r.read<decltype(rsm.late_time)>();
+			rsm.using_late = r.readBool();
+			rsm.distance = r.read<float>();
+			read_message(r, rsm.stop_message);
+			read_message(r, rsm.pass_message);
+			rsm.probability = r.read<decltype(rsm.probability)>();
+			rsm.max_cars = r.read<decltype(rsm.max_cars)>();
+			rsm.ai_behaviour = r.read<decltype(rsm.ai_behaviour)>();
+
+			rs.name = r.readString();
+			rs.arrival_sound = r.read<FilenameID>();
+			rs.departure_sound = r.read<FilenameID>();
+			rs.timetable_index = static_cast<std::size_t>(r.read<std::uint64_t>());
+			r.readArray(rs.stop_points);
+			rs.arrival = r.read<decltype(rs.arrival)>();
+			rs.departure = r.read<decltype(rs.departure)>();
+			rs.stop_duration = r.read<float>();
+			rs.passenger_ratio = r.read<float>();
+			rs.pass_alarm = r.readBool();
+			rs.force_red = r.readBool();
+			rs.system = r.readBool();
+			rs.arrival_tag = r.read<decltype(rs.arrival_tag)>();
+			rs.departure_tag = r.read<decltype(rs.departure_tag)>();
+			rs.doors = r.read<decltype(rs.doors)>();
+		}
+
+		void read_background(Reader& r, Background& b) {
+			using xml::dynamic_background::ObjectBackgroundInfo;
+			using xml::dynamic_background::TextureBackgroundInfo;
+
+			b.position = r.read<float>();
+			if (r.read<std::uint8_t>() == 1) {
+				ObjectBackgroundInfo obi;
+				obi.filename = r.readString();
+				b.value = std::move(obi);
+				return;
+			}
+
+			std::vector<TextureBackgroundInfo> textures(r.readCount(min_entry_size));
+			for (auto& tbi : textures) {
+				tbi.time = r.read<decltype(tbi.time)>();
+				tbi.transition_mode = r.read<decltype(tbi.transition_mode)>();
+				tbi.repetitions = static_cast<std::size_t>(r.read<std::uint64_t>());
+				tbi.filename = r.readString();
+				tbi.transition_time = static_cast<std::size_t>(r.read<std::uint64_t>());
+				tbi.preserve_aspect = r.readBool();
+				tbi.from_xml = r.readBool();
+			}
+			b.value = std::move(textures);
+		}
+
+		template <class Marker>
+		void read_marker_common(Reader& r, Marker& m) {
+			m.allowed_trains.resize(r.readCount(min_entry_size));
+			for (auto& train : m.allowed_trains) {
+				train = r.readString();
+			}
+			m.early_time = r.read<decltype(m.early_time)>();
+			m.late_time = r.read<decltype(m.late_time)>();
+			m.timeout = r.read<decltype(m.timeout)>();
+			m.distance = r.read<float>();
+			m.using_early = r.readBool();
+			m.using_ontime = r.readBool();
+			m.using_late = r.readBool();
+		}
+
+		void read_marker(Reader& r, Marker& m) {
+			using xml::route_marker::ImageMarker;
+			using xml::route_marker::TextMarker;
+
+			m.start = r.read<float>();
+			m.end = r.read<float>();
+			if (r.read<std::uint8_t>() == 0) {
+				ImageMarker im;
+				read_marker_common(r, im);
+				im.early_filename = r.readString();
+				im.on_time_filename = r.readString();
+				im.late_filename = r.readString();
+				m.marker = std::move(im);
+			}
+			else {
+				TextMarker tm;
+				read_marker_common(r, tm);
+				tm.early_text = r.readString();
+				tm.on_time_text = r.readString();
+				tm.late_text = r.readString();
+				tm.early_color = r.read<TextMarker::Color>();
+				tm.on_time_color = r.read<TextMarker::Color>();
+				tm.late_color = r.read<TextMarker::Color>();
+				m.marker = std::move(tm);
+			}
+		}
+
+		void read_size_map(Reader& r, std::unordered_map<std::size_t, std::size_t>& map) {
+			auto const count = r.readCount(2 * sizeof(std::uint64_t));
+			map.clear();
+			for (std::size_t i = 0; i < count; ++i) {
+				auto const key = static_cast<std::size_t>(r.read<std::uint64_t>());
+				map[key] = static_cast<std::size_t>(r.read<std::uint64_t>());
+			}
+		}
+
+		void read_errors(Reader& r, errors::MultiError& errors) {
+			auto const file_count = r.readCount(min_entry_size);
+			for (std::size_t i = 0; i < file_count; ++i) {
+				auto& file_errors = errors[r.readString()];
+				auto const error_count = r.readCount(min_entry_size);
+				for (std::size_t j = 0; j < error_count; ++j) {
+					errors::Error e;
+					e.line = r.read<std::intmax_t>();
+					e.error = r.readString();
+					file_errors.emplace_back(std::move(e));
+				}
+			}
+		}
+
+		void read_route(Reader& r, ParsedRoute& route) {
+			r.readArray(route.blocks);
+			r.readArray(route.ground_height);
+			r.readArray(route.bumpers);
+			r.readArray(route.adhesion);
+			r.readArray(route.objects);
+
+			route.stations.resize(r.readCount(min_entry_size));
+			for (auto& station : route.stations) {
+				read_station(r, station);
+			}
+
+			r.readArray(route.limits);
+
+			read_filename_set(r, route.object_filenames);
+			read_filename_set(r, route.texture_filenames);
+			read_filename_set(r, route.sound_filenames);
+
+			r.readArray(route.lighting);
+			route.backgrounds.resize(r.readCount(min_entry_size));
+			for (auto& background : route.backgrounds) {
+				read_background(r, background);
+			}
+			r.readArray(route.fog);
+			r.readArray(route.brightness_levels);
+
+			r.readArray(route.signal_speed);
+			route.sections.resize(r.readCount(min_entry_size));
+			for (auto& section : route.sections) {
+				section.position = r.read<float>();
+				r.readArray(section.value);
+			}
+			r.readArray(route.beacons);
+			r.readArray(route.patterns);
+
+			r.readArray(route.pretrain_points);
+			r.readArray(route.ai_train_start_intervals);
+			route.ai_max_speed = r.read<float>();
+
+			route.compatibility = r.read<CompatibilityModes>();
+
+			route.safety_system_status = r.read<SafetySystemStatus>();
+			route.game_start_time = r.read<util::datatypes::Time>();
+
+			r.readArray(route.sounds);
+			r.readArray(route.announcements);
+			read_size_map(r, route.rail_runsound_mapping);
+			read_size_map(r, route.rail_flangesound_mapping);
+
+			route.default_train = r.readString();
+			route.image_location = r.readString();
+			route.loading_image_location = r.readString();
+			route.comment = r.readString();
+			route.timetable_text = r.readString();
+			route.display_unit.unit_name = r.readString();
+			route.display_unit.conversion_factor = r.read<float>();
+			route.markers.resize(r.readCount(min_entry_size));
+			for (auto& marker : route.markers) {
+				read_marker(r, marker);
+			}
+			route.points_of_interest.resize(r.readCount(min_entry_size));
+			for (auto& poi : route.points_of_interest) {
+				poi.position = r.read<glm::vec3>();
+				poi.camera_rotation = r.read<glm::vec3>();
+				poi.text = r.readString();
+			}
+
+			route.gauge = r.read<float>();
+			route.acceleration_due_to_gravity = r.read<float>();
+			route.temperature = r.read<float>();
+			route.pressure = r.read<float>();
+			route.altitude = r.read<float>();
+		}
+	} // namespace
+
+	bool save_route_cache(const std::string& cache_filename,
+	                      const ParsedRoute& route,
+	                      const errors::MultiError& errors,
+	                      const PreprocessedLines& lines) {
+		Writer w;
+
+		w.write(cache_magic);
+		w.write(cache_version);
+		w.write(layout_fingerprint);
+
+		w.write<std::uint64_t>(lines.filenames.size());
+		for (auto& filename : lines.filenames) {
+			util::MappedFile const file(filename);
+			// Every file needs to be hashable, otherwise we could never tell if the cache is stale
+			if (!file.valid()) {
+				return false;
+			}
+			w.writeString(filename);
+			w.write<std::uint64_t>(file.size());
+			w.write(util::hash::content_hash(file.data(), file.size()));
+		}
+
+		write_route(w, route);
+		write_errors(w, errors);
+
+		return w.saveToFile(cache_filename);
+	}
+
+	absl::optional<ParsedRoute> load_route_cache(const std::string& cache_filename, errors::MultiError& errors) {
+		util::MappedFile const cache(cache_filename);
+		if (!cache.valid()) {
+			return absl::nullopt;
+		}
+
+		Reader r(cache.data(), cache.size());
+
+		try {
+			if (r.read<Magic>() != cache_magic || r.read<std::uint32_t>() != cache_version
+			    || r.read<Fingerprint>() != layout_fingerprint) {
+				return absl::nullopt;
+			}
+
+			auto const file_count = r.readCount(min_entry_size);
+			for (std::size_t i = 0; i < file_count; ++i) {
+				auto const filename = r.readString();
+				auto const size = r.read<std::uint64_t>();
+				auto const hash = r.read<std::uint64_t>();
+
+				util::MappedFile const file(filename);
+				if (!file.valid() || file.size() != size || util::hash::content_hash(file.data(), file.size()) != hash) {
+					return absl::nullopt;
+				}
+			}
+
+			ParsedRoute route;
+			errors::MultiError cached_errors;
+			read_route(r, route);
+			read_errors(r, cached_errors);
+
+			// Only hand out errors once we know the whole file is sound
+			for (auto& file : cached_errors) {
+				auto& dest = errors[file.first];
+				dest.insert(dest.end(), file.second.begin(), file.second.end());
+			}
+
+			return route;
+		}
+		catch (const std::exception&) {
+			// Truncated or corrupted cache, treat it as a miss
+			return absl::nullopt;
+		}
+	}
+} // namespace bve::parsers::csv_rw_route
@@ -15,6 +15,7 @@ namespace bve::parsers::csv_rw_route {
 			const std::vector<std::string>& filenames_;
 
 			instructions::options::CantBehavior::Mode cant_behavior_ = instructions::options::CantBehavior::Mode::unsigned_cant;
+			float gauge_ = 1435;
 
 			RailBlockInfo& makeNewBlock(float position) {
 				position = bve::util::math::max<float>(0, position);
@@ -117,6 +118,10 @@ namespace bve::parsers::csv_rw_route {
 				cant_behavior_ = inst.mode;
 			}
 
+			void operator()(const instructions::route::Gauge& inst) {
+				gauge_ = inst.width;
+			}
+
 			void operator()(const instructions::track::Pitch& inst) {
 				auto& block = makeNewBlock(inst.absolute_position);
 				block.pitch = inst.rate / 1000;
@@ -127,7 +132,8 @@ namespace bve::parsers::csv_rw_route {
 				auto& block = makeNewBlock(inst.absolute_position);
 				block.radius = inst.radius;
 				if (cant_behavior_ == instructions::options::CantBehavior::Mode::unsigned_cant) {
-					block.cant = block.radius != 0 ? std::abs(inst.cant) : 0;
+					// the outer rail is raised, so the cant leans the same way as the curve
+					block.cant = block.radius != 0 ? std::abs(inst.cant) * (block.radius < 0 ? -1.0F : 1.0F) : 0;
 				}
 				else {
 					block.cant = inst.cant;
@@ -155,6 +161,13 @@ namespace bve::parsers::csv_rw_route {
 				rd.ground_height.emplace_back(GroundHeight{inst.absolute_position, inst.y});
 			}
 
+			// All blocks are known, precompute what's needed to place things on them
+			void finalize() {
+				for (auto& block : rd.blocks) {
+					calculate_curve_parameters(block, gauge_);
+				}
+			}
+
 			template <class T>
 			void operator()(const T& /*unused*/) {
 				// Might need error handling later.
@@ -171,6 +184,8 @@ namespace bve::parsers::csv_rw_route {
 			apply_visitor(p2_e, i);
 		}
 
+		p2_e.finalize();
+
 		return p2_e.rd;
 	}
 } // namespace bve::parsers::csv_rw_route
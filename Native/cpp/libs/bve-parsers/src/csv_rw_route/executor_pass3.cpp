@@ -1,8 +1,50 @@
 #include "csv_rw_route/executor_pass3/executor_pass3.hpp"
 #include "parsers/csv_rw_route.hpp"
 #include "parsers/errors.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 
 namespace bve::parsers::csv_rw_route {
+	namespace {
+		float instruction_position(const Instruction& inst) {
+			return apply_visitor([](auto& i) -> float { return i.absolute_position; }, inst);
+		}
+
+		// Move everything in source before position into dest, source is sorted by position as instructions are
+		template <class T>
+		void move_before(std::vector<T>& source, std::vector<T>& dest, float const position) {
+			auto const split =
+			    std::find_if(source.begin(), source.end(), [&](const T& value) { return !(value.position < position); });
+			dest.insert(dest.end(), std::make_move_iterator(source.begin()), std::make_move_iterator(split));
+			source.erase(source.begin(), split);
+		}
+
+		RouteChunk take_chunk(ParsedRoute& rd, std::vector<PendingObject>& pending, float const start, float const end) {
+			RouteChunk chunk;
+			chunk.start = start;
+			chunk.end = end;
+
+			auto const split = std::stable_partition(pending.begin(), pending.end(),
+			                                         [&](const PendingObject& po) { return po.track_position < end; });
+			std::stable_sort(pending.begin(), split, [](const PendingObject& a, const PendingObject& b) {
+				return a.track_position < b.track_position;
+			});
+			chunk.objects.reserve(static_cast<std::size_t>(std::distance(pending.begin(), split)));
+			std::transform(pending.begin(), split, std::back_inserter(chunk.objects),
+			               [](PendingObject& po) { return std::move(po.object); });
+			pending.erase(pending.begin(), split);
+
+			move_before(rd.limits, chunk.limits, end);
+			move_before(rd.sections, chunk.sections, end);
+			move_before(rd.beacons, chunk.beacons, end);
+
+			return chunk;
+		}
+	} // namespace
+
 	void execute_instructions_pass3(ParsedRoute& rd,
 	                                InstructionList& list,
 	                                errors::MultiError& errors,
@@ -13,8 +55,47 @@ namespace bve::parsers::csv_rw_route {
 			apply_visitor(p3_e, inst);
 		}
 
-		auto const largest_position = apply_visitor([](auto& inst) -> float { return inst.absolute_position; }, list.instructions.back());
+		auto const largest_position = instruction_position(list.instructions.back());
+
+		p3_e.finalize(largest_position);
+	}
+
+	void execute_instructions_pass3(ParsedRoute& rd,
+	                                InstructionList& list,
+	                                errors::MultiError& errors,
+	                                const RelativeFileFunc& get_abs_path,
+	                                float const chunk_length,
+	                                const RouteChunkConsumer& consumer) {
+		if (!(chunk_length > 0)) {
+			throw std::invalid_argument("Chunk length must be positive");
+		}
+
+		std::vector<PendingObject> pending;
+		Pass3Executor p3_e(rd, errors, list.filenames, get_abs_path, &pending);
+
+		float chunk_start = 0;
+		float chunk_end = chunk_length;
+
+		for (auto& inst : list.instructions) {
+			auto const position = instruction_position(inst);
+
+			// Instructions are sorted, so nothing before the boundary can be placed once we pass it
+			if (position >= chunk_end) {
+				auto const boundary = std::floor(position / chunk_length) * chunk_length;
+
+				p3_e.advanceRepeatingObjects(boundary);
+				consumer(take_chunk(rd, pending, chunk_start, boundary));
+
+				chunk_start = boundary;
+				chunk_end = boundary + chunk_length;
+			}
+
+			apply_visitor(p3_e, inst);
+		}
+
+		auto const largest_position = instruction_position(list.instructions.back());
 
 		p3_e.finalize(largest_position);
+		consumer(take_chunk(rd, pending, chunk_start, std::numeric_limits<float>::infinity()));
 	}
 } // namespace bve::parsers::csv_rw_route
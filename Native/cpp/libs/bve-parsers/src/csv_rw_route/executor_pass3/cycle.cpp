@@ -4,9 +4,9 @@
 #include <vector>
 
 namespace bve::parsers::csv_rw_route {
-	absl::optional<FilenameSetIterator> get_cycle_filename_index(
+	absl::optional<FilenameID> get_cycle_filename_index(
 	    const std::unordered_map<std::size_t, std::vector<std::size_t>>& cycle_mapping,
-	    const std::unordered_map<std::size_t, FilenameSetIterator>& object_mapping,
+	    const std::unordered_map<std::size_t, FilenameID>& object_mapping,
 	    std::size_t const index,
 	    std::size_t const position) {
 		auto const cycle_iterator = cycle_mapping.find(index);
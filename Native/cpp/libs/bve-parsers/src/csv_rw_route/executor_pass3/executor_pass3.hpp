@@ -5,6 +5,8 @@
 #include "util/math.hpp"
 #include "util/pair_hash.hpp"
 #include "util/parsing.hpp"
+#include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iosfwd>
 #include <iostream>
@@ -14,13 +16,28 @@ namespace bve::parsers::csv_rw_route {
 	using CycleType = std::vector<std::size_t>;
 
 	// defined in executor_pass3/cycle.cpp
-	absl::optional<FilenameSetIterator> get_cycle_filename_index(
+	absl::optional<FilenameID> get_cycle_filename_index(
 	    const std::unordered_map<std::size_t, std::vector<std::size_t>>& cycle_mapping,
-	    const std::unordered_map<std::size_t, FilenameSetIterator>& object_mapping,
+	    const std::unordered_map<std::size_t, FilenameID>& object_mapping,
 	    std::size_t index,
 	    std::size_t position);
 	void print_cycle_type(std::ostream& o, const CycleType& c);
 
+	// Repeating objects (rails, walls, poles, ground) are placed on a grid of this spacing starting at the beginning of the route.
+	// Keeping the grid fixed means the placed objects don't depend on how often generation gets triggered.
+	constexpr std::size_t repeating_object_spacing = 25;
+
+	inline std::size_t first_repeating_object_position(float const position) {
+		auto const meters = static_cast<std::size_t>(std::ceil(std::max(position, 0.0F)));
+		return (meters + repeating_object_spacing - 1) / repeating_object_spacing * repeating_object_spacing;
+	}
+
+	// Objects waiting to be handed out by the streaming executor
+	struct PendingObject {
+		float track_position;
+		RailObjectInfo object;
+	};
+
 	struct RailState {
 		float x_offset = 0;
 		float y_offset = 0;
@@ -60,6 +77,10 @@ namespace bve::parsers::csv_rw_route {
 		const std::vector<std::string>& filenames_;
 		ParsedRoute& route_data_;
 		const RelativeFileFunc& get_relative_file_;
+		// when streaming, objects are collected here instead of in route_data_
+		std::vector<PendingObject>* pending_objects_;
+		// ground heights are final after pass 2 and objects get placed roughly in order
+		mutable GroundHeightCursor ground_height_cursor_;
 
 		// state variables
 		std::vector<float> units_of_length_ = {1, 1};
@@ -74,29 +95,29 @@ namespace bve::parsers::csv_rw_route {
 		};
 
 		// structures and poles
-		std::unordered_map<std::size_t, FilenameSetIterator> object_ground_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_rail_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_ground_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_rail_mapping_;
 		std::unordered_map<std::size_t, std::vector<std::size_t>> cycle_ground_mapping_;
 		std::unordered_map<std::size_t, std::vector<std::size_t>> cycle_rail_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_wall_l_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_wall_r_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_dike_l_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_dike_r_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_form_l_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_form_r_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_form_cl_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_form_cr_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_roof_l_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_roof_r_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_roof_cl_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_roof_cr_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_crack_l_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_crack_r_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_freeobj_mapping_;
-		std::unordered_map<std::size_t, FilenameSetIterator> object_beacon_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_wall_l_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_wall_r_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_dike_l_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_dike_r_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_form_l_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_form_r_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_form_cl_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_form_cr_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_roof_l_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_roof_r_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_roof_cl_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_roof_cr_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_crack_l_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_crack_r_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_freeobj_mapping_;
+		std::unordered_map<std::size_t, FilenameID> object_beacon_mapping_;
 		// Poles are unique based on the number of rails as well as the pole
 		// structure index
-		std::unordered_map<std::pair<std::size_t, std::size_t>, FilenameSetIterator, util::hash::PairHash> object_pole_mapping_;
+		std::unordered_map<std::pair<std::size_t, std::size_t>, FilenameID, util::hash::PairHash> object_pole_mapping_;
 
 		// Background indices
 		std::unordered_map<std::size_t, xml::dynamic_background::ParsedDynamicBackground> background_mapping_;
@@ -123,14 +144,23 @@ namespace bve::parsers::csv_rw_route {
 			return filenames_[index];
 		}
 
-		FilenameSetIterator addObjectFilename(std::string const& val) const;
+		FilenameID addObjectFilename(std::string const& val) const;
 
-		FilenameSetIterator addTextureFilename(std::string const& val) const {
-			return route_data_.texture_filenames.insert(util::parsers::lower_copy(val)).first;
+		FilenameID addTextureFilename(std::string const& val) const {
+			return route_data_.texture_filenames.insert(util::parsers::lower_copy(val));
 		}
 
-		FilenameSetIterator addSoundFilename(std::string const& val) const {
-			return route_data_.sound_filenames.insert(util::parsers::lower_copy(val)).first;
+		FilenameID addSoundFilename(std::string const& val) const {
+			return route_data_.sound_filenames.insert(util::parsers::lower_copy(val));
+		}
+
+		void addObject(float const track_position, RailObjectInfo roi) const {
+			if (pending_objects_ != nullptr) {
+				pending_objects_->emplace_back(PendingObject{track_position, std::move(roi)});
+			}
+			else {
+				route_data_.objects.emplace_back(std::move(roi));
+			}
 		}
 
 		// defined in executor_pass3/util.cpp
@@ -140,20 +170,29 @@ namespace bve::parsers::csv_rw_route {
 		glm::vec3 positionRelativeToRail(std::size_t rail_num, float position, float x_offset, float y_offset);
 
 	  public:
-		Pass3Executor(ParsedRoute& rd, errors::MultiError& e, const std::vector<std::string>& fn, const RelativeFileFunc& grf) :
-		    errors_(e),             // clang-format can't decide how to format this, so I will for it
-		    filenames_(fn),         //
-		    route_data_(rd),        //
-		    get_relative_file_(grf) //
+		Pass3Executor(ParsedRoute& rd,
+		              errors::MultiError& e,
+		              const std::vector<std::string>& fn,
+		              const RelativeFileFunc& grf,
+		              std::vector<PendingObject>* pending = nullptr) :
+		    errors_(e),                // clang-format can't decide how to format this, so I will for it
+		    filenames_(fn),            //
+		    route_data_(rd),           //
+		    get_relative_file_(grf),   //
+		    pending_objects_(pending), //
+		    ground_height_cursor_(rd)  //
 		{}
 
 		// defined in executor_pass3/finalize.cpp
+		// place all repeating objects up to, but not including, position
+		void advanceRepeatingObjects(float position);
 		// ensure all state is dumped to the structure
 		void finalize(float max_position);
 
 		// unused instructions
+		// const, otherwise it is a better match than the const handlers below and they never run
 		template <class T>
-		void operator()(const T& /*unused*/) {}
+		void operator()(const T& /*unused*/) const {}
 
 		// defined in executor_pass3/options.cpp
 		void operator()(const instructions::options::UnitOfLength& /*inst*/);
@@ -215,6 +254,9 @@ namespace bve::parsers::csv_rw_route {
 
 	  private:
 		void addRailObjectsToPosition(RailState& state, float position) const;
+		// defined in executor_pass3/finalize.cpp
+		// place everything attached to one rail up to position, needed before anything its objects depend on changes
+		void advanceRailObjects(std::size_t rail_number, RailState& state, float position);
 
 	  public:
 		// defined in executor_pass3/rails.cpp
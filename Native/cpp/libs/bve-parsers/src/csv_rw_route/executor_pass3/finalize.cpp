@@ -1,20 +1,25 @@
 #include "executor_pass3.hpp"
 
 namespace bve::parsers::csv_rw_route {
-	void Pass3Executor::finalize(float const max_position) {
-		for (auto& state : current_rail_state_) {
-			auto& rail_num = state.first;
-			auto& state_val = state.second;
+	void Pass3Executor::advanceRailObjects(std::size_t const rail_number, RailState& state, float const position) {
+		addRailObjectsToPosition(state, position);
+		addWallObjectsToPosition(state, position, 0);
+		addWallObjectsToPosition(state, position, 1);
+		addWallObjectsToPosition(state, position, 2);
+		addWallObjectsToPosition(state, position, 3);
+		addPollObjectsToPosition(rail_number, state, position);
+		if (rail_number == 0) {
+			addGroundObjectsToPosition(state, position);
+		}
+	}
 
-			addRailObjectsToPosition(state_val, max_position);
-			addWallObjectsToPosition(state_val, max_position, 0);
-			addWallObjectsToPosition(state_val, max_position, 1);
-			addWallObjectsToPosition(state_val, max_position, 2);
-			addWallObjectsToPosition(state_val, max_position, 3);
-			addPollObjectsToPosition(rail_num, state_val, max_position);
-			if (rail_num == 0) {
-				addGroundObjectsToPosition(state_val, max_position);
-			}
+	void Pass3Executor::advanceRepeatingObjects(float const position) {
+		for (auto& state : current_rail_state_) {
+			advanceRailObjects(state.first, state.second, position);
 		}
 	}
+
+	void Pass3Executor::finalize(float const max_position) {
+		advanceRepeatingObjects(max_position);
+	}
 } // namespace bve::parsers::csv_rw_route
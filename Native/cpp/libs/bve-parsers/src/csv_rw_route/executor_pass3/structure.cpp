@@ -4,40 +4,41 @@
 namespace bve::parsers::csv_rw_route {
 	void Pass3Executor::operator()(const instructions::structure::Command& inst) {
 		auto const add_and_warn = [&](auto& container, const char* command_name) {
-			auto filename_iter = addObjectFilename(inst.filename);
+			auto const filename_id = addObjectFilename(inst.filename);
 
-			auto insert_pair = container.insert(std::make_pair(inst.structure_index, filename_iter));
+			auto insert_pair = container.insert(std::make_pair(inst.structure_index, filename_id));
 
 			auto& iterator = insert_pair.first;
 			auto& inserted = insert_pair.second;
 
 			if (!inserted) {
-				auto& previous_filename = *iterator->second;
-				iterator->second = filename_iter;
+				auto const& previous_filename = route_data_.object_filenames[iterator->second];
+				iterator->second = filename_id;
 				std::ostringstream err;
 				err << command_name << " overwriting index #" << inst.structure_index << ". Old Filename: \"" << previous_filename
-				    << "\". Current Filename: \"" << *filename_iter << "\".";
+				    << "\". Current Filename: \"" << route_data_.object_filenames[filename_id] << "\".";
 
 				add_error(errors_, getFilename(inst.file_index), inst.line, err);
 			}
 		};
 
 		auto const add_and_warn_cycle = [&](auto& container, const char* command_name) {
-			auto filename_iter = addObjectFilename(inst.filename);
+			auto const filename_id = addObjectFilename(inst.filename);
 
-			auto insert_pair = container.insert(std::make_pair(inst.structure_index, filename_iter));
+			auto insert_pair = container.insert(std::make_pair(inst.structure_index, filename_id));
 
 			auto& iterator = insert_pair.first;
 			auto& inserted = insert_pair.second;
 
 			if (!inserted) {
-				auto old_value = iterator->second;
-				iterator->second = filename_iter;
+				auto const old_value = iterator->second;
+				iterator->second = filename_id;
 
 				std::ostringstream err;
 
-				err << command_name << " overwriting index number " << inst.structure_index << ". Old Filename: \"" << *old_value
-				    << "\". Current Filename: \"" << *filename_iter << "\".";
+				err << command_name << " overwriting index number " << inst.structure_index << ". Old Filename: \""
+				    << route_data_.object_filenames[old_value] << "\". Current Filename: \"" << route_data_.object_filenames[filename_id]
+				    << "\".";
 
 				add_error(errors_, getFilename(inst.file_index), inst.line, err);
 			}
@@ -104,20 +105,20 @@ namespace bve::parsers::csv_rw_route {
 	}
 
 	void Pass3Executor::operator()(const instructions::structure::Pole& inst) {
-		auto filename_iter = addObjectFilename(inst.filename);
+		auto const filename_id = addObjectFilename(inst.filename);
 
-		auto value = std::make_pair(std::make_pair(inst.additional_rails, inst.pole_structure_index), filename_iter);
+		auto value = std::make_pair(std::make_pair(inst.additional_rails, inst.pole_structure_index), filename_id);
 		auto insert_pair = object_pole_mapping_.insert(value);
 
 		auto& iterator = insert_pair.first;
 		auto& inserted = insert_pair.second;
 
 		if (!inserted) {
-			auto& previous_filename = *iterator->second;
-			iterator->second = filename_iter;
+			auto const& previous_filename = route_data_.object_filenames[iterator->second];
+			iterator->second = filename_id;
 			std::ostringstream err;
 			err << "Structure.Pole overwriting pair (" << inst.additional_rails << ", " << inst.pole_structure_index << "). Old Pair: \""
-			    << previous_filename << "\". Current Filename: \"" << *filename_iter << "\".";
+			    << previous_filename << "\". Current Filename: \"" << route_data_.object_filenames[filename_id] << "\".";
 
 			add_error(errors_, getFilename(inst.file_index), inst.line, err);
 		}
@@ -26,19 +26,19 @@ namespace bve::parsers::csv_rw_route {
 			return;
 		}
 
-		auto const structure_filename_iter = structure_index_iter->second;
+		auto const structure_filename_id = structure_index_iter->second;
 
 		RailObjectInfo roi;
-		roi.filename = structure_filename_iter;
+		roi.filename = structure_filename_id;
 		roi.position = positionRelativeToRail(inst.rail_index, inst.absolute_position, inst.x_offset, inst.y_offset);
 		/*roi.rotation = */ // TODO(cwfitzgerald): convert Yaw/Pitch/Roll to
 		                    // rotation vector
 
-		route_data_.objects.emplace_back(std::move(roi));
+		addObject(inst.absolute_position, std::move(roi));
 	}
 
 	void Pass3Executor::addWallObjectsToPosition(RailState& state, float const position, uint8_t const type) {
-		std::unordered_map<std::size_t, FilenameSetIterator>* object_mapping;
+		std::unordered_map<std::size_t, FilenameID>* object_mapping;
 		std::size_t index;
 		float* last_updated;
 		bool* enabled;
@@ -75,10 +75,12 @@ namespace bve::parsers::csv_rw_route {
 		auto const object_mapping_iter = object_mapping->find(index);
 
 		if (object_mapping_iter == object_mapping->end() || !state.active || !*enabled) {
+			*last_updated = position;
 			return;
 		}
 
-		for (auto pos = static_cast<std::size_t>(*last_updated); pos < static_cast<std::size_t>(position); pos += 25) {
+		for (auto pos = first_repeating_object_position(*last_updated); float(pos) < position;
+		     pos += repeating_object_spacing) {
 			auto const track_position = trackPositionAt(float(pos));
 			auto const object_location =
 			    util::math::position_from_offsets(track_position.position, track_position.tangent, state.x_offset, state.y_offset);
@@ -87,7 +89,7 @@ namespace bve::parsers::csv_rw_route {
 			i.filename = object_mapping_iter->second;
 			i.position = object_location;
 			i.rotation = glm::vec3(0);
-			route_data_.objects.emplace_back(std::move(i));
+			addObject(float(pos), std::move(i));
 		}
 
 		*last_updated = position;
@@ -233,12 +235,14 @@ namespace bve::parsers::csv_rw_route {
 	void Pass3Executor::addPollObjectsToPosition(std::size_t const rail_number, RailState& state, float const position) {
 		auto const object_mapping_iter = object_pole_mapping_.find({state.pole_additional_rails, state.pole_structure_index});
 
-		if (object_mapping_iter == object_pole_mapping_.end() || !state.active || !state.pole_active) {
+		if (object_mapping_iter == object_pole_mapping_.end() || !state.active || !state.pole_active || state.pole_interval <= 0) {
+			state.position_pole_updated = position;
 			return;
 		}
 
-		for (auto pos = static_cast<std::size_t>(state.position_pole_updated); pos < static_cast<std::size_t>(position); pos += 25) {
-			auto const add_object = pos % state.pole_interval == 0;
+		for (auto pos = first_repeating_object_position(state.position_pole_updated); float(pos) < position;
+		     pos += repeating_object_spacing) {
+			auto const add_object = pos % static_cast<std::size_t>(state.pole_interval) == 0;
 
 			if (!add_object) {
 				continue;
@@ -253,16 +257,16 @@ namespace bve::parsers::csv_rw_route {
 					i.flip_x = true;
 				}
 
-				object_location = positionRelativeToRail(rail_number, position, 0, 0);
+				object_location = positionRelativeToRail(rail_number, float(pos), 0, 0);
 			}
 			else {
-				object_location = positionRelativeToRail(rail_number, position, static_cast<float>(state.pole_location) * 3.8F, 0);
+				object_location = positionRelativeToRail(rail_number, float(pos), static_cast<float>(state.pole_location) * 3.8F, 0);
 			}
 
 			i.filename = object_mapping_iter->second;
 			i.position = object_location;
 			i.rotation = glm::vec3(0);
-			route_data_.objects.emplace_back(std::move(i));
+			addObject(float(pos), std::move(i));
 		}
 
 		state.position_pole_updated = position;
@@ -320,21 +324,22 @@ namespace bve::parsers::csv_rw_route {
 	}
 
 	void Pass3Executor::addGroundObjectsToPosition(RailState& state, float const position) const {
-		for (auto pos = static_cast<std::size_t>(state.position_ground_updated); pos < static_cast<std::size_t>(position); pos += 25) {
+		for (auto pos = first_repeating_object_position(state.position_ground_updated); float(pos) < position;
+		     pos += repeating_object_spacing) {
 			auto const track_location = trackPositionAt(float(pos));
 			auto const ground_height = groundHeightAt(float(pos));
 
-			auto filename_iter_optional = get_cycle_filename_index(cycle_ground_mapping_, object_ground_mapping_, state.ground_index, pos);
+			auto filename_id_optional = get_cycle_filename_index(cycle_ground_mapping_, object_ground_mapping_, state.ground_index, pos);
 
-			if (!filename_iter_optional) {
-				return;
+			if (!filename_id_optional) {
+				continue;
 			}
 
 			RailObjectInfo roi;
-			roi.filename = *filename_iter_optional;
+			roi.filename = *filename_id_optional;
 			roi.position = util::math::position_from_offsets(track_location.position, track_location.tangent, 0, -ground_height);
 			roi.rotation = glm::vec3(0);
-			route_data_.objects.emplace_back(roi);
+			addObject(float(pos), roi);
 		}
 
 		state.position_ground_updated = position;
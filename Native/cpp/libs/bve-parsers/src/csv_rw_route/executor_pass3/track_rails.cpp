@@ -4,26 +4,28 @@
 namespace bve::parsers::csv_rw_route {
 	void Pass3Executor::addRailObjectsToPosition(RailState& state, float const position) const {
 		if (!state.active) {
+			state.position_last_updated = position;
 			return;
 		}
 
-		for (auto pos = static_cast<std::size_t>(state.position_last_updated); pos < static_cast<std::size_t>(position); pos += 25) {
+		for (auto pos = first_repeating_object_position(state.position_last_updated); float(pos) < position;
+		     pos += repeating_object_spacing) {
 			auto const track_position = trackPositionAt(float(pos));
 			auto const object_location =
 			    util::math::position_from_offsets(track_position.position, track_position.tangent, state.x_offset, state.y_offset);
 
-			auto filename_iter_optional = get_cycle_filename_index(cycle_rail_mapping_, object_rail_mapping_, state.rail_structure_index,
-			                                                       static_cast<std::size_t>(position));
+			auto filename_id_optional = get_cycle_filename_index(cycle_rail_mapping_, object_rail_mapping_, state.rail_structure_index,
+			                                                       pos);
 
-			if (!filename_iter_optional) {
-				return;
+			if (!filename_id_optional) {
+				continue;
 			}
 
 			RailObjectInfo i;
-			i.filename = *filename_iter_optional;
+			i.filename = *filename_id_optional;
 			i.position = object_location;
 			i.rotation = glm::vec3(0);
-			route_data_.objects.emplace_back(std::move(i));
+			addObject(float(pos), std::move(i));
 		}
 
 		state.position_last_updated = position;
@@ -32,7 +34,7 @@ namespace bve::parsers::csv_rw_route {
 	void Pass3Executor::operator()(const instructions::track::RailStart& inst) {
 		auto& state = getRailState(inst.rail_index);
 
-		addRailObjectsToPosition(state, inst.absolute_position);
+		advanceRailObjects(inst.rail_index, state, inst.absolute_position);
 
 		if (state.active) {
 			std::ostringstream err;
@@ -57,7 +59,7 @@ namespace bve::parsers::csv_rw_route {
 	void Pass3Executor::operator()(const instructions::track::Rail& inst) {
 		auto& state = getRailState(inst.rail_index);
 
-		addRailObjectsToPosition(state, inst.absolute_position);
+		advanceRailObjects(inst.rail_index, state, inst.absolute_position);
 
 		state.x_offset = inst.x_offset.value_or(state.x_offset);
 		state.y_offset = inst.y_offset.value_or(state.y_offset);
@@ -75,7 +77,7 @@ namespace bve::parsers::csv_rw_route {
 	void Pass3Executor::operator()(const instructions::track::RailType& inst) {
 		auto& state = getRailState(inst.rail_index);
 
-		addRailObjectsToPosition(state, inst.absolute_position);
+		advanceRailObjects(inst.rail_index, state, inst.absolute_position);
 
 		if (!state.active) {
 			std::ostringstream err;
@@ -98,7 +100,7 @@ namespace bve::parsers::csv_rw_route {
 	void Pass3Executor::operator()(const instructions::track::RailEnd& inst) {
 		auto& state = getRailState(inst.rail_index);
 
-		addRailObjectsToPosition(state, inst.absolute_position);
+		advanceRailObjects(inst.rail_index, state, inst.absolute_position);
 
 		if (!state.active) {
 			std::ostringstream err;
@@ -36,7 +36,7 @@ namespace bve::parsers::csv_rw_route {
 			// TODO(cwfitzgerald): convert PYR to angle vector
 			/* roi.rotation = */
 
-			route_data_.objects.emplace_back(std::move(roi));
+			addObject(inst.absolute_position, std::move(roi));
 		}
 	}
 
@@ -82,7 +82,7 @@ namespace bve::parsers::csv_rw_route {
 		// TODO(cwfitzgerald): convert PYR to angle vector
 		/* roi.rotation = */
 
-		route_data_.objects.emplace_back(std::move(roi));
+		addObject(inst.absolute_position, std::move(roi));
 	}
 
 	void Pass3Executor::operator()(const instructions::track::Pattern& inst) const {
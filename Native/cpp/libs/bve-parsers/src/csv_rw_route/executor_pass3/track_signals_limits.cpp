@@ -42,7 +42,7 @@ namespace bve::parsers::csv_rw_route {
 			roi.filename = addObjectFilename(obj_name.str());
 			roi.position = trackPositionAt(inst.absolute_position).position;
 			roi.rotation = glm::vec3(0);
-			route_data_.objects.emplace_back(std::move(roi));
+			addObject(inst.absolute_position, std::move(roi));
 		}
 	}
 
@@ -110,7 +110,7 @@ namespace bve::parsers::csv_rw_route {
 		}
 		roi.rotation = glm::vec3(0);
 
-		route_data_.objects.emplace_back(std::move(roi));
+		addObject(inst.absolute_position, std::move(roi));
 	}
 
 	void Pass3Executor::operator()(const instructions::track::Signal& inst) {
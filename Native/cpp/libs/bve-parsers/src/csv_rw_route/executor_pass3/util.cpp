@@ -1,8 +1,8 @@
 #include "executor_pass3.hpp"
 
 namespace bve::parsers::csv_rw_route {
-	FilenameSetIterator Pass3Executor::addObjectFilename(std::string const& val) const {
-		return route_data_.object_filenames.insert(util::parsers::lower_copy(val)).first;
+	FilenameID Pass3Executor::addObjectFilename(std::string const& val) const {
+		return route_data_.object_filenames.insert(util::parsers::lower_copy(val));
 	}
 
 	RailState& Pass3Executor::getRailState(std::size_t const index) {
@@ -13,27 +13,7 @@ namespace bve::parsers::csv_rw_route {
 	}
 
 	float Pass3Executor::groundHeightAt(float const position) const {
-		if (position <= route_data_.ground_height.front().position) {
-			return route_data_.ground_height.front().value;
-		}
-		if (position >= route_data_.ground_height.back().position) {
-			return route_data_.ground_height.back().value;
-		}
-
-		// WHY DO LOWER BOUND AND UPPER BOUND HAVE DIFFERENT F***ING INTERFACES!
-		// I CAN'T USE std::equal_range UNLESS I PROVIDE IT A FUNCTION WITH
-		// *OVERLOADS* GAAH!
-		auto start_iter = std::lower_bound(route_data_.ground_height.begin(), route_data_.ground_height.end(), position,
-		                                   [](const GroundHeight& a, float const b) { return a.position < b; });
-		auto const end_iter = std::upper_bound(route_data_.ground_height.begin(), route_data_.ground_height.end(), position,
-		                                       [](float const a, const GroundHeight& b) { return a < b.position; });
-
-		if (start_iter->position != position) {
-			start_iter -= 1;
-		}
-
-		return util::math::lerp(start_iter->value, end_iter->value,
-		                        (position - start_iter->position) / (end_iter->position - start_iter->position));
+		return ground_height_cursor_.at(position);
 	}
 
 	util::math::EvaluateCurveState Pass3Executor::trackPositionAt(float const position) const {
@@ -48,8 +28,7 @@ namespace bve::parsers::csv_rw_route {
 			starting_it -= 1;
 		}
 
-		return util::math::evaluate_curve(starting_it->cache.location, starting_it->cache.direction, position - starting_it->position,
-		                                  starting_it->radius);
+		return evaluate_block(*starting_it, position - starting_it->position);
 	}
 
 	glm::vec3 Pass3Executor::positionRelativeToRail(std::size_t rail_num,
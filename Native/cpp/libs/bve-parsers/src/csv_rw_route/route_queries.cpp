@@ -0,0 +1,138 @@
+#include "parsers/csv_rw_route.hpp"
+#include "util/math.hpp"
+#include <algorithm>
+#include <cmath>
+#include <glm/geometric.hpp>
+
+// ReSharper disable once CppInconsistentNaming
+#define _USE_MATH_DEFINES
+#include <math.h> // NOLINT Also include overloads of std::*
+
+namespace bve::parsers::csv_rw_route {
+	namespace {
+		// How far the cursor walks linearly before giving up and searching
+		constexpr std::size_t max_cursor_steps = 4;
+
+		// Index of the last entry at or before position. Position must be within the table.
+		std::size_t find_segment(const std::vector<GroundHeight>& table, float const position) {
+			auto const iter = std::upper_bound(table.begin(), table.end(), position,
+			                                   [](float const a, const GroundHeight& b) { return a < b.position; });
+			return static_cast<std::size_t>(std::distance(table.begin(), iter)) - 1;
+		}
+
+		float interpolate(const std::vector<GroundHeight>& table, std::size_t const index, float const position) {
+			auto const& start = table[index];
+			auto const& end = table[index + 1];
+			return util::math::lerp(start.value, end.value, (position - start.position) / (end.position - start.position));
+		}
+	} // namespace
+
+	void calculate_curve_parameters(RailBlockInfo& block, float const gauge) {
+		auto& curve = block.curve;
+
+		curve.direction_length = length(block.cache.direction);
+		curve.straight_direction = block.cache.direction / curve.direction_length;
+		curve.pitch_slope = curve.straight_direction.y;
+		curve.horizontal_factor = std::sqrt(bve::util::math::max(0.0F, 1 - curve.pitch_slope * curve.pitch_slope));
+
+		curve.cant_angle = gauge != 0 ? std::atan(block.cant / gauge) : 0;
+		curve.cant_sin = std::sin(curve.cant_angle);
+		curve.cant_cos = std::cos(curve.cant_angle);
+
+		if (block.radius == 0) {
+			curve.center = block.cache.location;
+			curve.start_angle = 0;
+			curve.abs_radius = 0;
+			curve.side = 1;
+			return;
+		}
+
+		curve.abs_radius = std::abs(block.radius);
+		curve.side = block.radius < 0 ? -1.0F : 1.0F;
+
+		// Follows util::math::evaluate_curve: the curve is treated as a clockwise circle on the (z, -x) plane, with left curves
+		// mirrored.
+		auto const& n = curve.straight_direction;
+		auto const atan_y = -n.x * curve.side;
+		auto atan = std::atan2(atan_y, n.z);
+		if (atan_y < 0) {
+			atan += static_cast<float>(M_PI * 2);
+		}
+		curve.start_angle = static_cast<float>(M_PI * 2) - atan;
+
+		curve.center = block.cache.location
+		               + glm::vec3(curve.side * curve.abs_radius * std::cos(curve.start_angle), 0,
+		                           -curve.abs_radius * std::sin(curve.start_angle));
+	}
+
+	util::math::EvaluateCurveState evaluate_block(const RailBlockInfo& block, float const distance) {
+		// The legacy curve math doesn't run backwards, keep its exact behavior for the start of the route
+		if (distance <= 0) {
+			return util::math::evaluate_curve(block.cache.location, block.cache.direction, distance, block.radius);
+		}
+
+		auto const& curve = block.curve;
+
+		if (curve.abs_radius == 0) {
+			return {block.cache.location + curve.straight_direction * distance, block.cache.direction};
+		}
+
+		auto const angle = curve.start_angle + distance * curve.horizontal_factor / curve.abs_radius;
+		auto const sin = std::sin(angle);
+		auto const cos = std::cos(angle);
+
+		glm::vec3 const position = curve.center
+		                           + glm::vec3(-curve.side * curve.abs_radius * cos, curve.pitch_slope * distance, curve.abs_radius * sin);
+		glm::vec3 const tangent =
+		    glm::vec3(curve.side * sin * curve.horizontal_factor, curve.pitch_slope, cos * curve.horizontal_factor) * curve.direction_length;
+
+		return {position, tangent};
+	}
+
+	float ground_height_at(const ParsedRoute& route, float const position) {
+		auto const& table = route.ground_height;
+
+		if (table.empty()) {
+			return 0;
+		}
+		if (position <= table.front().position) {
+			return table.front().value;
+		}
+		if (position >= table.back().position) {
+			return table.back().value;
+		}
+
+		return interpolate(table, find_segment(table, position), position);
+	}
+
+	float GroundHeightCursor::at(float const position) {
+		auto const& table = *table_;
+
+		if (table.empty()) {
+			return 0;
+		}
+		if (position <= table.front().position) {
+			return table.front().value;
+		}
+		if (position >= table.back().position) {
+			return table.back().value;
+		}
+
+		// From here on there's always an entry on either side of position
+		if (index_ >= table.size() - 1 || table[index_].position > position) {
+			index_ = find_segment(table, position);
+		}
+		else {
+			std::size_t steps = 0;
+			while (table[index_ + 1].position <= position) {
+				if (++steps > max_cursor_steps) {
+					index_ = find_segment(table, position);
+					break;
+				}
+				++index_;
+			}
+		}
+
+		return interpolate(table, index_, position);
+	}
+} // namespace bve::parsers::csv_rw_route
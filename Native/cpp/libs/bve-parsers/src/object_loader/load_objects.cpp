@@ -0,0 +1,104 @@
+#include "parsers/object_loader.hpp"
+#include "parsers/b3d_csv_cache.hpp"
+#include "util/parsing.hpp"
+#include "util/thread_pool.hpp"
+#include <algorithm>
+#include <sstream>
+
+using namespace std::string_literals;
+
+namespace bve::parsers::object_loader {
+	namespace {
+		enum class ObjectFormat { b3d, csv, animated, unknown };
+
+		ObjectFormat object_format(std::string const& filename) {
+			auto const dot = filename.find_last_of('.');
+			if (dot == std::string::npos) {
+				return ObjectFormat::unknown;
+			}
+
+			auto const extension = util::parsers::lower_copy(filename.substr(dot + 1));
+			if (extension == "b3d") {
+				return ObjectFormat::b3d;
+			}
+			if (extension == "csv") {
+				return ObjectFormat::csv;
+			}
+			if (extension == "animated") {
+				return ObjectFormat::animated;
+			}
+			return ObjectFormat::unknown;
+		}
+
+		LoadedObject load_object(std::string const& filename,
+		                         std::string const& base_file,
+		                         RelativeFileFunc const& get_abs_path,
+		                         b3d_csv_object::ParseOptions const& options,
+		                         std::string const& cache_directory) {
+			LoadedObject loaded;
+
+			try {
+				loaded.path = get_abs_path(base_file, filename);
+
+				auto const format = object_format(loaded.path);
+				if (format == ObjectFormat::unknown) {
+					std::ostringstream err;
+					err << "Unsupported object format: \"" << loaded.path << "\"";
+					add_error(loaded.errors, 0, err);
+					return loaded;
+				}
+
+				auto contents = util::parsers::load_from_file_utf8_bom(loaded.path);
+
+				switch (format) {
+					case ObjectFormat::b3d:
+						loaded.object = cache_directory.empty()
+						                    ? b3d_csv_object::parse_b3d(std::move(contents), options)
+						                    : b3d_csv_object::parse_cached(cache_directory, std::move(contents),
+						                                                   b3d_csv_object::ObjectFormat::b3d, options);
+						break;
+					case ObjectFormat::csv:
+						loaded.object = cache_directory.empty()
+						                    ? b3d_csv_object::parse_csv(std::move(contents), options)
+						                    : b3d_csv_object::parse_cached(cache_directory, std::move(contents),
+						                                                   b3d_csv_object::ObjectFormat::csv, options);
+						break;
+					case ObjectFormat::animated:
+						loaded.object = animated_object::parse(contents);
+						break;
+					case ObjectFormat::unknown:
+						break;
+				}
+			}
+			catch (std::exception const& e) {
+				// a failure only takes down the file that caused it
+				loaded.object = NoObject{};
+				add_error(loaded.errors, 0, e.what());
+			}
+
+			return loaded;
+		}
+	} // namespace
+
+	std::vector<LoadedObject> load_objects(util::StringInterner const& filenames,
+	                                       std::string const& base_file,
+	                                       RelativeFileFunc const& get_abs_path,
+	                                       b3d_csv_object::ParseOptions const& options,
+	                                       std::size_t const thread_count,
+	                                       std::string const& cache_directory) {
+		std::vector<LoadedObject> objects(filenames.size());
+		if (objects.empty()) {
+			return objects;
+		}
+
+		// no point in having threads without a file to load
+		auto const wanted_threads = thread_count == 0 ? std::size_t(std::thread::hardware_concurrency()) : thread_count;
+		util::ThreadPool pool(std::min(wanted_threads, objects.size()));
+		util::parallel_for(pool, objects.size(), [&](std::size_t const id) {
+			auto const& filename = filenames[static_cast<util::StringInterner::ID>(id)];
+			objects[id] = load_object(filename, base_file, get_abs_path, options, cache_directory);
+		});
+
+		return objects;
+	}
+} // namespace bve::parsers::object_loader
@@ -0,0 +1,187 @@
+#include "b3d_csv_object/material_key.hpp"
+#include "parsers/static_batching.hpp"
+#include <cmath>
+#include <glm/gtx/rotate_vector.hpp>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+
+namespace bve::parsers::static_batching {
+	namespace {
+		using b3d_csv_object::MaterialKey;
+		using b3d_csv_object::Mesh;
+		using b3d_csv_object::ParsedB3DCSVObject;
+		using b3d_csv_object::Vertex;
+		using csv_rw_route::RailObjectInfo;
+
+		using Cell = std::pair<std::int32_t, std::int32_t>;
+
+		struct MeshInstance {
+			const Mesh* mesh;
+			const RailObjectInfo* placement;
+		};
+
+		// Meshes of every placement in a chunk, grouped by material. The first mesh of each group provides the material.
+		using ChunkContents = std::map<MaterialKey, std::vector<MeshInstance>>;
+
+		std::size_t index_count(const Mesh& mesh) {
+			return mesh.indices.size() + mesh.indices_16.size() + mesh.indices_32.size();
+		}
+
+		// Works for meshes that have, or haven't, been through compact_indices
+		std::size_t index_at(const Mesh& mesh, std::size_t const i) {
+			if (!mesh.indices.empty()) {
+				return mesh.indices[i];
+			}
+			if (!mesh.indices_16.empty()) {
+				return mesh.indices_16[i];
+			}
+			return mesh.indices_32[i];
+		}
+
+		glm::vec3 transform_direction(glm::vec3 direction, const RailObjectInfo& placement) {
+			if (placement.flip_x) {
+				direction.x = -direction.x;
+			}
+			direction = glm::rotate(direction, placement.rotation.z, glm::vec3(0, 0, 1));
+			direction = glm::rotate(direction, placement.rotation.x, glm::vec3(1, 0, 0));
+			direction = glm::rotate(direction, placement.rotation.y, glm::vec3(0, 1, 0));
+			return direction;
+		}
+
+		// Material keys of every mesh of the object, with the texture resolved against the object's path
+		std::vector<MaterialKey> object_material_keys(const object_loader::LoadedObject& object, const RelativeFileFunc& get_abs_path) {
+			std::vector<MaterialKey> keys;
+			for (auto const& mesh : object.object.get<ParsedB3DCSVObject>().meshes) {
+				auto key = material_key(mesh);
+				auto& texture = std::get<0>(key);
+				if (!texture.empty()) {
+					texture = get_abs_path(object.path, texture);
+				}
+				keys.emplace_back(std::move(key));
+			}
+			return keys;
+		}
+
+		std::uint32_t checked_index(std::size_t const value) {
+			if (value > std::numeric_limits<std::uint32_t>::max()) {
+				throw std::length_error("Static batches exceed 32-bit indices");
+			}
+			return static_cast<std::uint32_t>(value);
+		}
+
+		void bake_instance(StaticBatches& out, Chunk& chunk, const MeshInstance& instance) {
+			auto const& mesh = *instance.mesh;
+			auto const& placement = *instance.placement;
+			auto const base = out.vertices.size();
+
+			for (auto const& vertex : mesh.verts) {
+				Vertex world = vertex;
+				world.position = transform_direction(vertex.position, placement) + placement.position;
+				world.normal = transform_direction(vertex.normal, placement);
+
+				chunk.min = glm::min(chunk.min, world.position);
+				chunk.max = glm::max(chunk.max, world.position);
+				out.vertices.emplace_back(world);
+			}
+
+			// mirroring turns the triangles inside out, swap two corners to keep them facing the right way
+			auto const triangle_count = index_count(mesh) / 3;
+			for (std::size_t t = 0; t < triangle_count; ++t) {
+				auto const a = index_at(mesh, t * 3 + 0);
+				auto const b = index_at(mesh, t * 3 + 1);
+				auto const c = index_at(mesh, t * 3 + 2);
+				out.indices.emplace_back(checked_index(base + a));
+				out.indices.emplace_back(checked_index(base + (placement.flip_x ? c : b)));
+				out.indices.emplace_back(checked_index(base + (placement.flip_x ? b : c)));
+			}
+			out.face_data.insert(out.face_data.end(), mesh.face_data.begin(), mesh.face_data.end());
+		}
+	} // namespace
+
+	StaticBatches build_static_batches(const std::vector<RailObjectInfo>& placements,
+	                                   const std::vector<object_loader::LoadedObject>& objects,
+	                                   const RelativeFileFunc& get_abs_path,
+	                                   float const chunk_length) {
+		StaticBatches out;
+
+		// sort all meshes into chunks and materials first, so every batch is one contiguous range
+		std::map<Cell, ChunkContents> chunks;
+		// resolved the first time an object is placed, indexed like objects
+		std::vector<std::vector<MaterialKey>> material_keys(objects.size());
+		std::size_t vertex_count = 0;
+		std::size_t total_index_count = 0;
+
+		for (std::size_t i = 0; i < placements.size(); ++i) {
+			auto const& placement = placements[i];
+			if (placement.filename >= objects.size() || !objects[placement.filename].object.is<ParsedB3DCSVObject>()) {
+				out.unbatched_objects.emplace_back(i);
+				continue;
+			}
+
+			auto const cell = Cell{static_cast<std::int32_t>(std::floor(placement.position.x / chunk_length)),
+			                       static_cast<std::int32_t>(std::floor(placement.position.z / chunk_length))};
+			auto& contents = chunks[cell];
+
+			auto const& object = objects[placement.filename];
+			auto& keys = material_keys[placement.filename];
+			if (keys.empty()) {
+				keys = object_material_keys(object, get_abs_path);
+			}
+
+			auto const& meshes = object.object.get<ParsedB3DCSVObject>().meshes;
+			for (std::size_t m = 0; m < meshes.size(); ++m) {
+				auto const& mesh = meshes[m];
+				if (index_count(mesh) == 0) {
+					continue;
+				}
+				contents[keys[m]].emplace_back(MeshInstance{&mesh, &placement});
+				vertex_count += mesh.verts.size();
+				total_index_count += index_count(mesh);
+			}
+		}
+
+		out.vertices.reserve(vertex_count);
+		out.indices.reserve(total_index_count);
+		out.face_data.reserve(total_index_count / 3);
+
+		for (auto const& cell : chunks) {
+			if (cell.second.empty()) {
+				continue;
+			}
+
+			Chunk chunk;
+			chunk.cell_x = cell.first.first;
+			chunk.cell_z = cell.first.second;
+			chunk.min = glm::vec3(std::numeric_limits<float>::max());
+			chunk.max = glm::vec3(std::numeric_limits<float>::lowest());
+			chunk.first_batch = checked_index(out.batches.size());
+
+			for (auto const& material : cell.second) {
+				auto const& first = *material.second.front().mesh;
+
+				Batch batch;
+				batch.texture = first.texture;
+				batch.texture.file = std::get<0>(material.first);
+				batch.color = first.color;
+				batch.blend_mode = first.blend_mode;
+				batch.glow_attenuation_mode = first.glow_attenuation_mode;
+				batch.glow_half_distance = first.glow_half_distance;
+				batch.first_index = checked_index(out.indices.size());
+
+				for (auto const& instance : material.second) {
+					bake_instance(out, chunk, instance);
+				}
+
+				batch.index_count = checked_index(out.indices.size() - batch.first_index);
+				out.batches.emplace_back(std::move(batch));
+			}
+
+			chunk.batch_count = checked_index(out.batches.size() - chunk.first_batch);
+			out.chunks.emplace_back(chunk);
+		}
+
+		return out;
+	}
+} // namespace bve::parsers::static_batching
@@ -0,0 +1,220 @@
+#include "parsers/texture_atlas.hpp"
+#include <algorithm>
+#include <glm/common.hpp>
+#include <limits>
+#include <set>
+#include <tuple>
+
+namespace bve::parsers::texture_atlas {
+	namespace {
+		// How far texture coordinates may stray outside [0, 1] from rounding before we consider the texture to be repeating
+		constexpr float uv_tolerance = 1.0F / 1024.0F;
+
+		// Top edge of the filled part of a page along [x, x + width). Segments are sorted by x and cover the whole page width.
+		struct Segment {
+			int x;
+			int y;
+			int width;
+		};
+
+		class Skyline {
+		  public:
+			explicit Skyline(glm::ivec2 const page_size) : page_size_(page_size), segments_{Segment{0, 0, page_size.x}} {}
+
+			// Lowest then leftmost position that fits size, returning false if there is none
+			bool insert(glm::ivec2 const size, glm::ivec2& position) {
+				auto best_index = segments_.size();
+				glm::ivec2 best{std::numeric_limits<int>::max()};
+
+				for (std::size_t i = 0; i < segments_.size(); ++i) {
+					int const x = segments_[i].x;
+					if (x + size.x > page_size_.x) {
+						break;
+					}
+
+					// resting height is the highest segment under the whole width
+					int y = 0;
+					for (std::size_t j = i; j < segments_.size() && segments_[j].x < x + size.x; ++j) {
+						y = std::max(y, segments_[j].y);
+					}
+
+					if (y + size.y <= page_size_.y && std::tie(y, x) < std::tie(best.y, best.x)) {
+						best = {x, y};
+						best_index = i;
+					}
+				}
+
+				if (best_index == segments_.size()) {
+					return false;
+				}
+
+				addSegment(best_index, best, size);
+				position = best;
+				return true;
+			}
+
+		  private:
+			void addSegment(std::size_t const index, glm::ivec2 const position, glm::ivec2 const size) {
+				segments_.insert(segments_.begin() + static_cast<std::ptrdiff_t>(index), Segment{position.x, position.y + size.y, size.x});
+
+				// cut away the part of the following segments now covered by the new one
+				for (std::size_t i = index + 1; i < segments_.size();) {
+					auto const& previous = segments_[i - 1];
+					auto& current = segments_[i];
+					int const overlap = previous.x + previous.width - current.x;
+					if (overlap <= 0) {
+						break;
+					}
+					current.x += overlap;
+					current.width -= overlap;
+					if (current.width > 0) {
+						break;
+					}
+					segments_.erase(segments_.begin() + static_cast<std::ptrdiff_t>(i));
+				}
+
+				for (std::size_t i = 0; i + 1 < segments_.size();) {
+					if (segments_[i].y == segments_[i + 1].y) {
+						segments_[i].width += segments_[i + 1].width;
+						segments_.erase(segments_.begin() + static_cast<std::ptrdiff_t>(i + 1));
+					}
+					else {
+						++i;
+					}
+				}
+			}
+
+			glm::ivec2 page_size_;
+			std::vector<Segment> segments_;
+		};
+
+		bool fits_unit_square(const b3d_csv_object::Mesh& mesh) {
+			return std::all_of(mesh.verts.begin(), mesh.verts.end(), [](const b3d_csv_object::Vertex& vertex) {
+				auto const& uv = vertex.texture_coord;
+				return uv.x >= -uv_tolerance && uv.x <= 1 + uv_tolerance && uv.y >= -uv_tolerance && uv.y <= 1 + uv_tolerance;
+			});
+		}
+	} // namespace
+
+	Atlas pack_atlas(std::vector<AtlasInput> textures, const AtlasOptions& options) {
+		Atlas atlas;
+		atlas.options = options;
+
+		// tallest first packs skylines tightest
+		std::sort(textures.begin(), textures.end(), [](const AtlasInput& lhs, const AtlasInput& rhs) {
+			return std::tie(rhs.dimensions.y, rhs.dimensions.x) < std::tie(lhs.dimensions.y, lhs.dimensions.x)
+			       || (lhs.dimensions == rhs.dimensions && lhs.texture < rhs.texture);
+		});
+
+		std::vector<Skyline> skylines;
+		glm::ivec2 const padding(options.padding);
+
+		for (auto& input : textures) {
+			auto const& size = input.dimensions;
+			auto const padded = size + 2 * padding;
+			if (atlas.placements.count(input.texture) != 0) {
+				continue;
+			}
+			if (size.x <= 0 || size.y <= 0 || size.x > options.max_texture_size || size.y > options.max_texture_size
+			    || padded.x > options.page_size.x || padded.y > options.page_size.y) {
+				atlas.unplaced.emplace_back(std::move(input.texture));
+				continue;
+			}
+
+			Placement placement;
+			glm::ivec2 position;
+			placement.page = 0;
+			while (placement.page < skylines.size() && !skylines[placement.page].insert(padded, position)) {
+				++placement.page;
+			}
+			if (placement.page == skylines.size()) {
+				skylines.emplace_back(options.page_size);
+				skylines.back().insert(padded, position);
+
+				dependencies::Texture page;
+				page.file = options.page_prefix + std::to_string(atlas.pages.size());
+				atlas.pages.emplace_back(std::move(page));
+			}
+
+			glm::vec2 const page_size(options.page_size);
+			placement.position = position + padding;
+			placement.size = size;
+			placement.uv_offset = glm::vec2(placement.position) / page_size;
+			placement.uv_scale = glm::vec2(size) / page_size;
+			atlas.placements.emplace(std::move(input.texture), placement);
+		}
+
+		return atlas;
+	}
+
+	std::vector<std::uint8_t> compose_page(const Atlas& atlas, std::size_t const page, const PixelSource& get_pixels) {
+		auto const& page_size = atlas.options.page_size;
+		int const padding = atlas.options.padding;
+		std::vector<std::uint8_t> pixels(std::size_t(page_size.x) * std::size_t(page_size.y) * 4, 0);
+
+		for (auto const& entry : atlas.placements) {
+			auto const& placement = entry.second;
+			if (placement.page != page) {
+				continue;
+			}
+			const std::uint8_t* const source = get_pixels(entry.first);
+			if (source == nullptr) {
+				continue;
+			}
+
+			auto const& size = placement.size;
+			for (int y = -padding; y < size.y + padding; ++y) {
+				int const source_y = std::clamp(y, 0, size.y - 1);
+				for (int x = -padding; x < size.x + padding; ++x) {
+					int const source_x = std::clamp(x, 0, size.x - 1);
+					auto const* from = &source[4 * (std::size_t(source_y) * std::size_t(size.x) + std::size_t(source_x))];
+					auto const destination = placement.position + glm::ivec2(x, y);
+					auto* to = &pixels[4 * (std::size_t(destination.y) * std::size_t(page_size.x) + std::size_t(destination.x))];
+					std::copy(from, from + 4, to);
+				}
+			}
+		}
+
+		return pixels;
+	}
+
+	bool remap_texture_coords(b3d_csv_object::Mesh& mesh, const Atlas& atlas) {
+		if (mesh.texture.file.empty()) {
+			return false;
+		}
+		auto const found = atlas.placements.find(mesh.texture);
+		if (found == atlas.placements.end() || !fits_unit_square(mesh)) {
+			return false;
+		}
+
+		auto const& placement = found->second;
+		for (auto& vertex : mesh.verts) {
+			vertex.texture_coord = placement.uv_offset + glm::clamp(vertex.texture_coord, 0.0F, 1.0F) * placement.uv_scale;
+		}
+		mesh.texture = atlas.pages[placement.page];
+		return true;
+	}
+
+	std::size_t remap_texture_coords(b3d_csv_object::ParsedB3DCSVObject& object, const Atlas& atlas) {
+		std::size_t count = 0;
+		std::set<dependencies::Texture> replaced;
+		for (auto& mesh : object.meshes) {
+			auto const original = mesh.texture;
+			if (remap_texture_coords(mesh, atlas)) {
+				replaced.insert(original);
+				object.dependencies.textures.insert(mesh.texture);
+				++count;
+			}
+		}
+
+		// only drop a texture once no mesh uses it anymore
+		for (auto const& mesh : object.meshes) {
+			replaced.erase(mesh.texture);
+		}
+		for (auto const& texture : replaced) {
+			object.dependencies.textures.erase(texture);
+		}
+
+		return count;
+	}
+} // namespace bve::parsers::texture_atlas
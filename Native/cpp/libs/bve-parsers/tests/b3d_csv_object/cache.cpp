@@ -0,0 +1,115 @@
+#include "parsers/b3d_csv_cache.hpp"
+#include <cppfs/FileHandle.h>
+#include <cppfs/fs.h>
+#include <cstdint>
+#include <cstring>
+#include <doctest/doctest.h>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+
+using namespace std::string_literals;
+
+// ReSharper disable once CppInconsistentNaming
+namespace b3d = bve::parsers::b3d_csv_object;
+
+TEST_SUITE_BEGIN("libparsers - b3d_csv_object - cache");
+
+TEST_CASE("libparsers - b3d_csv_object - cache - key") {
+	auto const contents = "CreateMeshBuilder\nCube, 1, 1, 1\n"s;
+
+	b3d::ParseOptions welded;
+	welded.weld_vertices = true;
+
+	auto const key = b3d::object_cache_key(contents, b3d::ObjectFormat::csv, {});
+	CHECK_EQ(key, b3d::object_cache_key(contents, b3d::ObjectFormat::csv, {}));
+	CHECK_NE(key, b3d::object_cache_key(contents, b3d::ObjectFormat::b3d, {}));
+	CHECK_NE(key, b3d::object_cache_key(contents, b3d::ObjectFormat::csv, welded));
+	CHECK_NE(key, b3d::object_cache_key(contents + "Cube, 1, 1, 1\n"s, b3d::ObjectFormat::csv, {}));
+}
+
+TEST_CASE("libparsers - b3d_csv_object - cache - round trip") {
+	auto const contents = "CreateMeshBuilder\nCube, 1, 2, 3\nLoadTexture, a.png\nSetDecalTransparentColor, 1, 2, 3\nAddFace, 99\n"s;
+	auto const key = b3d::object_cache_key(contents, b3d::ObjectFormat::csv, {});
+	auto const filename = b3d::object_cache_filename("."s, key);
+
+	auto const original = b3d::parse_csv(contents);
+	REQUIRE(b3d::save_object_cache(filename, key, original));
+
+	auto const wrong_key = b3d::load_object_cache(filename, key + 1);
+	auto const loaded = b3d::load_object_cache(filename, key);
+	cppfs::fs::open(filename).remove();
+
+	CHECK_FALSE(wrong_key);
+	REQUIRE(loaded);
+
+	REQUIRE_EQ(loaded->meshes.size(), original.meshes.size());
+	for (std::size_t i = 0; i < original.meshes.size(); ++i) {
+		auto const& a = original.meshes[i];
+		auto const& b = loaded->meshes[i];
+		REQUIRE_EQ(a.verts.size(), b.verts.size());
+		for (std::size_t v = 0; v < a.verts.size(); ++v) {
+			CHECK_EQ(a.verts[v].position, b.verts[v].position);
+			CHECK_EQ(a.verts[v].normal, b.verts[v].normal);
+			CHECK_EQ(a.verts[v].texture_coord, b.verts[v].texture_coord);
+		}
+		CHECK_EQ(a.indices, b.indices);
+		CHECK_EQ(a.face_data.size(), b.face_data.size());
+		CHECK_EQ(a.texture.file, b.texture.file);
+		CHECK_EQ(a.texture.decal_transparent_color, b.texture.decal_transparent_color);
+		CHECK_EQ(a.color, b.color);
+		CHECK_EQ(a.blend_mode, b.blend_mode);
+		CHECK_EQ(a.glow_attenuation_mode, b.glow_attenuation_mode);
+		CHECK_EQ(a.glow_half_distance, b.glow_half_distance);
+	}
+
+	CHECK_EQ(loaded->dependencies.textures.size(), original.dependencies.textures.size());
+	REQUIRE_EQ(loaded->errors.size(), original.errors.size());
+	for (std::size_t i = 0; i < original.errors.size(); ++i) {
+		CHECK_EQ(loaded->errors[i].line, original.errors[i].line);
+		CHECK_EQ(loaded->errors[i].error, original.errors[i].error);
+	}
+}
+
+TEST_CASE("libparsers - b3d_csv_object - cache - corrupted count") {
+	auto const contents = "CreateMeshBuilder\nCube, 1, 2, 3\n"s;
+	b3d::ParseOptions options;
+	options.generate_lods = true;
+	auto const key = b3d::object_cache_key(contents, b3d::ObjectFormat::csv, options);
+	auto const filename = b3d::object_cache_filename("."s, key);
+
+	auto const original = b3d::parse_csv(contents, options);
+	REQUIRE(b3d::save_object_cache(filename, key, original));
+	std::string cache;
+	{
+		std::ifstream file(filename, std::ios::binary);
+		cache.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+	auto const write_cache = [&](std::string const& data) {
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file << data;
+	};
+
+	// the mesh count comes right after the magic, version, fingerprint and key
+	auto const mesh_count_offset = std::size_t(8 + 4 + 3 * 4 + 8);
+	for (std::uint64_t const count : {std::uint64_t(1) << 40U, ~std::uint64_t(0)}) {
+		CAPTURE(count);
+		auto changed = cache;
+		std::memcpy(&changed[mesh_count_offset], &count, sizeof(count));
+		write_cache(changed);
+
+		absl::optional<b3d::ParsedB3DCSVObject> loaded;
+		CHECK_NOTHROW(loaded = b3d::load_object_cache(filename, key));
+		CHECK_FALSE(loaded);
+
+		// parse_cached parses again and replaces the broken entry
+		b3d::ParsedB3DCSVObject parsed;
+		CHECK_NOTHROW(parsed = b3d::parse_cached("."s, contents, b3d::ObjectFormat::csv, options));
+		CHECK_EQ(parsed.meshes.size(), original.meshes.size());
+		CHECK(b3d::load_object_cache(filename, key));
+	}
+
+	cppfs::fs::open(filename).remove();
+}
+
+TEST_SUITE_END();
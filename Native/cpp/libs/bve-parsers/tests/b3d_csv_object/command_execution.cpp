@@ -3,6 +3,10 @@
 #include <ostream>
 #include <util/testing/variant_macros.hpp>
 
+// ReSharper disable once CppInconsistentNaming
+#define _USE_MATH_DEFINES
+#include <math.h> // NOLINT
+
 using namespace std::string_literals;
 
 // ReSharper disable once CppInconsistentNaming
@@ -18,4 +22,268 @@ TEST_CASE("libparsers - b3d_csv_object - command execution - face creation") {
 	auto result = b3d::run_csv_instructions(instructions);
 }
 
+TEST_CASE("libparsers - b3d_csv_object - command execution - streaming matches instruction list") {
+	auto const text =
+	    "CreateMeshBuilder ; first mesh\n"
+	    "AddVertex, 0, 0, 0\n"
+	    "AddVertex, 1, 0, 0\n"
+	    "AddVertex, 1, 1, 0\n"
+	    "AddFace, 0, 1, 2\n"
+	    "SetColor, 10, 20, 30\n"
+	    "CreateMeshBuilder\n"
+	    "Cube, 1, 2, 3\n"
+	    "LoadTexture, a.png\n"
+	    "NotACommand, 1\n"s;
+
+	auto const streamed = b3d::parse_csv(text);
+	auto const listed = b3d::run_csv_instructions(b3d::create_instructions(text, b3d::FileType::csv));
+
+	REQUIRE_EQ(streamed.meshes.size(), listed.meshes.size());
+	for (std::size_t i = 0; i < streamed.meshes.size(); ++i) {
+		CHECK_EQ(streamed.meshes[i].verts.size(), listed.meshes[i].verts.size());
+		CHECK_EQ(streamed.meshes[i].indices, listed.meshes[i].indices);
+		CHECK_EQ(streamed.meshes[i].color, listed.meshes[i].color);
+		CHECK_EQ(streamed.meshes[i].texture.file, listed.meshes[i].texture.file);
+	}
+	CHECK_EQ(streamed.errors.size(), listed.errors.size());
+}
+
+TEST_CASE("libparsers - b3d_csv_object - command execution - welding and compaction") {
+	b3d::InstructionList const instructions{b3d::instructions::Cube{1, 2, 3}};
+
+	b3d::ParseOptions options;
+	options.weld_vertices = true;
+	options.compact_indices = true;
+
+	auto const plain = b3d::run_csv_instructions(instructions);
+	auto const result = b3d::run_csv_instructions(instructions, options);
+
+	REQUIRE_EQ(plain.meshes.size(), 1);
+	REQUIRE_EQ(result.meshes.size(), 1);
+	CHECK_EQ(plain.meshes[0].verts.size(), 36);
+	// flat shaded quads share two vertices between their triangles
+	CHECK_EQ(result.meshes[0].verts.size(), 24);
+	CHECK(result.meshes[0].indices.empty());
+	CHECK(result.meshes[0].indices_32.empty());
+	REQUIRE_EQ(result.meshes[0].indices_16.size(), plain.meshes[0].indices.size());
+
+	for (std::size_t i = 0; i < plain.meshes[0].indices.size(); ++i) {
+		auto const& expected = plain.meshes[0].verts[plain.meshes[0].indices[i]];
+		auto const& actual = result.meshes[0].verts[result.meshes[0].indices_16[i]];
+		CHECK_EQ(actual.position.x, doctest::Approx(expected.position.x));
+		CHECK_EQ(actual.position.y, doctest::Approx(expected.position.y));
+		CHECK_EQ(actual.position.z, doctest::Approx(expected.position.z));
+	}
+}
+
+TEST_CASE("libparsers - b3d_csv_object - command execution - primitives match equivalent faces") {
+	b3d::InstructionList const primitives{b3d::instructions::Cube{1, 2, 3}, b3d::instructions::Cylinder{6, 1, 2, 4},
+	                                      b3d::instructions::Cylinder{6, 3, 1, 2}};
+
+	b3d::InstructionList manual{
+	    b3d::instructions::AddVertex{1, 2, -3}, b3d::instructions::AddVertex{1, -2, -3}, b3d::instructions::AddVertex{-1, -2, -3},
+	    b3d::instructions::AddVertex{-1, 2, -3}, b3d::instructions::AddVertex{1, 2, 3},  b3d::instructions::AddVertex{1, -2, 3},
+	    b3d::instructions::AddVertex{-1, -2, 3}, b3d::instructions::AddVertex{-1, 2, 3},
+	};
+	for (auto const& quad : std::vector<std::vector<std::size_t>>{{0, 1, 2, 3}, {0, 4, 5, 1}, {0, 3, 7, 4}, //
+	                                                              {6, 5, 4, 7}, {6, 7, 3, 2}, {6, 2, 1, 5}}) {
+		manual.emplace_back(b3d::instructions::AddFace{quad, b3d::instructions::Sides::one});
+	}
+	auto add_cylinder = [&manual](std::size_t const v, float const r1, float const r2, float const h) {
+		for (std::size_t i = 0; i < 6; ++i) {
+			auto const angle = 2 * static_cast<float>(M_PI) * static_cast<float>(i) / 6.0F;
+			manual.emplace_back(b3d::instructions::AddVertex{std::cos(angle) * r1, h / 2, std::sin(angle) * r1});
+			manual.emplace_back(b3d::instructions::AddVertex{std::cos(angle) * r2, -h / 2, std::sin(angle) * r2});
+		}
+		for (std::size_t i = 0; i < 5; ++i) {
+			manual.emplace_back(
+			    b3d::instructions::AddFace{{v + 2 * i + 2, v + 2 * i + 3, v + 2 * i + 1, v + 2 * i}, b3d::instructions::Sides::one});
+		}
+		manual.emplace_back(b3d::instructions::AddFace{{v + 0, v + 1, v + 11, v + 10}, b3d::instructions::Sides::one});
+	};
+	add_cylinder(8, 1, 2, 4);
+	add_cylinder(20, 3, 1, 2);
+
+	auto const expected = b3d::run_csv_instructions(manual);
+	auto const actual = b3d::run_csv_instructions(primitives);
+
+	CHECK(actual.errors.empty());
+	REQUIRE_EQ(expected.meshes.size(), 1);
+	REQUIRE_EQ(actual.meshes.size(), 1);
+	CHECK_EQ(actual.meshes[0].indices, expected.meshes[0].indices);
+	CHECK_EQ(actual.meshes[0].face_data.size(), expected.meshes[0].face_data.size());
+	REQUIRE_EQ(actual.meshes[0].verts.size(), expected.meshes[0].verts.size());
+	for (std::size_t i = 0; i < actual.meshes[0].verts.size(); ++i) {
+		CHECK(actual.meshes[0].verts[i].position == expected.meshes[0].verts[i].position);
+		CHECK(actual.meshes[0].verts[i].normal == expected.meshes[0].verts[i].normal);
+	}
+}
+
+TEST_CASE("libparsers - b3d_csv_object - command execution - faces grouped by material") {
+	// SetColor and LoadTexture apply to the faces already added, so each AddFace here ends up with different traits,
+	// except the last two which only differ in their vertices.
+	auto const result = b3d::parse_csv(
+	    "CreateMeshBuilder\n"
+	    "AddVertex, 0, 0, 0\n"
+	    "AddVertex, 1, 0, 0\n"
+	    "AddVertex, 0, 1, 0\n"
+	    "AddFace, 0, 1, 2\n"
+	    "SetColor, 255, 0, 0\n"
+	    "AddFace, 0, 1, 2\n"
+	    "LoadTexture, a.png\n"
+	    "AddFace, 2, 1, 0\n"
+	    "AddFace, 0, 2, 1\n"s);
+
+	REQUIRE_EQ(result.meshes.size(), 3);
+
+	std::size_t red_meshes = 0;
+	std::size_t textured_meshes = 0;
+	std::size_t total_indices = 0;
+	for (auto const& mesh : result.meshes) {
+		red_meshes += mesh.color == bve::util::datatypes::Color8RGBA{255, 0, 0, 255} ? 1 : 0;
+		textured_meshes += mesh.texture.file == "a.png" ? 1 : 0;
+		total_indices += mesh.indices.size();
+		CHECK_EQ(mesh.indices.size(), mesh.texture.file.empty() ? 6 : 3);
+	}
+	CHECK_EQ(red_meshes, 1);
+	CHECK_EQ(textured_meshes, 2);
+	CHECK_EQ(total_indices, 12);
+}
+
+TEST_CASE("libparsers - b3d_csv_object - command execution - merging meshes") {
+	// three mesh builders, the first two share a material
+	auto const contents =
+	    "CreateMeshBuilder\n"
+	    "Cube, 1, 1, 1\n"
+	    "CreateMeshBuilder\n"
+	    "Cube, 1, 1, 1\n"
+	    "Translate, 5, 0, 0\n"
+	    "CreateMeshBuilder\n"
+	    "Cube, 1, 1, 1\n"
+	    "SetColor, 255, 0, 0\n"s;
+
+	b3d::ParseOptions options;
+	options.merge_meshes = true;
+	options.compact_indices = true;
+
+	auto const plain = b3d::parse_csv(contents);
+	auto const merged = b3d::parse_csv(contents, options);
+
+	REQUIRE_EQ(plain.meshes.size(), 3);
+	REQUIRE_EQ(merged.meshes.size(), 2);
+
+	auto const& combined = merged.meshes[0];
+	CHECK_EQ(combined.color, plain.meshes[0].color);
+	CHECK_EQ(merged.meshes[1].color, plain.meshes[2].color);
+	CHECK_EQ(combined.verts.size(), plain.meshes[0].verts.size() + plain.meshes[1].verts.size());
+	CHECK_EQ(combined.face_data.size(), plain.meshes[0].face_data.size() + plain.meshes[1].face_data.size());
+	REQUIRE_EQ(combined.indices_16.size(), plain.meshes[0].indices.size() + plain.meshes[1].indices.size());
+
+	// the second half of the indices point at the translated cube
+	auto const first_count = plain.meshes[0].indices.size();
+	for (std::size_t i = 0; i < plain.meshes[1].indices.size(); ++i) {
+		auto const& expected = plain.meshes[1].verts[plain.meshes[1].indices[i]];
+		auto const& actual = combined.verts[combined.indices_16[first_count + i]];
+		CHECK_EQ(actual.position.x, doctest::Approx(expected.position.x));
+	}
+}
+
+TEST_CASE("libparsers - b3d_csv_object - command execution - merging keeps draw order") {
+	// the first and last share a material, but merging them would draw the red cube last
+	auto const contents =
+	    "CreateMeshBuilder\n"
+	    "Cube, 1, 1, 1\n"
+	    "CreateMeshBuilder\n"
+	    "Cube, 1, 1, 1\n"
+	    "SetColor, 255, 0, 0, 128\n"
+	    "CreateMeshBuilder\n"
+	    "Cube, 1, 1, 1\n"
+	    "Translate, 5, 0, 0\n"s;
+
+	b3d::ParseOptions options;
+	options.merge_meshes = true;
+
+	auto const plain = b3d::parse_csv(contents);
+	auto const merged = b3d::parse_csv(contents, options);
+
+	REQUIRE_EQ(plain.meshes.size(), 3);
+	REQUIRE_EQ(merged.meshes.size(), 3);
+
+	for (std::size_t i = 0; i < plain.meshes.size(); ++i) {
+		CAPTURE(i);
+		CHECK_EQ(merged.meshes[i].color, plain.meshes[i].color);
+		CHECK_EQ(merged.meshes[i].verts.size(), plain.meshes[i].verts.size());
+		CHECK_EQ(merged.meshes[i].indices, plain.meshes[i].indices);
+	}
+	CHECK_EQ(merged.meshes[2].verts[0].position.x, doctest::Approx(plain.meshes[2].verts[0].position.x));
+}
+
+TEST_CASE("libparsers - b3d_csv_object - command execution - vertex cache optimization") {
+	// 32x32 grid of quads with its triangles visited in a scattered order
+	constexpr std::size_t grid = 32;
+	constexpr std::size_t triangle_count = grid * grid * 2;
+
+	b3d::Mesh mesh;
+	for (std::size_t y = 0; y <= grid; ++y) {
+		for (std::size_t x = 0; x <= grid; ++x) {
+			b3d::Vertex v;
+			v.position = glm::vec3(static_cast<float>(x), static_cast<float>(y), 0);
+			mesh.verts.emplace_back(v);
+		}
+	}
+	std::vector<std::size_t> triangles;
+	for (std::size_t y = 0; y < grid; ++y) {
+		for (std::size_t x = 0; x < grid; ++x) {
+			auto const corner = y * (grid + 1) + x;
+			triangles.insert(triangles.end(), {corner, corner + 1, corner + grid + 1});
+			triangles.insert(triangles.end(), {corner + 1, corner + grid + 2, corner + grid + 1});
+		}
+	}
+	for (std::size_t i = 0; i < triangle_count; ++i) {
+		// 997 is coprime with the triangle count, so this is a permutation
+		auto const triangle = (i * 997) % triangle_count;
+		mesh.indices.insert(mesh.indices.end(), triangles.begin() + triangle * 3, triangles.begin() + triangle * 3 + 3);
+		mesh.face_data.emplace_back();
+		// tag the face data with the triangle number to check it moves with its triangle
+		mesh.face_data.back().emissive_color = bve::util::datatypes::Color8RGB(triangle % 256, triangle / 256, 0);
+	}
+
+	auto const original = mesh;
+	auto const report = b3d::optimize_vertex_cache(mesh);
+
+	CHECK_EQ(report.triangle_count, triangle_count);
+	CHECK_EQ(report.misses_before, b3d::count_vertex_cache_misses(original));
+	CHECK_EQ(report.misses_after, b3d::count_vertex_cache_misses(mesh));
+	// scattered order misses on almost every vertex, a good order gets close to one miss per vertex
+	CHECK_LT(report.misses_after * 2, report.misses_before);
+	CHECK_LT(static_cast<float>(report.misses_after) / static_cast<float>(triangle_count), 0.8F);
+
+	// same triangles, each still paired with its own face data
+	REQUIRE_EQ(mesh.indices.size(), original.indices.size());
+	REQUIRE_EQ(mesh.verts.size(), original.verts.size());
+	std::vector<bool> seen(triangle_count, false);
+	for (std::size_t t = 0; t < triangle_count; ++t) {
+		auto const& tag = mesh.face_data[t].emissive_color;
+		auto const triangle = std::size_t(tag.x) + std::size_t(tag.y) * 256;
+		REQUIRE_LT(triangle, triangle_count);
+		CHECK_FALSE(seen[triangle]);
+		seen[triangle] = true;
+		for (std::size_t i = 0; i < 3; ++i) {
+			auto const& expected = original.verts[triangles[triangle * 3 + i]];
+			auto const& actual = mesh.verts[mesh.indices[t * 3 + i]];
+			CHECK_EQ(actual.position.x, expected.position.x);
+			CHECK_EQ(actual.position.y, expected.position.y);
+		}
+	}
+
+	// vertices are numbered in order of first use
+	std::size_t next_vertex = 0;
+	for (auto const index : mesh.indices) {
+		CHECK_LE(index, next_vertex);
+		if (index == next_vertex) {
+			++next_vertex;
+		}
+	}
+}
+
 TEST_SUITE_END();
@@ -0,0 +1,100 @@
+#include "parsers/b3d_csv.hpp"
+#include <algorithm>
+#include <doctest/doctest.h>
+#include <ostream>
+
+// ReSharper disable once CppInconsistentNaming
+namespace b3d = bve::parsers::b3d_csv_object;
+
+TEST_SUITE_BEGIN("libparsers - b3d_csv_object - simplification");
+
+TEST_CASE("libparsers - b3d_csv_object - simplification - generate_lods") {
+	// flat 20x20 grid, the half with x < 10 is emissive
+	constexpr std::size_t grid = 20;
+	constexpr float emissive_edge = 10;
+
+	b3d::Mesh mesh;
+	for (std::size_t z = 0; z <= grid; ++z) {
+		for (std::size_t x = 0; x <= grid; ++x) {
+			b3d::Vertex v;
+			v.position = glm::vec3(static_cast<float>(x), 0, static_cast<float>(z));
+			v.normal = glm::vec3(0, 1, 0);
+			v.texture_coord = glm::vec2(static_cast<float>(x), static_cast<float>(z)) / static_cast<float>(grid);
+			mesh.verts.emplace_back(v);
+		}
+	}
+	for (std::size_t z = 0; z < grid; ++z) {
+		for (std::size_t x = 0; x < grid; ++x) {
+			auto const corner = z * (grid + 1) + x;
+			mesh.indices.insert(mesh.indices.end(), {corner, corner + grid + 1, corner + 1});
+			mesh.indices.insert(mesh.indices.end(), {corner + 1, corner + grid + 1, corner + grid + 2});
+
+			b3d::FaceData face;
+			if (static_cast<float>(x) < emissive_edge) {
+				face.emissive_color = bve::util::datatypes::Color8RGB(255, 0, 0);
+			}
+			mesh.face_data.emplace_back(face);
+			mesh.face_data.emplace_back(face);
+		}
+	}
+
+	std::vector<float> const ratios(b3d::default_lod_ratios.begin(), b3d::default_lod_ratios.end());
+	auto const lods = b3d::generate_lods(mesh, ratios);
+
+	REQUIRE_GE(lods.size(), 2);
+
+	auto previous = mesh.indices.size();
+	for (auto const& lod : lods) {
+		CHECK_LT(lod.indices.size(), previous);
+		previous = lod.indices.size();
+		REQUIRE_EQ(lod.face_data.size(), lod.indices.size() / 3);
+
+		for (std::size_t t = 0; t < lod.indices.size() / 3; ++t) {
+			auto const& a = mesh.verts[lod.indices[t * 3 + 0]].position;
+			auto const& b = mesh.verts[lod.indices[t * 3 + 1]].position;
+			auto const& c = mesh.verts[lod.indices[t * 3 + 2]].position;
+
+			// still facing up
+			CHECK_GT(glm::cross(b - a, c - a).y, 0);
+
+			// emissive triangles stay on their side of the edge
+			auto const emissive = lod.face_data[t].emissive_color.x == 255;
+			if (emissive) {
+				CHECK_LE(std::max({a.x, b.x, c.x}), emissive_edge);
+			}
+			else {
+				CHECK_GE(std::min({a.x, b.x, c.x}), emissive_edge);
+			}
+		}
+	}
+}
+
+TEST_CASE("libparsers - b3d_csv_object - simplification - parse option") {
+	b3d::ParseOptions options;
+	options.generate_lods = true;
+	options.compact_indices = true;
+
+	// a cube is closed, so every collapse moves a corner by the whole size of the cube, far past default_lod_max_error
+	auto const result = b3d::parse_csv("CreateMeshBuilder\nCube, 1, 1, 1\n", options);
+
+	REQUIRE_EQ(result.meshes.size(), 1);
+	CHECK(result.meshes[0].lods.empty());
+	CHECK_EQ(result.meshes[0].indices_16.size(), 36);
+}
+
+TEST_CASE("libparsers - b3d_csv_object - simplification - max_error") {
+	auto const cube = b3d::parse_csv("CreateMeshBuilder\nCube, 1, 1, 1\n");
+	REQUIRE_EQ(cube.meshes.size(), 1);
+	auto const& mesh = cube.meshes[0];
+	std::vector<float> const ratios(b3d::default_lod_ratios.begin(), b3d::default_lod_ratios.end());
+
+	// a closed cube has no seams or borders to lock, so only the error bound stops it collapsing
+	CHECK(b3d::generate_lods(mesh, ratios, 0.0001F).empty());
+	CHECK(b3d::generate_lods(mesh, ratios).empty());
+
+	auto const lods = b3d::generate_lods(mesh, ratios, 10.0F);
+	REQUIRE_FALSE(lods.empty());
+	CHECK_LT(lods[0].indices.size(), mesh.indices.size());
+}
+
+TEST_SUITE_END();
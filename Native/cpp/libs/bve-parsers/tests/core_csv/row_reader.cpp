@@ -0,0 +1,51 @@
+#include "parsers/csv.hpp"
+#include "util/parsing.hpp"
+#include <doctest/doctest.h>
+#include <ostream>
+
+using namespace std::string_literals;
+
+TEST_SUITE_BEGIN("libparsers - core_csv");
+
+TEST_CASE("libparsers - core_csv - row reader matches parse") {
+	std::string text;
+
+	SUBCASE("empty file") {
+		text = ""s;
+	}
+	SUBCASE("trailing newline") {
+		text = "a,b\n"s;
+	}
+	SUBCASE("split first column with comments") {
+		text = "Vertex 1, 2 ,3\r\n Face 1 2,3;comment, x\n;full line\n\n[meshbuilder]"s;
+	}
+	SUBCASE("empty columns") {
+		text = ",,\n,"s;
+	}
+
+	for (auto const sfc : {bve::parsers::csv::SplitFirstColumn::yes, bve::parsers::csv::SplitFirstColumn::no}) {
+		auto without_comments = text;
+		bve::util::parsers::remove_comments(without_comments, ';');
+		auto const expected = parse(without_comments, sfc);
+
+		bve::parsers::csv::RowReader reader(text, sfc, ',', ' ', ';');
+		std::vector<bve::parsers::csv::CSVToken> row;
+		std::size_t row_index = 0;
+
+		while (reader.next(row)) {
+			REQUIRE_LT(row_index, expected.size());
+			REQUIRE_EQ(row.size(), expected[row_index].size());
+			for (std::size_t i = 0; i < row.size(); ++i) {
+				CHECK_EQ(row[i].text, expected[row_index][i].text);
+				CHECK_EQ(row[i].line_begin, expected[row_index][i].line_begin);
+				CHECK_EQ(row[i].char_begin, expected[row_index][i].char_begin);
+				CHECK_EQ(row[i].char_end, expected[row_index][i].char_end);
+			}
+			++row_index;
+		}
+
+		CHECK_EQ(row_index, expected.size());
+	}
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,266 @@
+#include "parsers/csv_rw_route.hpp"
+#include "sample_route.hpp"
+#include "util/binary_io.hpp"
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cppfs/FileHandle.h>
+#include <cppfs/fs.h>
+#include <doctest/doctest.h>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+
+using namespace std::string_literals;
+namespace cs = bve::parsers::csv_rw_route;
+
+namespace {
+	auto const route_filename = "route_cache.csv"s;
+	auto const cache_filename = "route_cache.bin"s;
+
+	auto const route_contents =
+	    "With Route\n"
+	    ".Comment cached route\n"
+	    ".Gauge 1067\n"
+	    "With Structure\n"
+	    ".Rail(0) rail.csv\n"
+	    ".Pole(0;0) pole.csv\n"
+	    ".FreeObj(0) tree.csv\n"
+	    "With Track\n"
+	    "0, .Pitch 0\n"
+	    ".Limit 60\n"
+	    ".Section 0;2\n"
+	    ".Pole 0;0;0;50;0\n"
+	    "20, .FreeObj 0;0;3;0\n"
+	    ".FreeObj 0;7;0;0\n"
+	    "40, .Beacon 0;0;0;7\n"
+	    "60, .Limit 90\n"
+	    ".Sta Central\n"
+	    ".Stop 1\n"
+	    "100, .FreeObj 0;0;-3;0\n"
+	    "200, .Section 0;2;4\n"
+	    "250, .Height 2\n"s;
+
+	std::string read_file(const std::string& filename) {
+		std::ifstream file(filename, std::ios::binary);
+		return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+	}
+
+	void write_file(const std::string& filename, const std::string& contents) {
+		std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+		file << contents;
+	}
+
+	struct CachedRoute {
+		SampleRoute sample;
+		std::string cache;
+	};
+
+	// Parses the route and writes its cache, leaving both files behind
+	CachedRoute cache_route() {
+		CachedRoute cached{parse_sample_route(route_filename, route_contents), {}};
+		cs::execute_instructions_pass3(cached.sample.route, cached.sample.list, cached.sample.errors, rel_file_func);
+
+		REQUIRE(cs::save_route_cache(cache_filename, cached.sample.route, cached.sample.errors, cached.sample.lines));
+		cached.cache = read_file(cache_filename);
+		return cached;
+	}
+
+	void remove_files() {
+		cppfs::fs::open(route_filename).remove();
+		cppfs::fs::open(cache_filename).remove();
+	}
+
+	// Where the station count is, found by walking over everything the cache stores before it
+	std::size_t station_count_offset(const std::string& cache) {
+		bve::util::binary::Reader r(cache.data(), cache.size());
+		r.read<std::array<char, 8>>();
+		r.read<std::uint32_t>();
+		r.read<std::array<std::uint32_t, 12>>();
+		auto const file_count = r.readCount(1);
+		for (std::size_t i = 0; i < file_count; ++i) {
+			r.readString();
+			r.read<std::uint64_t>();
+			r.read<std::uint64_t>();
+		}
+
+		cs::ParsedRoute route;
+		r.readArray(route.blocks);
+		r.readArray(route.ground_height);
+		r.readArray(route.bumpers);
+		r.readArray(route.adhesion);
+		r.readArray(route.objects);
+		return cache.size() - r.remaining();
+	}
+
+	bool cache_hit() {
+		bve::parsers::errors::MultiError errors;
+		auto const loaded = cs::load_route_cache(cache_filename, errors);
+		// a miss must not hand out any errors
+		CHECK((loaded || errors.empty()));
+		return loaded.has_value();
+	}
+} // namespace
+
+TEST_SUITE_BEGIN("libparsers - csv_rw_route - cache");
+
+TEST_CASE("libparsers - csv_rw_route - cache - round trip") {
+	auto const cached = cache_route();
+	auto const& original = cached.sample.route;
+
+	bve::parsers::errors::MultiError errors;
+	auto const loaded = cs::load_route_cache(cache_filename, errors);
+	REQUIRE(loaded);
+
+	REQUIRE_FALSE(original.objects.empty());
+	REQUIRE_EQ(loaded->objects.size(), original.objects.size());
+	for (std::size_t i = 0; i < original.objects.size(); ++i) {
+		CHECK_EQ(loaded->object_filenames[loaded->objects[i].filename], original.object_filenames[original.objects[i].filename]);
+		CHECK_EQ(loaded->objects[i].position, original.objects[i].position);
+		CHECK_EQ(loaded->objects[i].flip_x, original.objects[i].flip_x);
+	}
+
+	REQUIRE_EQ(loaded->blocks.size(), original.blocks.size());
+	for (std::size_t i = 0; i < original.blocks.size(); ++i) {
+		CHECK_EQ(loaded->blocks[i].position, original.blocks[i].position);
+		CHECK_EQ(loaded->blocks[i].cache.location, original.blocks[i].cache.location);
+		CHECK_EQ(loaded->blocks[i].cache.direction, original.blocks[i].cache.direction);
+	}
+
+	REQUIRE_EQ(loaded->limits.size(), original.limits.size());
+	for (std::size_t i = 0; i < original.limits.size(); ++i) {
+		CHECK_EQ(loaded->limits[i].position, original.limits[i].position);
+		CHECK_EQ(loaded->limits[i].value, original.limits[i].value);
+	}
+
+	REQUIRE_EQ(loaded->sections.size(), original.sections.size());
+	for (std::size_t i = 0; i < original.sections.size(); ++i) {
+		CHECK_EQ(loaded->sections[i].position, original.sections[i].position);
+		CHECK_EQ(loaded->sections[i].value, original.sections[i].value);
+	}
+
+	REQUIRE_EQ(loaded->beacons.size(), original.beacons.size());
+	for (std::size_t i = 0; i < original.beacons.size(); ++i) {
+		CHECK_EQ(loaded->beacons[i].position, original.beacons[i].position);
+		CHECK_EQ(loaded->beacons[i].beacon_type, original.beacons[i].beacon_type);
+		CHECK_EQ(loaded->beacons[i].beacon_data, original.beacons[i].beacon_data);
+	}
+
+	REQUIRE_EQ(loaded->stations.size(), original.stations.size());
+	for (std::size_t i = 0; i < original.stations.size(); ++i) {
+		CHECK_EQ(loaded->stations[i].name, original.stations[i].name);
+		CHECK_EQ(loaded->stations[i].stop_points.size(), original.stations[i].stop_points.size());
+	}
+
+	CHECK_EQ(loaded->object_filenames.strings(), original.object_filenames.strings());
+	CHECK_EQ(loaded->ground_height.size(), original.ground_height.size());
+	CHECK_EQ(loaded->comment, original.comment);
+	CHECK_EQ(loaded->gauge, original.gauge);
+
+	REQUIRE_EQ(errors.size(), cached.sample.errors.size());
+	for (auto const& file : cached.sample.errors) {
+		REQUIRE_EQ(errors[file.first].size(), file.second.size());
+		for (std::size_t i = 0; i < file.second.size(); ++i) {
+			CHECK_EQ(errors[file.first][i].line, file.second[i].line);
+			CHECK_EQ(errors[file.first][i].error, file.second[i].error);
+		}
+	}
+
+	// Anything the checks above missed shows up when the loaded route is written out again
+	REQUIRE(cs::save_route_cache(cache_filename, *loaded, errors, cached.sample.lines));
+	CHECK(read_file(cache_filename) == cached.cache);
+
+	remove_files();
+}
+
+TEST_CASE("libparsers - csv_rw_route - cache - changed source") {
+	cache_route();
+	REQUIRE(cache_hit());
+
+	// same size, different bytes
+	auto changed = route_contents;
+	changed.replace(changed.find("Central"), 7, "Western");
+	write_file(route_filename, changed);
+	CHECK_FALSE(cache_hit());
+
+	// different size, same bytes as far as they go
+	write_file(route_filename, route_contents + "\n");
+	CHECK_FALSE(cache_hit());
+
+	write_file(route_filename, route_contents);
+	CHECK(cache_hit());
+
+	cppfs::fs::open(route_filename).remove();
+	CHECK_FALSE(cache_hit());
+
+	remove_files();
+}
+
+TEST_CASE("libparsers - csv_rw_route - cache - version and fingerprint") {
+	auto const cached = cache_route();
+
+	// magic, then the version, then the layout fingerprint
+	for (std::size_t const offset : {std::size_t(0), std::size_t(8), std::size_t(12), std::size_t(12 + 11 * 4)}) {
+		CAPTURE(offset);
+		auto changed = cached.cache;
+		changed[offset] = static_cast<char>(changed[offset] + 1);
+		write_file(cache_filename, changed);
+		CHECK_FALSE(cache_hit());
+	}
+
+	write_file(cache_filename, cached.cache);
+	CHECK(cache_hit());
+
+	remove_files();
+}
+
+TEST_CASE("libparsers - csv_rw_route - cache - truncated") {
+	auto const cached = cache_route();
+
+	// every length near the start, where the header is, then spread out over the rest
+	for (std::size_t length = 0; length < cached.cache.size(); length += 1 + length / 16) {
+		CAPTURE(length);
+		write_file(cache_filename, cached.cache.substr(0, length));
+		bool hit = true;
+		CHECK_NOTHROW(hit = cache_hit());
+		CHECK_FALSE(hit);
+	}
+	write_file(cache_filename, cached.cache.substr(0, cached.cache.size() - 1));
+	bool hit = true;
+	CHECK_NOTHROW(hit = cache_hit());
+	CHECK_FALSE(hit);
+
+	remove_files();
+}
+
+TEST_CASE("libparsers - csv_rw_route - cache - corrupted") {
+	auto const cached = cache_route();
+	REQUIRE_EQ(cached.sample.route.stations.size(), 1);
+	auto const offset = station_count_offset(cached.cache);
+
+	// counts far larger than the file, which must not be used to size anything
+	for (std::uint64_t const count : {std::uint64_t(1) << 40U, ~std::uint64_t(0)}) {
+		CAPTURE(count);
+		auto changed = cached.cache;
+		std::memcpy(&changed[offset], &count, sizeof(count));
+		write_file(cache_filename, changed);
+		bool hit = true;
+		CHECK_NOTHROW(hit = cache_hit());
+		CHECK_FALSE(hit);
+	}
+
+	// the station's using_early flag, a bool can only be 0 or 1
+	auto changed = cached.cache;
+	changed[offset + sizeof(std::uint64_t) + sizeof(bve::util::datatypes::Time)] = 2;
+	write_file(cache_filename, changed);
+	bool hit = true;
+	CHECK_NOTHROW(hit = cache_hit());
+	CHECK_FALSE(hit);
+
+	write_file(cache_filename, cached.cache);
+	CHECK(cache_hit());
+
+	remove_files();
+}
+
+TEST_SUITE_END();
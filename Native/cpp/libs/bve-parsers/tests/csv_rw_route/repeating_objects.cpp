@@ -0,0 +1,135 @@
+#include "parsers/csv_rw_route.hpp"
+#include "sample_route.hpp"
+#include <algorithm>
+#include <cppfs/FileHandle.h>
+#include <cppfs/fs.h>
+#include <doctest/doctest.h>
+#include <ostream>
+#include <utility>
+
+using namespace std::string_literals;
+namespace cs = bve::parsers::csv_rw_route;
+
+namespace {
+	using Placed = std::vector<std::pair<float, std::string>>;
+
+	// Track positions and files of the objects whose file starts with prefix, in track order. Routes here are straight from the
+	// origin, so z is the track position.
+	Placed placed(const std::string& track, const std::string& prefix) {
+		auto const filename = "repeating_objects.csv"s;
+		auto sample = parse_sample_route(filename,
+		                                 "With Structure\n"
+		                                 ".Rail(0) rail0.csv\n"
+		                                 ".Rail(1) rail1.csv\n"
+		                                 ".Pole(0;0) pole.csv\n"
+		                                 ".WallL(0) wall.csv\n"
+		                                 "With Track\n"
+		                                 "0, .Pitch 0\n"
+		                                     + track);
+		cppfs::fs::open(filename).remove();
+		cs::execute_instructions_pass3(sample.route, sample.list, sample.errors, rel_file_func);
+
+		Placed result;
+		for (auto const& object : sample.route.objects) {
+			auto const& file = sample.route.object_filenames[object.filename];
+			if (file.compare(0, prefix.size(), prefix) == 0) {
+				result.emplace_back(object.position.z, file);
+			}
+		}
+		std::stable_sort(result.begin(), result.end(), [](auto const& a, auto const& b) { return a.first < b.first; });
+		return result;
+	}
+} // namespace
+
+TEST_SUITE_BEGIN("libparsers - csv_rw_route - repeating objects");
+
+TEST_CASE("libparsers - csv_rw_route - repeating objects - fixed grid") {
+	// Used to restart at 30 and 80: 0, 25, 30, 55, 80, 105, 130
+	auto const track =
+	    "With Track\n"
+	    "30, .RailType 0;1\n"
+	    "80, .RailType 0;0\n"
+	    "150, .Height 0\n"s;
+
+	Placed const expected = {{0, "rail0.csv"}, {25, "rail0.csv"}, {50, "rail1.csv"}, {75, "rail1.csv"},
+	                         {100, "rail0.csv"}, {125, "rail0.csv"}};
+	CHECK(placed(track, "rail") == expected);
+}
+
+TEST_CASE("libparsers - csv_rw_route - repeating objects - rail cycles") {
+	// Used to take the cycle entry at the end of the range for every object, so all of them were rail0
+	auto const track =
+	    "With Cycle\n"
+	    ".Rail(0) 0;1\n"
+	    "With Track\n"
+	    "100, .Height 0\n"s;
+
+	Placed const expected = {{0, "rail0.csv"}, {25, "rail1.csv"}, {50, "rail0.csv"}, {75, "rail1.csv"}};
+	CHECK(placed(track, "rail") == expected);
+}
+
+TEST_CASE("libparsers - csv_rw_route - repeating objects - missing cycle entry") {
+	// Structure 5 doesn't exist. Used to give up on the whole range up to 75, which ends on the missing entry, without moving on,
+	// so the next range started over at 0 and placed rail0 everywhere.
+	auto const track =
+	    "With Cycle\n"
+	    ".Rail(0) 0;5\n"
+	    "With Track\n"
+	    "75, .RailType 0;0\n"
+	    "110, .Height 0\n"s;
+
+	Placed const expected = {{0, "rail0.csv"}, {50, "rail0.csv"}, {100, "rail0.csv"}};
+	CHECK(placed(track, "rail") == expected);
+}
+
+TEST_CASE("libparsers - csv_rw_route - repeating objects - poles") {
+	// Used to put every pole of a range at its end, here all four at 200
+	auto const track =
+	    "With Track\n"
+	    ".Pole 0;0;0;50;0\n"
+	    "200, .Height 0\n"s;
+
+	Placed const expected = {{0, "pole.csv"}, {50, "pole.csv"}, {100, "pole.csv"}, {150, "pole.csv"}};
+	CHECK(placed(track, "pole") == expected);
+}
+
+TEST_CASE("libparsers - csv_rw_route - repeating objects - inactive stretches") {
+	// Restarting a rail or wall used to fill in the stretch where it was off
+	auto const track =
+	    "With Track\n"
+	    ".RailStart 1;3.8;0;1\n"
+	    ".Wall 0;-1;0\n"
+	    "50, .RailEnd 1\n"
+	    ".WallEnd 0\n"
+	    "150, .RailStart 1;3.8;0;1\n"
+	    ".Wall 0;-1;0\n"
+	    "200, .Height 0\n"s;
+
+	Placed const rails = {{0, "rail1.csv"}, {25, "rail1.csv"}, {150, "rail1.csv"}, {175, "rail1.csv"}};
+	CHECK(placed(track, "rail1") == rails);
+
+	Placed const walls = {{0, "wall.csv"}, {25, "wall.csv"}, {150, "wall.csv"}, {175, "wall.csv"}};
+	CHECK(placed(track, "wall") == walls);
+}
+
+TEST_CASE("libparsers - csv_rw_route - repeating objects - ended rail") {
+	// Ending a rail only placed its rails, its walls and poles were left for later when the rail was already inactive, so none of
+	// them were placed
+	auto const track =
+	    "With Track\n"
+	    ".RailStart 1;3.8;0;1\n"
+	    ".Wall 1;-1;0\n"
+	    ".Pole 1;0;0;25;0\n"
+	    "60, .RailEnd 1\n"
+	    "100, .WallEnd 1\n"
+	    ".PoleEnd 1\n"
+	    "150, .Height 0\n"s;
+
+	Placed const walls = {{0, "wall.csv"}, {25, "wall.csv"}, {50, "wall.csv"}};
+	CHECK(placed(track, "wall") == walls);
+
+	Placed const poles = {{0, "pole.csv"}, {25, "pole.csv"}, {50, "pole.csv"}};
+	CHECK(placed(track, "pole") == poles);
+}
+
+TEST_SUITE_END();
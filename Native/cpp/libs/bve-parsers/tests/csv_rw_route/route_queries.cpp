@@ -0,0 +1,115 @@
+#include "parsers/csv_rw_route.hpp"
+#include "sample_route.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cppfs/FileHandle.h>
+#include <cppfs/fs.h>
+#include <doctest/doctest.h>
+#include <ostream>
+
+using namespace std::string_literals;
+namespace cs = bve::parsers::csv_rw_route;
+
+namespace {
+	// Sine of the cant of the block starting at each position, after running the route through pass 2
+	std::vector<float> cant_sines(const std::string& options, const std::string& track, const std::vector<float>& positions) {
+		auto const filename = "route_queries_cant.csv"s;
+		auto const sample = parse_sample_route(filename, options + "With Track\n0, .Pitch 0\n" + track);
+		cppfs::fs::open(filename).remove();
+
+		std::vector<float> result;
+		for (float const position : positions) {
+			auto const block = std::find_if(sample.route.blocks.begin(), sample.route.blocks.end(),
+			                                [&](const cs::RailBlockInfo& b) { return b.position == position; });
+			REQUIRE(block != sample.route.blocks.end());
+			result.emplace_back(block->curve.cant_sin);
+		}
+		return result;
+	}
+} // namespace
+
+TEST_SUITE_BEGIN("libparsers - csv_rw_route - route queries");
+
+TEST_CASE("libparsers - csv_rw_route - route queries - ground height") {
+	cs::ParsedRoute route;
+
+	CHECK_EQ(cs::ground_height_at(route, 10), 0);
+
+	route.ground_height = {{0, 1}, {100, 3}, {200, 3}, {300, -1}};
+
+	CHECK_EQ(cs::ground_height_at(route, -50), 1);
+	CHECK_EQ(cs::ground_height_at(route, 0), 1);
+	CHECK_EQ(cs::ground_height_at(route, 50), doctest::Approx(2));
+	CHECK_EQ(cs::ground_height_at(route, 100), 3);
+	CHECK_EQ(cs::ground_height_at(route, 150), 3);
+	CHECK_EQ(cs::ground_height_at(route, 250), doctest::Approx(1));
+	CHECK_EQ(cs::ground_height_at(route, 400), -1);
+}
+
+TEST_CASE("libparsers - csv_rw_route - route queries - ground height cursor") {
+	cs::ParsedRoute route;
+	route.ground_height = {{0, 0}, {25, 1}, {50, 2}, {75, 3}, {100, 4}, {125, 5}, {150, 6}, {175, 7}, {200, 8}};
+
+	cs::GroundHeightCursor cursor(route);
+
+	// walking forwards, then jumping backwards and far ahead must agree with the stateless query
+	for (float const position : {0.0F, 10.0F, 30.0F, 60.0F, 60.0F, 199.0F, 12.5F, 180.0F, -5.0F, 250.0F, 137.5F}) {
+		CHECK_EQ(cursor.at(position), doctest::Approx(cs::ground_height_at(route, position)));
+	}
+}
+
+TEST_CASE("libparsers - csv_rw_route - route queries - evaluate block") {
+	for (float const radius : {0.0F, 300.0F, -300.0F, -50.0F}) {
+		for (float const pitch : {0.0F, 0.02F, -0.03F}) {
+			for (float const angle : {0.0F, 0.7F, 2.5F, -1.9F}) {
+				cs::RailBlockInfo block;
+				block.radius = radius;
+				block.cache.location = glm::vec3(10, 3, -7);
+				block.cache.direction = glm::vec3(std::sin(angle), pitch, std::cos(angle));
+				cs::calculate_curve_parameters(block, 1435);
+
+				for (float const distance : {0.0F, 5.0F, 25.0F, 100.0F}) {
+					auto const expected = bve::util::math::evaluate_curve(block.cache.location, block.cache.direction, distance, radius);
+					auto const actual = cs::evaluate_block(block, distance);
+
+					CHECK_EQ(actual.position.x, doctest::Approx(expected.position.x).epsilon(0.001));
+					CHECK_EQ(actual.position.y, doctest::Approx(expected.position.y).epsilon(0.001));
+					CHECK_EQ(actual.position.z, doctest::Approx(expected.position.z).epsilon(0.001));
+					CHECK_EQ(actual.tangent.x, doctest::Approx(expected.tangent.x).epsilon(0.001));
+					CHECK_EQ(actual.tangent.y, doctest::Approx(expected.tangent.y).epsilon(0.001));
+					CHECK_EQ(actual.tangent.z, doctest::Approx(expected.tangent.z).epsilon(0.001));
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("libparsers - csv_rw_route - route queries - cant side") {
+	auto const track =
+	    "25, .Curve 300;100\n"
+	    "50, .Curve -300;100\n"
+	    "75, .Curve 300;-100\n"
+	    "100, .Curve -300;-100\n"
+	    "125, .Curve 0;100\n"
+	    "150, .Height 0\n"s;
+	std::vector<float> const positions = {25, 50, 75, 100, 125};
+
+	// Unsigned cant used to lean right on every curve, it follows the curve regardless of the sign given
+	auto const unsigned_cant = cant_sines("", track, positions);
+	CHECK_GT(unsigned_cant[0], 0);
+	CHECK_LT(unsigned_cant[1], 0);
+	CHECK_GT(unsigned_cant[2], 0);
+	CHECK_LT(unsigned_cant[3], 0);
+	CHECK_EQ(unsigned_cant[4], 0);
+	CHECK_EQ(unsigned_cant[1], doctest::Approx(-unsigned_cant[0]));
+
+	// Signed cant is taken as given
+	auto const signed_cant = cant_sines("With Options\n.CantBehavior 1\n", track, positions);
+	CHECK_GT(signed_cant[0], 0);
+	CHECK_GT(signed_cant[1], 0);
+	CHECK_LT(signed_cant[2], 0);
+	CHECK_LT(signed_cant[3], 0);
+	CHECK_GT(signed_cant[4], 0);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,177 @@
+#include "parsers/csv_rw_route.hpp"
+#include "sample_route.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cppfs/FileHandle.h>
+#include <cppfs/fs.h>
+#include <doctest/doctest.h>
+#include <ostream>
+#include <stdexcept>
+#include <tuple>
+
+using namespace std::string_literals;
+namespace cs = bve::parsers::csv_rw_route;
+
+namespace {
+	// Straight track from the origin, so the z of every object is its track position
+	auto const route_contents =
+	    "With Structure\n"
+	    ".Rail(0) rail0.csv\n"
+	    ".Rail(1) rail1.csv\n"
+	    ".Rail(2) rail2.csv\n"
+	    ".WallL(0) wall_l.csv\n"
+	    ".WallR(0) wall_r.csv\n"
+	    ".DikeL(0) dike_l.csv\n"
+	    ".Pole(0;0) pole.csv\n"
+	    ".Ground(0) ground0.csv\n"
+	    ".Ground(1) ground1.csv\n"
+	    ".FreeObj(0) tree.csv\n"
+	    "With Cycle\n"
+	    ".Rail(0) 0;1\n"
+	    ".Ground(0) 0;1;1\n"
+	    "With Track\n"
+	    "0, .Pitch 0\n"
+	    ".Limit 60\n"
+	    ".Section 0;2\n"
+	    ".Ground 0\n"
+	    ".Pole 0;0;0;50;0\n"
+	    ".RailStart 1;3.8;0;2\n"
+	    ".Wall 0;-1;0\n"
+	    "12, .FreeObj 0;0;3;0\n"
+	    "30, .Beacon 0;0;0;7\n"
+	    ".Dike 1;-1;0\n"
+	    "60, .Limit 90\n"
+	    ".FreeObj 1;0;-2;0\n"
+	    "85, .Wall 0;1;0\n"
+	    "110, .RailEnd 1\n"
+	    ".Section 0;4\n"
+	    "137, .FreeObj 0;0;5;0\n"
+	    ".Beacon 1;0;0;8\n"
+	    "175, .WallEnd 0\n"
+	    ".DikeEnd 1\n"
+	    "200, .RailStart 1;-3.8;0;1\n"
+	    ".Limit 45\n"
+	    "250, .PoleEnd 0\n"
+	    ".Height 1\n"
+	    "310, .FreeObj 1;0;1;0\n"
+	    ".Section 2;4;0\n"
+	    "375, .Beacon 2;0;0;9\n"
+	    "400, .Limit 120\n"s;
+
+	auto const route_filename = "streaming_route.csv"s;
+
+	using ObjectKey = std::tuple<float, float, float, std::string, bool>;
+
+	std::vector<ObjectKey> sorted_keys(const std::vector<cs::RailObjectInfo>& objects, const cs::FilenameSet& filenames) {
+		std::vector<ObjectKey> keys;
+		keys.reserve(objects.size());
+		for (auto const& object : objects) {
+			keys.emplace_back(object.position.z, object.position.x, object.position.y, filenames[object.filename], object.flip_x);
+		}
+		std::sort(keys.begin(), keys.end());
+		return keys;
+	}
+
+	template <class T>
+	void check_positions(const std::vector<T>& values, float const start, float const end) {
+		for (auto const& value : values) {
+			CHECK_LE(start, value.position);
+			CHECK_LT(value.position, end);
+		}
+	}
+} // namespace
+
+TEST_SUITE_BEGIN("libparsers - csv_rw_route - streaming");
+
+TEST_CASE("libparsers - csv_rw_route - streaming - matches non-streaming pass 3") {
+	auto const sample = parse_sample_route(route_filename, route_contents);
+	cppfs::fs::open(route_filename).remove();
+
+	auto whole = sample;
+	cs::execute_instructions_pass3(whole.route, whole.list, whole.errors, rel_file_func);
+	REQUIRE_FALSE(whole.route.objects.empty());
+	REQUIRE_FALSE(whole.route.limits.empty());
+	REQUIRE_FALSE(whole.route.sections.empty());
+	REQUIRE_FALSE(whole.route.beacons.empty());
+	auto const expected_objects = sorted_keys(whole.route.objects, whole.route.object_filenames);
+
+	// shorter than a block, a block, not a multiple of a block, longer than a block, longer than the route
+	for (float const chunk_length : {10.0F, 25.0F, 40.0F, 100.0F, 1000.0F}) {
+		CAPTURE(chunk_length);
+
+		auto streamed = sample;
+		std::vector<cs::RouteChunk> chunks;
+		cs::execute_instructions_pass3(streamed.route, streamed.list, streamed.errors, rel_file_func, chunk_length,
+		                               [&](cs::RouteChunk&& chunk) { chunks.emplace_back(std::move(chunk)); });
+
+		// nothing is left behind in the route
+		CHECK(streamed.route.objects.empty());
+		CHECK(streamed.route.limits.empty());
+		CHECK(streamed.route.sections.empty());
+		CHECK(streamed.route.beacons.empty());
+
+		REQUIRE_FALSE(chunks.empty());
+		CHECK_EQ(chunks.front().start, 0);
+		CHECK(std::isinf(chunks.back().end));
+
+		cs::RouteChunk joined;
+		for (std::size_t i = 0; i < chunks.size(); ++i) {
+			CAPTURE(i);
+			auto const& chunk = chunks[i];
+			CHECK_LT(chunk.start, chunk.end);
+			if (i != 0) {
+				CHECK_EQ(chunk.start, chunks[i - 1].end);
+			}
+
+			for (auto const& object : chunk.objects) {
+				CHECK_LE(chunk.start, object.position.z);
+				CHECK_LT(object.position.z, chunk.end);
+			}
+			check_positions(chunk.limits, chunk.start, chunk.end);
+			check_positions(chunk.sections, chunk.start, chunk.end);
+			check_positions(chunk.beacons, chunk.start, chunk.end);
+
+			joined.objects.insert(joined.objects.end(), chunk.objects.begin(), chunk.objects.end());
+			joined.limits.insert(joined.limits.end(), chunk.limits.begin(), chunk.limits.end());
+			joined.sections.insert(joined.sections.end(), chunk.sections.begin(), chunk.sections.end());
+			joined.beacons.insert(joined.beacons.end(), chunk.beacons.begin(), chunk.beacons.end());
+		}
+
+		// in track order, and the same objects as without streaming
+		CHECK(std::is_sorted(joined.objects.begin(), joined.objects.end(),
+		                     [](const cs::RailObjectInfo& a, const cs::RailObjectInfo& b) { return a.position.z < b.position.z; }));
+		CHECK(sorted_keys(joined.objects, streamed.route.object_filenames) == expected_objects);
+
+		REQUIRE_EQ(joined.limits.size(), whole.route.limits.size());
+		for (std::size_t i = 0; i < joined.limits.size(); ++i) {
+			CHECK_EQ(joined.limits[i].position, whole.route.limits[i].position);
+			CHECK_EQ(joined.limits[i].value, whole.route.limits[i].value);
+		}
+
+		REQUIRE_EQ(joined.sections.size(), whole.route.sections.size());
+		for (std::size_t i = 0; i < joined.sections.size(); ++i) {
+			CHECK_EQ(joined.sections[i].position, whole.route.sections[i].position);
+			CHECK_EQ(joined.sections[i].value, whole.route.sections[i].value);
+		}
+
+		REQUIRE_EQ(joined.beacons.size(), whole.route.beacons.size());
+		for (std::size_t i = 0; i < joined.beacons.size(); ++i) {
+			CHECK_EQ(joined.beacons[i].position, whole.route.beacons[i].position);
+			CHECK_EQ(joined.beacons[i].beacon_type, whole.route.beacons[i].beacon_type);
+			CHECK_EQ(joined.beacons[i].beacon_data, whole.route.beacons[i].beacon_data);
+		}
+	}
+}
+
+TEST_CASE("libparsers - csv_rw_route - streaming - chunk length must be positive") {
+	auto sample = parse_sample_route(route_filename, route_contents);
+	cppfs::fs::open(route_filename).remove();
+
+	for (float const chunk_length : {0.0F, -25.0F, std::nanf("")}) {
+		CHECK_THROWS_AS(cs::execute_instructions_pass3(sample.route, sample.list, sample.errors, rel_file_func, chunk_length,
+		                                               [](cs::RouteChunk&&) {}),
+		                std::invalid_argument);
+	}
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,53 @@
+#include "parsers/object_loader.hpp"
+#include "sample_relative_file_func.hpp"
+#include <cppfs/FileHandle.h>
+#include <cppfs/fs.h>
+#include <doctest/doctest.h>
+#include <ostream>
+
+using namespace std::string_literals;
+namespace ol = bve::parsers::object_loader;
+
+namespace {
+	void write_to_file(std::string const& filename, std::string const& contents) {
+		cppfs::FileHandle file = cppfs::fs::open(filename);
+		auto const ofs = file.createOutputStream();
+		*ofs << contents;
+	}
+} // namespace
+
+TEST_SUITE_BEGIN("libparsers - object_loader");
+
+TEST_CASE("libparsers - object_loader - load_objects") {
+	write_to_file("loader_cube.csv"s, "CreateMeshBuilder\nCube, 1, 1, 1\n"s);
+	write_to_file("loader_cube.b3d"s, "[MeshBuilder]\nCube 1, 1, 1\n"s);
+
+	bve::util::StringInterner filenames;
+	auto const csv_id = filenames.insert("loader_cube.csv"s);
+	auto const missing_id = filenames.insert("loader_missing.csv"s);
+	auto const b3d_id = filenames.insert("loader_cube.b3d"s);
+	auto const unknown_id = filenames.insert("loader_cube.x"s);
+
+	auto const objects = ol::load_objects(filenames, "."s, rel_file_func, {}, 2);
+
+	cppfs::fs::open("loader_cube.csv"s).remove();
+	cppfs::fs::open("loader_cube.b3d"s).remove();
+
+	REQUIRE_EQ(objects.size(), 4);
+
+	CHECK_EQ(objects[csv_id].path, "./loader_cube.csv"s);
+	REQUIRE(objects[csv_id].object.is<bve::parsers::b3d_csv_object::ParsedB3DCSVObject>());
+	CHECK_EQ(objects[csv_id].object.get<bve::parsers::b3d_csv_object::ParsedB3DCSVObject>().meshes.size(), 1);
+	CHECK(objects[csv_id].errors.empty());
+
+	REQUIRE(objects[b3d_id].object.is<bve::parsers::b3d_csv_object::ParsedB3DCSVObject>());
+	CHECK_EQ(objects[b3d_id].object.get<bve::parsers::b3d_csv_object::ParsedB3DCSVObject>().meshes.size(), 1);
+
+	CHECK(objects[missing_id].object.is<ol::NoObject>());
+	CHECK_EQ(objects[missing_id].errors.size(), 1);
+
+	CHECK(objects[unknown_id].object.is<ol::NoObject>());
+	CHECK_EQ(objects[unknown_id].errors.size(), 1);
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "parsers/csv_rw_route.hpp"
+#include "sample_relative_file_func.hpp"
+#include <cppfs/FileHandle.h>
+#include <cppfs/fs.h>
+#include <string>
+
+// A route that went through everything before pass 3, so either version of pass 3 can be run on a copy of it
+struct SampleRoute {
+	bve::parsers::csv_rw_route::PreprocessedLines lines;
+	bve::parsers::csv_rw_route::InstructionList list;
+	bve::parsers::csv_rw_route::ParsedRoute route;
+	bve::parsers::errors::MultiError errors;
+};
+
+// Writes contents to filename and parses it as a csv route. The file is left behind for tests that need it; remove it when done.
+inline SampleRoute parse_sample_route(const std::string& filename, const std::string& contents) {
+	namespace cs = bve::parsers::csv_rw_route;
+
+	{
+		cppfs::FileHandle file = cppfs::fs::open(filename);
+		auto const ofs = file.createOutputStream();
+		*ofs << contents;
+	}
+
+	SampleRoute sample;
+	auto rng = bve::util::datatypes::RNG{1};
+	sample.lines = cs::process_include_directives(filename, rng, sample.errors, cs::FileType::csv, rel_file_func);
+	cs::preprocess_file(sample.lines, rng, sample.errors, cs::FileType::csv);
+	sample.list = cs::generate_instructions(sample.lines, sample.errors, cs::FileType::csv);
+	cs::execute_instructions_pass1(sample.list, sample.errors);
+	sample.route = cs::execute_instructions_pass2(sample.list, sample.errors);
+	return sample;
+}
@@ -0,0 +1,91 @@
+#include "parsers/static_batching.hpp"
+#include "sample_relative_file_func.hpp"
+#include <doctest/doctest.h>
+#include <ostream>
+
+using namespace std::string_literals;
+namespace sb = bve::parsers::static_batching;
+namespace cs = bve::parsers::csv_rw_route;
+
+TEST_SUITE_BEGIN("libparsers - static_batching");
+
+TEST_CASE("libparsers - static_batching - build_static_batches") {
+	std::vector<bve::parsers::object_loader::LoadedObject> objects(2);
+	// two cubes with different colors, so two materials
+	objects[0].object = bve::parsers::b3d_csv_object::parse_csv(
+	    "CreateMeshBuilder\nCube, 1, 1, 1\nCreateMeshBuilder\nCube, 1, 1, 1\nSetColor, 255, 0, 0\n"s);
+	// objects[1] failed to load
+
+	std::vector<cs::RailObjectInfo> placements(4);
+	placements[0].filename = 0;
+	placements[0].position = glm::vec3(10, 0, 10);
+	placements[1].filename = 0;
+	placements[1].position = glm::vec3(20, 0, 400);
+	placements[2].filename = 0;
+	placements[2].position = glm::vec3(0, 0, 1200);
+	placements[3].filename = 1;
+
+	auto const result = sb::build_static_batches(placements, objects, rel_file_func, 500);
+
+	CHECK_EQ(result.unbatched_objects, std::vector<std::size_t>{3});
+
+	REQUIRE_EQ(result.chunks.size(), 2);
+	CHECK_EQ(result.chunks[0].cell_z, 0);
+	CHECK_EQ(result.chunks[1].cell_z, 2);
+	CHECK_EQ(result.chunks[0].batch_count, 2);
+	CHECK_EQ(result.chunks[1].batch_count, 2);
+	REQUIRE_EQ(result.batches.size(), 4);
+
+	// every batch of the first chunk holds both placements' meshes
+	auto const& mesh = objects[0].object.get<bve::parsers::b3d_csv_object::ParsedB3DCSVObject>().meshes[0];
+	CHECK_EQ(result.batches[0].index_count, mesh.indices.size() * 2);
+	CHECK_EQ(result.batches[2].index_count, mesh.indices.size());
+	CHECK_EQ(result.vertices.size(), mesh.verts.size() * 6);
+	CHECK_EQ(result.indices.size(), mesh.indices.size() * 6);
+	CHECK_EQ(result.face_data.size(), result.indices.size() / 3);
+
+	// vertices are moved to world space
+	CHECK_EQ(result.chunks[0].min.x, doctest::Approx(9));
+	CHECK_EQ(result.chunks[0].max.z, doctest::Approx(401));
+	CHECK_EQ(result.chunks[1].min.z, doctest::Approx(1199));
+
+	for (auto const index : result.indices) {
+		REQUIRE_LT(index, result.vertices.size());
+	}
+}
+
+TEST_CASE("libparsers - static_batching - build_static_batches - textures are per folder") {
+	// the folder of the object, then the texture
+	auto const resolve = [](const std::string& base, const std::string& relative) {
+		return base.substr(0, base.find_last_of('/') + 1) + relative;
+	};
+
+	auto const contents = "CreateMeshBuilder\nCube, 1, 1, 1\nLoadTexture, rail.png\n"s;
+	std::vector<bve::parsers::object_loader::LoadedObject> objects(3);
+	objects[0].path = "a/rail.csv"s;
+	objects[0].object = bve::parsers::b3d_csv_object::parse_csv(contents);
+	objects[1].path = "b/rail.csv"s;
+	objects[1].object = bve::parsers::b3d_csv_object::parse_csv(contents);
+	// same folder as the first one, so the same texture
+	objects[2].path = "a/rail2.csv"s;
+	objects[2].object = bve::parsers::b3d_csv_object::parse_csv(contents);
+
+	std::vector<cs::RailObjectInfo> placements(3);
+	for (std::size_t i = 0; i < placements.size(); ++i) {
+		placements[i].filename = static_cast<cs::FilenameID>(i);
+		placements[i].position = glm::vec3(0, 0, 25 * float(i));
+	}
+
+	auto const result = sb::build_static_batches(placements, objects, resolve);
+
+	REQUIRE_EQ(result.chunks.size(), 1);
+	REQUIRE_EQ(result.batches.size(), 2);
+	CHECK_EQ(result.batches[0].texture.file, "a/rail.png"s);
+	CHECK_EQ(result.batches[1].texture.file, "b/rail.png"s);
+
+	auto const& mesh = objects[0].object.get<bve::parsers::b3d_csv_object::ParsedB3DCSVObject>().meshes[0];
+	CHECK_EQ(result.batches[0].index_count, mesh.indices.size() * 2);
+	CHECK_EQ(result.batches[1].index_count, mesh.indices.size());
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,126 @@
+#include "parsers/texture_atlas.hpp"
+#include <doctest/doctest.h>
+
+using namespace std::string_literals;
+
+namespace atlas = bve::parsers::texture_atlas;
+// ReSharper disable once CppInconsistentNaming
+namespace b3d = bve::parsers::b3d_csv_object;
+
+TEST_SUITE_BEGIN("libparsers - texture_atlas");
+
+namespace {
+	bve::parsers::dependencies::Texture texture(std::string file) {
+		bve::parsers::dependencies::Texture result;
+		result.file = std::move(file);
+		return result;
+	}
+
+	bool overlaps(atlas::Placement const& lhs, atlas::Placement const& rhs, int const padding) {
+		auto const lhs_min = lhs.position - padding;
+		auto const lhs_max = lhs.position + lhs.size + padding;
+		auto const rhs_min = rhs.position - padding;
+		auto const rhs_max = rhs.position + rhs.size + padding;
+		return lhs_min.x < rhs_max.x && rhs_min.x < lhs_max.x && lhs_min.y < rhs_max.y && rhs_min.y < lhs_max.y;
+	}
+} // namespace
+
+TEST_CASE("libparsers - texture_atlas - packing") {
+	std::vector<atlas::AtlasInput> inputs;
+	for (int i = 0; i < 60; ++i) {
+		inputs.emplace_back(atlas::AtlasInput{texture("tex"s + std::to_string(i)), glm::ivec2(8 + (i * 7) % 57, 8 + (i * 13) % 41)});
+	}
+	// duplicate, too big and empty
+	inputs.emplace_back(atlas::AtlasInput{texture("tex0"), glm::ivec2(8, 8)});
+	inputs.emplace_back(atlas::AtlasInput{texture("big"), glm::ivec2(512, 16)});
+	inputs.emplace_back(atlas::AtlasInput{texture("empty"), glm::ivec2(0, 0)});
+
+	atlas::AtlasOptions options;
+	options.page_size = {256, 256};
+	options.padding = 2;
+
+	auto const result = atlas::pack_atlas(inputs, options);
+
+	CHECK_EQ(result.placements.size(), 60);
+	REQUIRE_EQ(result.unplaced.size(), 2);
+	CHECK_EQ(result.unplaced[0].file, "big");
+	CHECK_EQ(result.unplaced[1].file, "empty");
+	// doesn't fit on one page
+	REQUIRE_GT(result.pages.size(), 1);
+	CHECK_EQ(result.pages[1].file, "atlas:1");
+
+	for (auto const& lhs : result.placements) {
+		auto const& placement = lhs.second;
+		CAPTURE(lhs.first.file);
+		REQUIRE_LT(placement.page, result.pages.size());
+		CHECK_GE(placement.position.x, options.padding);
+		CHECK_GE(placement.position.y, options.padding);
+		CHECK_LE(placement.position.x + placement.size.x + options.padding, options.page_size.x);
+		CHECK_LE(placement.position.y + placement.size.y + options.padding, options.page_size.y);
+		CHECK_EQ(placement.uv_offset.x * 256, doctest::Approx(placement.position.x));
+		CHECK_EQ(placement.uv_scale.y * 256, doctest::Approx(placement.size.y));
+
+		for (auto const& rhs : result.placements) {
+			if (lhs.first < rhs.first && placement.page == rhs.second.page) {
+				CHECK_FALSE(overlaps(placement, rhs.second, options.padding));
+			}
+		}
+	}
+}
+
+TEST_CASE("libparsers - texture_atlas - composing") {
+	atlas::AtlasOptions options;
+	options.page_size = {8, 8};
+	options.padding = 1;
+
+	auto const result = atlas::pack_atlas({atlas::AtlasInput{texture("a"), glm::ivec2(2, 1)}}, options);
+	REQUIRE_EQ(result.pages.size(), 1);
+	auto const& placement = result.placements.at(texture("a"));
+
+	std::vector<std::uint8_t> const pixels{1, 2, 3, 4, 5, 6, 7, 8};
+	auto const page = atlas::compose_page(result, 0, [&](bve::parsers::dependencies::Texture const& requested) {
+		CHECK_EQ(requested.file, "a");
+		return pixels.data();
+	});
+
+	REQUIRE_EQ(page.size(), 8 * 8 * 4);
+	auto const at = [&](glm::ivec2 const position) { return page[4 * std::size_t(position.y * 8 + position.x)]; };
+	CHECK_EQ(at(placement.position), 1);
+	CHECK_EQ(at(placement.position + glm::ivec2(1, 0)), 5);
+	// padding repeats the edges
+	CHECK_EQ(at(placement.position + glm::ivec2(-1, -1)), 1);
+	CHECK_EQ(at(placement.position + glm::ivec2(2, 1)), 5);
+}
+
+TEST_CASE("libparsers - texture_atlas - remapping") {
+	atlas::AtlasOptions options;
+	options.page_size = {64, 64};
+	options.padding = 0;
+	auto const result = atlas::pack_atlas({atlas::AtlasInput{texture("a"), glm::ivec2(32, 16)}}, options);
+	auto const& placement = result.placements.at(texture("a"));
+
+	b3d::ParsedB3DCSVObject object;
+	object.meshes.resize(3);
+	object.meshes[0].texture = texture("a");
+	object.meshes[0].verts = {b3d::Vertex{{}, {}, {0, 0}}, b3d::Vertex{{}, {}, {1, 1}}};
+	// repeats, so it can't use the atlas
+	object.meshes[1].texture = texture("a");
+	object.meshes[1].verts = {b3d::Vertex{{}, {}, {0, 0}}, b3d::Vertex{{}, {}, {2, 1}}};
+	object.meshes[2].texture = texture("b");
+	object.dependencies.textures = {texture("a"), texture("b")};
+
+	CHECK_EQ(atlas::remap_texture_coords(object, result), 1);
+
+	CHECK_EQ(object.meshes[0].texture.file, "atlas:0");
+	CHECK_EQ(object.meshes[0].verts[0].texture_coord.x, doctest::Approx(placement.uv_offset.x));
+	CHECK_EQ(object.meshes[0].verts[1].texture_coord.x, doctest::Approx(placement.uv_offset.x + 0.5));
+	CHECK_EQ(object.meshes[0].verts[1].texture_coord.y, doctest::Approx(placement.uv_offset.y + 0.25));
+	CHECK_EQ(object.meshes[1].texture.file, "a");
+	CHECK_EQ(object.meshes[1].verts[1].texture_coord.x, doctest::Approx(2));
+
+	// a is still used by the second mesh
+	CHECK_EQ(object.dependencies.textures.size(), 3);
+	CHECK_EQ(object.dependencies.textures.count(result.pages[0]), 1);
+}
+
+TEST_SUITE_END();
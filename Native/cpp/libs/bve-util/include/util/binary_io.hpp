@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace bve::util::binary {
+	/**
+	 * Appends values to a growing byte buffer in native layout. Only meant for caches that are read back by the same build on the
+	 * same platform, so no endian or padding conversion is done. Anything that changes layout must bump the version of the format.
+	 */
+	class Writer {
+	  public:
+		template <class T>
+		void write(T const& value) {
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types may be written directly");
+			writeBytes(&value, sizeof(T));
+		}
+
+		template <class T>
+		void writeArray(T const* const values, std::size_t const count) {
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types may be written directly");
+			write<std::uint64_t>(count);
+			writeBytes(values, sizeof(T) * count);
+		}
+
+		template <class T, class Alloc>
+		void writeArray(std::vector<T, Alloc> const& values) {
+			writeArray(values.data(), values.size());
+		}
+
+		void writeString(std::string const& value) {
+			writeArray(value.data(), value.size());
+		}
+
+		void writeBytes(void const* const data, std::size_t const size) {
+			auto const* bytes = static_cast<char const*>(data);
+			buffer_.insert(buffer_.end(), bytes, bytes + size);
+		}
+
+		std::vector<char> const& buffer() const noexcept {
+			return buffer_;
+		}
+
+		/**
+		 * Write the buffer to disk. The file is written to a temporary name then renamed into place, so a concurrent reader never sees
+		 * a partially written file. Any number of threads and processes may save to the same file at once, the last one to finish
+		 * wins.
+		 *
+		 * \param filename File to write to.
+		 * \return         If writing succeeded.
+		 */
+		bool saveToFile(std::string const& filename) const;
+
+	  private:
+		std::vector<char> buffer_;
+	};
+
+	/**
+	 * Reads values out of a byte range written by \ref Writer. Every read is bounds checked and throws std::out_of_range when the data
+	 * is truncated or holds an impossible value, so corrupted input fails loudly instead of reading out of bounds.
+	 */
+	class Reader {
+	  public:
+		Reader(char const* const data, std::size_t const size) : current_(data), end_(data + size) {}
+
+		template <class T>
+		T read() {
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types may be read directly");
+			T value;
+			std::memcpy(&value, advance(sizeof(T)), sizeof(T));
+			return value;
+		}
+
+		template <class T, class Alloc>
+		void readArray(std::vector<T, Alloc>& values) {
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types may be read directly");
+			auto const count = readCount(sizeof(T));
+			values.resize(count);
+			if (count != 0) {
+				std::memcpy(values.data(), advance(sizeof(T) * count), sizeof(T) * count);
+			}
+		}
+
+		std::string readString() {
+			auto const count = readCount(1);
+			return std::string(advance(count), count);
+		}
+
+		/**
+		 * Read a bool written with \ref Writer::write. Reading the byte straight into a bool is undefined for anything but 0 or 1.
+		 */
+		bool readBool() {
+			auto const value = read<std::uint8_t>();
+			if (value > 1) {
+				throw std::out_of_range("Invalid bool in binary data");
+			}
+			return value == 1;
+		}
+
+		/**
+		 * Read an element count written as a std::uint64_t. Use it for every count that sizes a container, so a garbage count can't
+		 * turn into a gigantic allocation.
+		 *
+		 * \param min_element_size The fewest bytes a single element takes up in the data.
+		 * \return                 The count, which is guaranteed to fit in the remaining data.
+		 */
+		std::size_t readCount(std::size_t const min_element_size) {
+			auto const count = read<std::uint64_t>();
+			if (min_element_size != 0 && count > remaining() / min_element_size) {
+				throw std::out_of_range("Binary data truncated");
+			}
+			return static_cast<std::size_t>(count);
+		}
+
+		std::size_t remaining() const noexcept {
+			return static_cast<std::size_t>(end_ - current_);
+		}
+
+	  private:
+		char const* advance(std::size_t const size) {
+			if (size > remaining()) {
+				throw std::out_of_range("Binary data truncated");
+			}
+			auto const* const ret = current_;
+			current_ += size;
+			return ret;
+		}
+
+		char const* current_;
+		char const* end_;
+	};
+} // namespace bve::util::binary
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace bve::util::hash {
+	/**
+	 * 64-bit FNV-1a hash of a block of memory. Stable across platforms and runs, so it is suitable as an on-disk cache key.
+	 *
+	 * \param data   Pointer to the bytes to hash.
+	 * \param size   Amount of bytes to hash.
+	 * \param seed   Previous hash value to continue from. Allows hashing discontinuous data as if it was one block.
+	 * \return       Hash of the data.
+	 */
+	inline std::uint64_t content_hash(void const* const data, std::size_t const size, std::uint64_t seed = 0xcbf29ce484222325) noexcept {
+		auto const* bytes = static_cast<unsigned char const*>(data);
+		for (std::size_t i = 0; i < size; ++i) {
+			seed ^= bytes[i];
+			seed *= 0x100000001b3;
+		}
+		return seed;
+	}
+
+	inline std::uint64_t content_hash(std::string const& data, std::uint64_t const seed = 0xcbf29ce484222325) noexcept {
+		return content_hash(data.data(), data.size(), seed);
+	}
+} // namespace bve::util::hash
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace bve::util {
+	/**
+	 * Read only memory mapping of an entire file. The mapping lives as long as the object does.
+	 *
+	 * If the file can't be opened or mapped, the object is left invalid rather than throwing, as a missing file is an expected
+	 * condition for all current users (caches).
+	 */
+	class MappedFile {
+	  public:
+		explicit MappedFile(std::string const& filename);
+		MappedFile(MappedFile const&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile const&) = delete;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		~MappedFile();
+
+		char const* data() const noexcept {
+			return data_;
+		}
+
+		std::size_t size() const noexcept {
+			return size_;
+		}
+
+		bool valid() const noexcept {
+			return data_ != nullptr;
+		}
+
+	  private:
+		void unmap() noexcept;
+
+		char const* data_ = nullptr;
+		std::size_t size_ = 0;
+	};
+} // namespace bve::util
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bve::util {
+	/**
+	 * Deduplicating string table. Every distinct string is given a dense 32-bit ID in insertion order, so the table can be stored and
+	 * indexed as a plain contiguous array. Lookups from string to ID go through a hash index.
+	 *
+	 * Not thread safe for insertion, but a fully built interner may be read from any number of threads.
+	 */
+	class StringInterner {
+	  public:
+		using ID = std::uint32_t;
+		using const_iterator = std::vector<std::string>::const_iterator;
+
+		static constexpr ID invalid_id = std::numeric_limits<ID>::max();
+
+		/**
+		 * Insert a string into the table if it isn't already present.
+		 *
+		 * \param value String to intern.
+		 * \return      ID of the string, new or existing.
+		 */
+		ID insert(std::string value);
+
+		/**
+		 * Find the ID of a string without inserting it.
+		 *
+		 * \param value String to look for.
+		 * \return      ID of the string, or \ref invalid_id if it has never been inserted.
+		 */
+		ID find(std::string const& value) const;
+
+		std::string const& operator[](ID const id) const {
+			return strings_[id];
+		}
+
+		/**
+		 * Contiguous ID to string table. Index i holds the string with ID i.
+		 */
+		std::vector<std::string> const& strings() const noexcept {
+			return strings_;
+		}
+
+		std::size_t size() const noexcept {
+			return strings_.size();
+		}
+
+		bool empty() const noexcept {
+			return strings_.empty();
+		}
+
+		const_iterator begin() const noexcept {
+			return strings_.begin();
+		}
+
+		const_iterator end() const noexcept {
+			return strings_.end();
+		}
+
+		void reserve(std::size_t count);
+		void clear() noexcept;
+
+	  private:
+		std::vector<std::string> strings_;
+		std::unordered_map<std::string, ID> index_;
+	};
+} // namespace bve::util
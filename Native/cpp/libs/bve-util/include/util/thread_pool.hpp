@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace bve::util {
+	/**
+	 * Fixed size pool of worker threads with a task queue per worker. Workers take tasks from the back of their own queue and steal
+	 * from the front of the others' when they run dry, so uneven task lengths still keep every thread busy.
+	 *
+	 * Tasks submitted from inside a worker go onto that worker's queue, tasks submitted from outside are spread round-robin.
+	 */
+	class ThreadPool {
+	  public:
+		using Task = std::function<void()>;
+
+		/**
+		 * Start the worker threads.
+		 *
+		 * \param thread_count Amount of workers. 0 uses one per hardware thread.
+		 */
+		explicit ThreadPool(std::size_t thread_count = 0);
+
+		/**
+		 * Runs all tasks still queued, then joins the workers.
+		 */
+		~ThreadPool();
+
+		ThreadPool(ThreadPool const&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(ThreadPool const&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		void submit(Task task);
+
+		/**
+		 * Block until every task submitted so far has finished. Must not be called from a worker.
+		 *
+		 * If any task threw, the first exception is rethrown here once everything is done.
+		 */
+		void wait();
+
+		std::size_t threadCount() const noexcept {
+			return threads_.size();
+		}
+
+	  private:
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		bool tryPop(std::size_t worker, Task& task);
+		void workerLoop(std::size_t worker);
+
+		std::vector<std::unique_ptr<Queue>> queues_;
+		std::vector<std::thread> threads_;
+
+		std::mutex state_mutex_;
+		std::condition_variable work_available_;
+		std::condition_variable work_done_;
+		// tasks sitting in a queue
+		std::size_t queued_ = 0;
+		// tasks queued or running
+		std::size_t pending_ = 0;
+		std::size_t next_queue_ = 0;
+		std::exception_ptr first_exception_;
+		bool stopping_ = false;
+	};
+
+	/**
+	 * Run func(i) for every i in [0, count) on the pool and wait for all of them.
+	 *
+	 * \param pool  Pool to run on.
+	 * \param count Amount of indices.
+	 * \param func  Callable taking a std::size_t. Called concurrently, so it must be safe to do so.
+	 */
+	template <class Func>
+	void parallel_for(ThreadPool& pool, std::size_t const count, Func const& func) {
+		for (std::size_t i = 0; i < count; ++i) {
+			pool.submit([&func, i] { func(i); });
+		}
+		pool.wait();
+	}
+} // namespace bve::util
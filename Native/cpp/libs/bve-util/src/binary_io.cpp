@@ -0,0 +1,67 @@
+#include "util/binary_io.hpp"
+#include <atomic>
+#include <cstdio>
+#include <foundational/util/platform.hpp>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#if defined(FOUNDATIONAL_WINDOWS)
+#	define WIN32_LEAN_AND_MEAN
+#	include <Windows.h>
+#else
+#	include <unistd.h>
+#endif
+
+namespace bve::util::binary {
+	namespace {
+		/**
+		 * Name for the temporary file, unique across threads and processes. Several threads or programs may save the same cache
+		 * entry at once, and a shared name would have them truncate each other's half written file.
+		 */
+		std::string temporary_filename(std::string const& filename) {
+			static std::atomic<std::uint64_t> counter{0};
+#if defined(FOUNDATIONAL_WINDOWS)
+			auto const process = static_cast<std::uint64_t>(GetCurrentProcessId());
+#else
+			auto const process = static_cast<std::uint64_t>(getpid());
+#endif
+			auto const thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+			return filename + "." + std::to_string(process) + "." + std::to_string(thread) + "."
+			       + std::to_string(counter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+		}
+
+		// Replaces the destination atomically, so a concurrent reader sees either the old or the new file
+		bool replace_file(std::string const& from, std::string const& to) {
+#if defined(FOUNDATIONAL_WINDOWS)
+			// plain rename won't replace an existing file on windows
+			return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+			return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+		}
+	} // namespace
+
+	bool Writer::saveToFile(std::string const& filename) const {
+		auto const temp_filename = temporary_filename(filename);
+
+		{
+			std::ofstream file(temp_filename, std::ios::binary | std::ios::trunc);
+			if (!file) {
+				return false;
+			}
+			file.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+			if (!file) {
+				file.close();
+				std::remove(temp_filename.c_str());
+				return false;
+			}
+		}
+
+		if (!replace_file(temp_filename, filename)) {
+			std::remove(temp_filename.c_str());
+			return false;
+		}
+		return true;
+	}
+} // namespace bve::util::binary
@@ -0,0 +1,117 @@
+#include "util/mapped_file.hpp"
+#include <foundational/util/platform.hpp>
+#include <utility>
+
+#if defined(FOUNDATIONAL_WINDOWS)
+#	define WIN32_LEAN_AND_MEAN
+#	include <Windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace bve::util {
+	// An empty file can't be mapped on either platform. It still is a valid file, so point it at a static empty buffer.
+	static char const empty_file_contents[1] = {'\0'};
+
+#if defined(FOUNDATIONAL_WINDOWS)
+	MappedFile::MappedFile(std::string const& filename) {
+		HANDLE const file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			return;
+		}
+
+		LARGE_INTEGER file_size;
+		if (!GetFileSizeEx(file, &file_size)) {
+			CloseHandle(file);
+			return;
+		}
+
+		if (file_size.QuadPart == 0) {
+			CloseHandle(file);
+			data_ = empty_file_contents;
+			return;
+		}
+
+		HANDLE const mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if (mapping == nullptr) {
+			return;
+		}
+
+		void* const view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		// The view keeps the mapping alive
+		CloseHandle(mapping);
+		if (view == nullptr) {
+			return;
+		}
+
+		data_ = static_cast<char const*>(view);
+		size_ = static_cast<std::size_t>(file_size.QuadPart);
+	}
+
+	void MappedFile::unmap() noexcept {
+		if (data_ != nullptr && data_ != empty_file_contents) {
+			UnmapViewOfFile(data_);
+		}
+		data_ = nullptr;
+		size_ = 0;
+	}
+#else
+	MappedFile::MappedFile(std::string const& filename) {
+		int const fd = open(filename.c_str(), O_RDONLY);
+		if (fd == -1) {
+			return;
+		}
+
+		struct stat file_info {};
+		if (fstat(fd, &file_info) != 0 || !S_ISREG(file_info.st_mode)) {
+			close(fd);
+			return;
+		}
+
+		if (file_info.st_size == 0) {
+			close(fd);
+			data_ = empty_file_contents;
+			return;
+		}
+
+		auto const size = static_cast<std::size_t>(file_info.st_size);
+		void* const view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+		// The mapping keeps the file alive
+		close(fd);
+		if (view == MAP_FAILED) {
+			return;
+		}
+
+		data_ = static_cast<char const*>(view);
+		size_ = size;
+	}
+
+	void MappedFile::unmap() noexcept {
+		if (data_ != nullptr && data_ != empty_file_contents) {
+			munmap(const_cast<char*>(data_), size_);
+		}
+		data_ = nullptr;
+		size_ = 0;
+	}
+#endif
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept :
+	    data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)) {}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			unmap();
+			data_ = std::exchange(other.data_, nullptr);
+			size_ = std::exchange(other.size_, 0);
+		}
+		return *this;
+	}
+
+	MappedFile::~MappedFile() {
+		unmap();
+	}
+} // namespace bve::util
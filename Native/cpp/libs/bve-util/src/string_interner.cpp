@@ -0,0 +1,38 @@
+#include "util/string_interner.hpp"
+#include <stdexcept>
+
+namespace bve::util {
+	StringInterner::ID StringInterner::insert(std::string value) {
+		auto const found = index_.find(value);
+		if (found != index_.end()) {
+			return found->second;
+		}
+
+		if (strings_.size() >= invalid_id) {
+			throw std::length_error("StringInterner out of IDs");
+		}
+
+		auto const id = static_cast<ID>(strings_.size());
+		strings_.emplace_back(value);
+		index_.emplace(std::move(value), id);
+		return id;
+	}
+
+	StringInterner::ID StringInterner::find(std::string const& value) const {
+		auto const found = index_.find(value);
+		if (found == index_.end()) {
+			return invalid_id;
+		}
+		return found->second;
+	}
+
+	void StringInterner::reserve(std::size_t const count) {
+		strings_.reserve(count);
+		index_.reserve(count);
+	}
+
+	void StringInterner::clear() noexcept {
+		strings_.clear();
+		index_.clear();
+	}
+} // namespace bve::util
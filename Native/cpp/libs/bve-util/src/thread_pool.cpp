@@ -0,0 +1,141 @@
+#include "util/thread_pool.hpp"
+#include <algorithm>
+
+namespace bve::util {
+	namespace {
+		// Which pool the current thread works for, so tasks submitted by a task stay on the same worker's queue
+		thread_local ThreadPool const* current_pool = nullptr;
+		thread_local std::size_t current_worker = 0;
+	} // namespace
+
+	ThreadPool::ThreadPool(std::size_t thread_count) {
+		if (thread_count == 0) {
+			thread_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+		}
+
+		queues_.reserve(thread_count);
+		for (std::size_t i = 0; i < thread_count; ++i) {
+			queues_.emplace_back(std::make_unique<Queue>());
+		}
+
+		threads_.reserve(thread_count);
+		for (std::size_t i = 0; i < thread_count; ++i) {
+			threads_.emplace_back([this, i] { workerLoop(i); });
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(state_mutex_);
+			stopping_ = true;
+		}
+		work_available_.notify_all();
+
+		for (auto& thread : threads_) {
+			thread.join();
+		}
+	}
+
+	void ThreadPool::submit(Task task) {
+		std::size_t queue;
+		{
+			std::lock_guard<std::mutex> lock(state_mutex_);
+			// counted before it's visible, so a worker never takes a task that isn't accounted for yet
+			++queued_;
+			++pending_;
+			if (current_pool == this) {
+				queue = current_worker;
+			}
+			else {
+				queue = next_queue_;
+				next_queue_ = (next_queue_ + 1) % queues_.size();
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(queues_[queue]->mutex);
+			queues_[queue]->tasks.emplace_back(std::move(task));
+		}
+		work_available_.notify_one();
+	}
+
+	void ThreadPool::wait() {
+		std::unique_lock<std::mutex> lock(state_mutex_);
+		work_done_.wait(lock, [this] { return pending_ == 0; });
+
+		if (first_exception_) {
+			auto const exception = first_exception_;
+			first_exception_ = nullptr;
+			std::rethrow_exception(exception);
+		}
+	}
+
+	bool ThreadPool::tryPop(std::size_t const worker, Task& task) {
+		// own queue first, newest task as it's most likely to still be in cache
+		{
+			auto& own = *queues_[worker];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.tasks.empty()) {
+				task = std::move(own.tasks.back());
+				own.tasks.pop_back();
+				return true;
+			}
+		}
+
+		// steal the oldest task of another worker
+		for (std::size_t offset = 1; offset < queues_.size(); ++offset) {
+			auto& victim = *queues_[(worker + offset) % queues_.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.tasks.empty()) {
+				task = std::move(victim.tasks.front());
+				victim.tasks.pop_front();
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void ThreadPool::workerLoop(std::size_t const worker) {
+		current_pool = this;
+		current_worker = worker;
+
+		while (true) {
+			Task task;
+			if (!tryPop(worker, task)) {
+				std::unique_lock<std::mutex> lock(state_mutex_);
+				if (stopping_ && queued_ == 0) {
+					return;
+				}
+				// queued_ can briefly be ahead of the queues while a submit is in flight, in which case this just retries
+				work_available_.wait(lock, [this] { return stopping_ || queued_ != 0; });
+				continue;
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(state_mutex_);
+				--queued_;
+			}
+
+			std::exception_ptr exception;
+			try {
+				task();
+			}
+			catch (...) {
+				exception = std::current_exception();
+			}
+
+			bool done;
+			{
+				std::lock_guard<std::mutex> lock(state_mutex_);
+				if (exception && !first_exception_) {
+					first_exception_ = exception;
+				}
+				done = --pending_ == 0;
+			}
+			if (done) {
+				work_done_.notify_all();
+			}
+		}
+	}
+} // namespace bve::util
@@ -0,0 +1,118 @@
+#include "util/binary_io.hpp"
+#include <atomic>
+#include <cstdio>
+#include <doctest/doctest.h>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <thread>
+
+using namespace std::string_literals;
+
+TEST_SUITE_BEGIN("libutil - binary_io");
+
+TEST_CASE("libutil - binary_io - round trip") {
+	bve::util::binary::Writer w;
+	w.write<std::uint32_t>(42);
+	w.writeArray(std::vector<float>{1.0f, 2.0f, 3.0f});
+	w.writeString("hello"s);
+
+	auto const& buffer = w.buffer();
+	bve::util::binary::Reader r(buffer.data(), buffer.size());
+
+	std::vector<float> floats;
+	CHECK_EQ(r.read<std::uint32_t>(), 42U);
+	r.readArray(floats);
+	CHECK_EQ(floats, std::vector<float>{1.0f, 2.0f, 3.0f});
+	CHECK_EQ(r.readString(), "hello"s);
+	CHECK_EQ(r.remaining(), 0U);
+}
+
+TEST_CASE("libutil - binary_io - truncated") {
+	bve::util::binary::Writer w;
+	w.writeString("hello"s);
+
+	auto const& buffer = w.buffer();
+	bve::util::binary::Reader r(buffer.data(), buffer.size() - 1);
+
+	CHECK_THROWS_AS(r.readString(), std::out_of_range);
+}
+
+TEST_CASE("libutil - binary_io - corrupted") {
+	bve::util::binary::Writer w;
+	w.write<std::uint64_t>(std::uint64_t(1) << 60U);
+	w.write<std::uint64_t>(2);
+	w.write(true);
+	w.write(false);
+	w.write<std::uint8_t>(2);
+
+	auto const& buffer = w.buffer();
+	bve::util::binary::Reader r(buffer.data(), buffer.size());
+
+	// a count that can't fit in what is left
+	CHECK_THROWS_AS(r.readCount(1), std::out_of_range);
+	// 3 bytes are left after the second count, enough for 2 elements of 1 byte but not of 2
+	bve::util::binary::Reader counts(buffer.data() + 8, buffer.size() - 8);
+	CHECK_THROWS_AS(counts.readCount(2), std::out_of_range);
+
+	CHECK_EQ(r.readCount(1), 2U);
+	CHECK(r.readBool());
+	CHECK_FALSE(r.readBool());
+	CHECK_THROWS_AS(r.readBool(), std::out_of_range);
+}
+
+TEST_CASE("libutil - binary_io - concurrent saves") {
+	auto const filename = "binary_io_concurrent.bin"s;
+	constexpr std::size_t thread_count = 8;
+	constexpr std::size_t saves = 16;
+	constexpr std::size_t size = 64 * 1024;
+
+	std::atomic<std::size_t> failed_saves{0};
+	std::atomic<std::size_t> torn_reads{0};
+	std::atomic<bool> writing{true};
+
+	// every writer fills the file with its own byte, so a mix of bytes means a reader saw a partial or interleaved write
+	auto const intact = [&](std::string const& contents) {
+		return contents.empty() || (contents.size() == size && contents.find_first_not_of(contents[0]) == std::string::npos);
+	};
+	auto const read_file = [&] {
+		std::ifstream file(filename, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), {});
+	};
+
+	std::vector<std::thread> threads;
+	for (std::size_t i = 0; i < thread_count; ++i) {
+		threads.emplace_back([&, i] {
+			bve::util::binary::Writer w;
+			w.writeBytes(std::string(size, static_cast<char>('a' + i)).data(), size);
+			for (std::size_t save = 0; save < saves; ++save) {
+				if (!w.saveToFile(filename)) {
+					++failed_saves;
+				}
+			}
+		});
+	}
+	std::thread reader([&] {
+		while (writing) {
+			if (!intact(read_file())) {
+				++torn_reads;
+			}
+		}
+	});
+
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	writing = false;
+	reader.join();
+
+	auto const contents = read_file();
+	std::remove(filename.c_str());
+
+	CHECK_EQ(failed_saves, 0);
+	CHECK_EQ(torn_reads, 0);
+	CHECK_EQ(contents.size(), size);
+	CHECK(intact(contents));
+}
+
+TEST_SUITE_END();
@@ -0,0 +1,35 @@
+#include "util/string_interner.hpp"
+#include <doctest/doctest.h>
+#include <ostream>
+
+using namespace std::string_literals;
+
+TEST_SUITE_BEGIN("libutil - string_interner");
+
+TEST_CASE("libutil - string_interner - dense ids") {
+	bve::util::StringInterner interner;
+
+	auto const a = interner.insert("a.csv"s);
+	auto const b = interner.insert("b.csv"s);
+	auto const a2 = interner.insert("a.csv"s);
+
+	CHECK_EQ(a, 0U);
+	CHECK_EQ(b, 1U);
+	CHECK_EQ(a2, a);
+	CHECK_EQ(interner.size(), 2U);
+	CHECK_EQ(interner[a], "a.csv"s);
+	CHECK_EQ(interner[b], "b.csv"s);
+	CHECK_EQ(interner.strings(), std::vector<std::string>{"a.csv"s, "b.csv"s});
+}
+
+TEST_CASE("libutil - string_interner - find") {
+	bve::util::StringInterner interner;
+
+	interner.insert("a.csv"s);
+
+	CHECK_EQ(interner.find("a.csv"s), 0U);
+	CHECK_EQ(interner.find("b.csv"s), bve::util::StringInterner::invalid_id);
+	CHECK_EQ(interner.size(), 1U);
+}
+
+TEST_SUITE_END();
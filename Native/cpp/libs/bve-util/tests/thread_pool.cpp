@@ -0,0 +1,53 @@
+#include "util/thread_pool.hpp"
+#include <atomic>
+#include <doctest/doctest.h>
+#include <stdexcept>
+
+TEST_SUITE_BEGIN("libutil - thread_pool");
+
+TEST_CASE("libutil - thread_pool - parallel_for visits every index once") {
+	bve::util::ThreadPool pool(4);
+
+	std::vector<std::atomic<int>> visits(1000);
+	bve::util::parallel_for(pool, visits.size(), [&visits](std::size_t const i) { visits[i].fetch_add(1); });
+
+	for (auto const& visit : visits) {
+		CHECK_EQ(visit.load(), 1);
+	}
+}
+
+TEST_CASE("libutil - thread_pool - tasks submitting tasks") {
+	bve::util::ThreadPool pool(3);
+
+	std::atomic<int> count{0};
+	for (int i = 0; i < 10; ++i) {
+		pool.submit([&pool, &count] {
+			for (int j = 0; j < 10; ++j) {
+				pool.submit([&count] { count.fetch_add(1); });
+			}
+		});
+	}
+	pool.wait();
+
+	CHECK_EQ(count.load(), 100);
+}
+
+TEST_CASE("libutil - thread_pool - exceptions reach wait") {
+	bve::util::ThreadPool pool(2);
+
+	std::atomic<int> count{0};
+	pool.submit([] { throw std::runtime_error("task failed"); });
+	for (int i = 0; i < 10; ++i) {
+		pool.submit([&count] { count.fetch_add(1); });
+	}
+
+	CHECK_THROWS_AS(pool.wait(), std::runtime_error);
+	CHECK_EQ(count.load(), 10);
+
+	// the exception is only reported once
+	pool.submit([&count] { count.fetch_add(1); });
+	CHECK_NOTHROW(pool.wait());
+	CHECK_EQ(count.load(), 11);
+}
+
+TEST_SUITE_END();
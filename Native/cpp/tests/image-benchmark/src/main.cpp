@@ -0,0 +1,318 @@
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include <CLI/CLI.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <core/image/loader.hpp>
+#include <core/image/mipmaps.hpp>
+#include <core/image/probe.hpp>
+#include <cppfs/FileHandle.h>
+#include <cppfs/FilePath.h>
+#include <cppfs/fs.h>
+#include <cstdint>
+#include <foundational/util/platform.hpp>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <util/thread_pool.hpp>
+#include <vector>
+
+#if defined(FOUNDATIONAL_WINDOWS)
+#	define WIN32_LEAN_AND_MEAN
+#	include <Windows.h>
+// Windows.h has to come first
+#	include <Psapi.h>
+#else
+#	include <sys/resource.h>
+#endif
+
+namespace image = bve::core::image;
+
+namespace {
+	struct Result {
+		std::string file;
+		std::string format;
+		std::string operation;
+		glm::ivec2 dimensions;
+		std::size_t iterations;
+		// fastest iteration, which is the least disturbed by everything else running on the machine
+		double best_seconds;
+		double median_seconds;
+
+		double megapixels_per_second() const {
+			return static_cast<double>(dimensions.x) * static_cast<double>(dimensions.y) / best_seconds / 1'000'000.0;
+		}
+	};
+
+	// Highest resident set size of the process so far
+	std::size_t peak_rss() {
+#if defined(FOUNDATIONAL_WINDOWS)
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) == 0) {
+			return 0;
+		}
+		return counters.PeakWorkingSetSize;
+#else
+		rusage usage{};
+		if (getrusage(RUSAGE_SELF, &usage) != 0) {
+			return 0;
+		}
+#	if defined(__APPLE__)
+		return static_cast<std::size_t>(usage.ru_maxrss);
+#	else
+		// kilobytes on linux
+		return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#	endif
+#endif
+	}
+
+	/**
+	 * Something shaped like a route texture: smooth gradients with detail on top, hard edged shapes and a screendoor colored
+	 * background, so the encoders neither compress it to nothing nor hit their worst case.
+	 */
+	std::vector<std::uint8_t> generate_pixels(glm::ivec2 const dimensions) {
+		std::vector<std::uint8_t> pixels(std::size_t(dimensions.x) * std::size_t(dimensions.y) * 4);
+		std::uint32_t noise = 0x2545F491u;
+		for (int y = 0; y < dimensions.y; ++y) {
+			for (int x = 0; x < dimensions.x; ++x) {
+				noise ^= noise << 13u;
+				noise ^= noise >> 17u;
+				noise ^= noise << 5u;
+				auto const detail = static_cast<int>(noise % 24);
+
+				std::uint8_t* const pixel = &pixels[4 * (std::size_t(y) * std::size_t(dimensions.x) + std::size_t(x))];
+				bool const background = ((x / 64) + (y / 64)) % 5 == 0;
+				if (background) {
+					pixel[0] = 0;
+					pixel[1] = 0;
+					pixel[2] = 255;
+				}
+				else {
+					pixel[0] = static_cast<std::uint8_t>(std::min(255, x * 200 / dimensions.x + detail));
+					pixel[1] = static_cast<std::uint8_t>(std::min(255, y * 200 / dimensions.y + detail));
+					pixel[2] = static_cast<std::uint8_t>(std::min(255, ((x ^ y) & 0x3F) + detail));
+				}
+				pixel[3] = 255;
+			}
+		}
+		return pixels;
+	}
+
+	// Write the test image in every format. Returns the paths written.
+	std::vector<std::string> write_images(std::string const& directory, glm::ivec2 const dimensions, int const jpeg_quality) {
+		auto const pixels = generate_pixels(dimensions);
+		std::string const base = directory + "/" + std::to_string(dimensions.x) + "x" + std::to_string(dimensions.y);
+
+		std::vector<std::string> files{base + ".bmp", base + ".png", base + ".jpg"};
+		bool const written =
+		    stbi_write_bmp(files[0].c_str(), dimensions.x, dimensions.y, 4, pixels.data()) != 0
+		    && stbi_write_png(files[1].c_str(), dimensions.x, dimensions.y, 4, pixels.data(), dimensions.x * 4) != 0
+		    && stbi_write_jpg(files[2].c_str(), dimensions.x, dimensions.y, 4, pixels.data(), jpeg_quality) != 0;
+		if (!written) {
+			throw std::runtime_error("Couldn't write benchmark images to " + directory);
+		}
+		return files;
+	}
+
+	class Benchmark {
+	  public:
+		Benchmark(std::size_t const iterations, std::size_t const threads) : iterations_(iterations), pool_(threads) {}
+
+		void run(std::string const& file) {
+			auto const info = image::probe_image(file);
+			if (!info.valid()) {
+				std::cerr << "Skipping " << file << ", not an image\n";
+				return;
+			}
+
+			// the usual blue screendoor and a light tint, as a route would apply them
+			std::uint8_t const door_r = 0;
+			std::uint8_t const door_g = 0;
+			std::uint8_t const door_b = 255;
+			std::array<std::uint8_t, 4> const tint{255, 230, 200, 255};
+			auto const pipeline =
+			    image::PixelPipeline().screendoor(door_r, door_g, door_b).multiply(tint[0], tint[1], tint[2], tint[3]);
+
+			measure(file, info, "decode rgba32f", {}, [&] { image::Loader(file).valid(); });
+			measure(file, info, "decode rgba8", {}, [&] { image::Loader(file, image::PixelFormat::rgba8).valid(); });
+			measure(file, info, "decode fused rgba32f", {}, [&] { image::Loader(file, pipeline).valid(); });
+
+			// The operations run on a fresh decode each iteration, which isn't timed, so they always see the same pixels
+			std::unique_ptr<image::Loader> loaded;
+			auto const reload = [&](image::PixelFormat const format) {
+				return [&loaded, &file, format] {
+					loaded.reset();
+					loaded = std::make_unique<image::Loader>(file, format);
+				};
+			};
+
+			auto const screendoor = [&] { loaded->applyScreendoor(door_r, door_g, door_b); };
+			auto const multiply = [&] { loaded->multiply(tint[0], tint[1], tint[2], tint[3]); };
+			measure(file, info, "screendoor rgba32f", reload(image::PixelFormat::rgba32f), screendoor);
+			measure(file, info, "screendoor rgba8", reload(image::PixelFormat::rgba8), screendoor);
+			measure(file, info, "multiply rgba32f", reload(image::PixelFormat::rgba32f), multiply);
+			measure(file, info, "multiply rgba8", reload(image::PixelFormat::rgba8), multiply);
+
+			image::Loader const base(file, image::PixelFormat::rgba8);
+			image::Loader const base_hdr(file);
+			measure(file, info, "mips rgba32f", {}, [&] { image::generate_mips(base_hdr.data(), base_hdr.dimensions()); });
+			measure(file, info, "mips rgba8", {}, [&] { image::generate_mips(base.dataRGBA8(), base.dimensions()); });
+			measure(file, info, "mips rgba8 threaded", {}, [&] {
+				image::generate_mips(base.dataRGBA8(), base.dimensions(), image::MipOptions{false, &pool_});
+			});
+		}
+
+		std::vector<Result> const& results() const noexcept {
+			return results_;
+		}
+
+	  private:
+		void measure(std::string const& file,
+		             image::ImageInfo const& info,
+		             std::string operation,
+		             std::function<void()> const& setup,
+		             std::function<void()> const& func) {
+			std::vector<double> times;
+			times.reserve(iterations_);
+			for (std::size_t i = 0; i < iterations_; ++i) {
+				if (setup) {
+					setup();
+				}
+				auto const start = std::chrono::steady_clock::now();
+				func();
+				auto const end = std::chrono::steady_clock::now();
+				times.emplace_back(std::chrono::duration<double>(end - start).count());
+			}
+			std::sort(times.begin(), times.end());
+
+			cppfs::FilePath const path(file);
+			std::string format = path.extension();
+			if (!format.empty() && format.front() == '.') {
+				format.erase(0, 1);
+			}
+			results_.emplace_back(Result{path.fileName(), std::move(format), std::move(operation), info.dimensions, iterations_,
+			                             times.front(), times[times.size() / 2]});
+		}
+
+		std::size_t iterations_;
+		std::vector<Result> results_;
+		bve::util::ThreadPool pool_;
+	};
+
+	std::string json_string(std::string const& value) {
+		std::string escaped = "\"";
+		for (char const c : value) {
+			if (c == '"' || c == '\\') {
+				escaped += '\\';
+			}
+			escaped += c;
+		}
+		return escaped + "\"";
+	}
+
+	void write_json(std::ostream& out, std::vector<Result> const& results) {
+		out << std::setprecision(6) << "{\n  \"peak_rss_bytes\": " << peak_rss() << ",\n  \"results\": [";
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			auto const& result = results[i];
+			out << (i == 0 ? "\n" : ",\n")                                                  //
+			    << "    {\"file\": " << json_string(result.file)                           //
+			    << ", \"format\": " << json_string(result.format)                          //
+			    << ", \"operation\": " << json_string(result.operation)                    //
+			    << ", \"width\": " << result.dimensions.x                                  //
+			    << ", \"height\": " << result.dimensions.y                                 //
+			    << ", \"iterations\": " << result.iterations                               //
+			    << ", \"best_seconds\": " << result.best_seconds                           //
+			    << ", \"median_seconds\": " << result.median_seconds                       //
+			    << ", \"megapixels_per_second\": " << result.megapixels_per_second() << "}";
+		}
+		out << "\n  ]\n}\n";
+	}
+
+	void write_table(std::ostream& out, std::vector<Result> const& results) {
+		out << std::left << std::setw(20) << "file" << std::setw(24) << "operation" << std::right << std::setw(12) << "MP/s"
+		    << std::setw(14) << "median ms" << "\n";
+		for (auto const& result : results) {
+			out << std::left << std::setw(20) << result.file << std::setw(24) << result.operation << std::right << std::fixed
+			    << std::setprecision(1) << std::setw(12) << result.megapixels_per_second() << std::setprecision(3) << std::setw(14)
+			    << result.median_seconds * 1000.0 << "\n";
+		}
+		// A high water mark for the whole process, so only meaningful for the run as a whole
+		out << "\npeak RSS: " << std::setprecision(1) << static_cast<double>(peak_rss()) / (1024.0 * 1024.0) << " MiB\n";
+	}
+} // namespace
+
+int main(int argc, char** argv) {
+	CLI::App app("Benchmarks the image decoding and processing in bve-core.");
+
+	std::vector<int> sizes{256, 1024, 2048};
+	app.add_option("-s,--sizes", sizes, "Edge lengths of the generated square BMP, PNG and JPEG images");
+	std::vector<std::string> extra_files;
+	app.add_option("-f,--files", extra_files, "Extra images to benchmark, such as textures from a route");
+	std::size_t iterations = 5;
+	app.add_option("-n,--iterations", iterations, "Times each operation is run on each image");
+	std::size_t threads = 0;
+	app.add_option("-t,--threads", threads, "Threads for the threaded mip generation. 0 uses one per hardware thread");
+	int jpeg_quality = 90;
+	app.add_option("--jpeg-quality", jpeg_quality, "Quality of the generated JPEGs");
+	std::string work_directory = "image-benchmark-data";
+	app.add_option("-w,--work-directory", work_directory, "Where generated images are written, removed afterwards");
+	bool json = false;
+	app.add_flag("--json", json, "Print the results as JSON, for tracking across releases");
+	std::string output;
+	app.add_option("-o,--output", output, "Write the results to this file instead of standard out");
+
+	CLI11_PARSE(app, argc, argv)
+
+	iterations = std::max<std::size_t>(iterations, 1);
+
+	cppfs::FileHandle directory = cppfs::fs::open(work_directory);
+	if (!directory.exists() && !directory.createDirectory()) {
+		std::cerr << "Couldn't create work directory " << work_directory << "\n";
+		return 1;
+	}
+
+	std::vector<std::string> generated;
+	for (int const size : sizes) {
+		auto files = write_images(work_directory, {size, size}, jpeg_quality);
+		generated.insert(generated.end(), files.begin(), files.end());
+	}
+
+	Benchmark benchmark(iterations, threads);
+	for (auto const& file : generated) {
+		benchmark.run(file);
+	}
+	for (auto const& file : extra_files) {
+		benchmark.run(file);
+	}
+
+	for (auto const& file : generated) {
+		cppfs::fs::open(file).remove();
+	}
+	directory.removeDirectory();
+
+	std::ostringstream report;
+	if (json) {
+		write_json(report, benchmark.results());
+	}
+	else {
+		write_table(report, benchmark.results());
+	}
+
+	if (output.empty()) {
+		std::cout << report.str();
+	}
+	else {
+		std::unique_ptr<std::ostream> const stream = cppfs::fs::open(output).createOutputStream();
+		if (!stream) {
+			std::cerr << "Couldn't write " << output << "\n";
+			return 1;
+		}
+		*stream << report.str();
+	}
+}